@@ -10,11 +10,783 @@
 #include <Edf.h>
 #endif
 
+// system include files
+//
+#include <sys/uio.h>
+#include <unistd.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// MplpcTrace: a lightweight tracer for profiling the analysis.
+//
+// Code marks a stage with MPLPC_TRACE_SCOPE("name"), which records a
+// span from that point to the end of the enclosing block. A sequence of
+// stages in one block can instead be timed with MPLPC_TRACE_START(t)
+// followed by MPLPC_TRACE_LAP(t, "name") at the end of each stage,
+// which records the span since the previous lap. Spans go into
+// a buffer owned by the calling thread, so recording takes no locks.
+// write() exports every thread's spans as a Chrome trace-event file
+// (load it in chrome://tracing or Perfetto).
+//
+// The macro only does something when the code is compiled with
+// -DMPLPC_TRACE (make TRACE=1). Otherwise it compiles to nothing, and
+// write() produces an empty trace.
+//
+class MplpcTrace {
+public:
+
+  // method: enabled
+  //
+  static bool enabled() {
+#ifdef MPLPC_TRACE
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // tracing methods (mplpc_07)
+  //
+  static long long now();
+  static void record(const char* name, long long beg, long long end);
+  static void clear();
+  static bool write(const char* fname);
+};
+
+#ifdef MPLPC_TRACE
+
+// MplpcTraceScope: records a span for the lifetime of the object.
+//
+class MplpcTraceScope {
+public:
+
+  const char* name_d;                   // span name (a string literal)
+  long long beg_d;                      // start time (ns)
+
+  MplpcTraceScope(const char* name_a) {
+    name_d = name_a;
+    beg_d = MplpcTrace::now();
+  }
+
+  ~MplpcTraceScope() {
+    MplpcTrace::record(name_d, beg_d, MplpcTrace::now());
+  }
+};
+
+#define MPLPC_TRACE_CAT2(a, b) a##b
+#define MPLPC_TRACE_CAT(a, b) MPLPC_TRACE_CAT2(a, b)
+#define MPLPC_TRACE_SCOPE(name)						\
+  MplpcTraceScope MPLPC_TRACE_CAT(mplpc_trace_, __LINE__)(name)
+#define MPLPC_TRACE_START(t)						\
+  long long t = MplpcTrace::now()
+#define MPLPC_TRACE_LAP(t, name)					\
+  do {									\
+    long long mplpc_trace_end = MplpcTrace::now();			\
+    MplpcTrace::record(name, t, mplpc_trace_end);			\
+    t = mplpc_trace_end;						\
+  } while (0)
+
+#else
+
+#define MPLPC_TRACE_SCOPE(name)
+#define MPLPC_TRACE_START(t)
+#define MPLPC_TRACE_LAP(t, name)
+
+#endif
+
+// MplpcProfile: time spent in each stage of the analysis of a file.
+//
+// Unlike tracing, profiling is switched on at run time (see
+// Mplpc::set_profile). When it is on, each stage adds its elapsed time
+// to a profile: the frame stages go to the profile of the worker's
+// workspace, so threads never share one, and Mplpc::compute merges them
+// at the end of a file. Stage times from parallel workers add up, so
+// the stage total can exceed the wall time.
+//
+class MplpcProfile {
+public:
+
+  // the stages that are timed
+  //
+  enum STAGE {READ = 0, SELECT, MONTAGE, PREEMPH, WINDOW, AUTOCOR, LPC,
+	      IMPRES, SEARCH, WRITE, NUM_STAGES};
+  static const char* STAGE_NAMES[NUM_STAGES];
+
+  double secs_d[NUM_STAGES];            // time spent in each stage
+  double wall_d;                        // elapsed time
+  long nsamps_d;                        // samples analyzed (all channels)
+  long nchans_d;                        // channels analyzed
+  long nframes_d;                       // frames analyzed (all channels)
+
+  // method: default constructor
+  //
+  MplpcProfile() {
+    clear();
+  }
+
+  // method: clear
+  //
+  void clear() {
+    for (long i = 0; i < NUM_STAGES; i++) {
+      secs_d[i] = 0.0;
+    }
+    wall_d = 0.0;
+    nsamps_d = 0;
+    nchans_d = 0;
+    nframes_d = 0;
+  }
+
+  // method: add
+  //
+  void add(const MplpcProfile& arg_a) {
+    for (long i = 0; i < NUM_STAGES; i++) {
+      secs_d[i] += arg_a.secs_d[i];
+    }
+    wall_d += arg_a.wall_d;
+    nsamps_d += arg_a.nsamps_d;
+    nchans_d += arg_a.nchans_d;
+    nframes_d += arg_a.nframes_d;
+  }
+
+  // method: lap
+  //
+  // charges the time since t to a stage and resets t to the current time
+  //
+  void lap(long stage_a, long long& t_a) {
+    long long now = MplpcTrace::now();
+    secs_d[stage_a] += (now - t_a) * 1.0e-9;
+    t_a = now;
+  }
+
+  // reporting methods (mplpc_07)
+  //
+  double get_channel_secs() const;
+  bool print(FILE* fp, const char* title) const;
+  bool write_json(FILE* fp, const char* name, const char* indent) const;
+};
+
+// MplpcPulses: a compact store for the pulses found in one channel.
+//
+// Only num_pulses per frame are ever non-zero, so rather than a dense
+// per-sample signal, the analysis produces flat arrays of pulse
+// locations, gains and frame indices in the order the pulses were found.
+// A dense signal is built only when an output format needs one, by adding
+// each gain at its location (two pulses can land on the same sample).
+// Gains are kept as doubles, so those of the double precision policy
+// reach the output at full width.
+//
+class MplpcPulses {
+public:
+
+  long nsamps_d;                        // length of the analyzed signal
+  std::vector<long> loc_d;              // pulse locations in samples
+  std::vector<double> gain_d;           // pulse gains
+  std::vector<long> frame_d;            // frame each pulse was found in
+
+  // method: default constructor
+  //
+  MplpcPulses() {
+    nsamps_d = 0;
+  }
+
+  // method: clear
+  //
+  void clear(long nsamps_a = 0) {
+    nsamps_d = nsamps_a;
+    loc_d.clear();
+    gain_d.clear();
+    frame_d.clear();
+  }
+
+  // method: reserve
+  //
+  void reserve(long num_pulses_a) {
+    loc_d.reserve(num_pulses_a);
+    gain_d.reserve(num_pulses_a);
+    frame_d.reserve(num_pulses_a);
+  }
+
+  // method: add
+  //
+  void add(long loc_a, double gain_a, long frame_a) {
+    loc_d.push_back(loc_a);
+    gain_d.push_back(gain_a);
+    frame_d.push_back(frame_a);
+  }
+
+  // method: append
+  //
+  // adds the pulses of arg after those already stored
+  //
+  void append(const MplpcPulses& arg_a) {
+    loc_d.insert(loc_d.end(), arg_a.loc_d.begin(), arg_a.loc_d.end());
+    gain_d.insert(gain_d.end(), arg_a.gain_d.begin(), arg_a.gain_d.end());
+    frame_d.insert(frame_d.end(), arg_a.frame_d.begin(),
+		   arg_a.frame_d.end());
+  }
+
+  // method: size
+  //
+  long size() const {
+    return (long)loc_d.size();
+  }
+};
+
+// a multichannel pulse store
+//
+typedef std::vector<MplpcPulses> VMplpcPulses;
+
+// MplpcVerify: the result of checking a fast engine against the
+// reference implementation (see Mplpc::verify).
+//
+// Frames are analyzed independently, so the pulses of the two engines
+// are compared frame by frame: a frame matches when it has the same
+// number of pulses at the same locations, in the same order, and every
+// gain is within the tolerance. A gain is within the tolerance when it
+// is at most ulps_d units in the last place (of a float) from the
+// reference gain, or when their relative difference is at most rtol_d.
+// The first frame that doesn't match is kept, from both engines, so it
+// can be shown with its context.
+//
+class MplpcVerify {
+public:
+
+  // tolerances
+  //
+  long ulps_d;                          // gain tolerance in float ulps
+  double rtol_d;                        // relative gain tolerance
+
+  // a description of the engine being verified
+  //
+  std::string engine_d;
+
+  // totals over all the channels compared
+  //
+  long nchans_d;                        // channels compared
+  long nframes_d;                       // frames compared
+  long npulses_d;                       // reference pulses compared
+  long nbad_d;                          // frames that don't match
+  long max_ulps_d;                      // largest gain error (ulps)
+  double max_rel_d;                     // largest gain error (relative)
+
+  // the first frame that doesn't match
+  //
+  long bad_chan_d;                      // its channel, or -1 if none
+  long bad_frame_d;                     // its index
+  MplpcPulses bad_ref_d;                // its reference pulses
+  MplpcPulses bad_fast_d;               // its pulses from the fast engine
+
+  // method: default constructor
+  //
+  MplpcVerify() {
+    ulps_d = 0;
+    rtol_d = 0.0;
+    clear();
+  }
+
+  // method: clear
+  //
+  // resets the results but not the tolerances
+  //
+  void clear() {
+    engine_d.clear();
+    nchans_d = 0;
+    nframes_d = 0;
+    npulses_d = 0;
+    nbad_d = 0;
+    max_ulps_d = 0;
+    max_rel_d = 0.0;
+    bad_chan_d = -1;
+    bad_frame_d = -1;
+    bad_ref_d.clear();
+    bad_fast_d.clear();
+  }
+
+  // method: passed
+  //
+  bool passed() const {
+    return (nbad_d == 0);
+  }
+
+  // comparison and reporting methods (mplpc_08)
+  //
+  bool compare(const VMplpcPulses& ref, const VMplpcPulses& fast);
+  bool compare(const MplpcPulses& ref, const MplpcPulses& fast, long chan);
+  bool print(FILE* fp, const char* title) const;
+};
+
+// MplpcPrecision: a precision policy for the analysis.
+//
+// The signal path, from the preemphasized signal through the frame
+// kernels and the pulse search, is templated on one of these. sample_t
+// is the type the signal and the frame buffers are stored in, and
+// accum_t the type the scalar kernels accumulate in. The precision
+// parameter selects one:
+//
+//  mixed:  double storage, float accumulators - what the analysis has
+//          always computed, and the reference for verification
+//  float:  float throughout - half the memory traffic of mixed and
+//          twice the simd lanes
+//  double: double throughout
+//
+template <class TSAMP, class TACC>
+class MplpcPrecision {
+public:
+  typedef TSAMP sample_t;
+  typedef TACC accum_t;
+};
+
+typedef MplpcPrecision<double, float> MplpcMixed;
+typedef MplpcPrecision<float, float> MplpcFloat;
+typedef MplpcPrecision<double, double> MplpcDouble;
+
+// MplpcState: the analysis state of one channel that is carried from
+// one block of samples to the next when a signal is processed in pieces
+// (see Mplpc::compute_mplpc_block). The pending samples are kept as
+// they were read: the frames debias and preemphasize what they use.
+//
+class MplpcState {
+public:
+
+  double bias_d;                        // value removed before preemphasis
+  VectorDouble pend_d;                  // window history and samples
+                                        // not yet analyzed
+  long pos_d;                           // start of the next frame in pend_d
+  long frame_d;                         // index of the next frame
+  long nsamps_d;                        // number of samples seen so far
+};
+
+// MplpcBuffers: scratch space for the analysis of one frame, in one
+// sample type.
+//
+// The frame loop needs a handful of small buffers (the windowed signal,
+// the lpc model, the impulse response, the pulse search signal, ...).
+// Rather than allocating them for every frame, each worker thread owns
+// a set and sizes it when it starts on a channel. The storage only
+// grows, so once the first channel has been analyzed the frame loop
+// does not allocate. Each buffer starts on a cache line.
+//
+// Note the pointers are only valid after resize() has been called on
+// this copy of the object.
+//
+template <class T>
+class MplpcBuffers {
+public:
+
+  static const long ALIGN = 64 / sizeof(T); // cache line size in samples
+
+  T* wbuf_d;                            // windowed signal (n_wdur)
+  T* autocor_d;                         // autocorrelation (lp_order + 1)
+  T* rc_d;                              // reflection coefs (lp_order)
+  T* pc_d;                              // predictor coefs (lp_order + 1)
+  T* filt_d;                            // filter memory (lp_order + 1)
+  T* impres_d;                          // impulse response (n_impres)
+  T* hacor_d;                           // its autocorrelation (n_impres)
+  T* tmp_d;                             // search signal (n_fdur + n_impres)
+  T* ccor_d;                            // crosscorrelation (n_fdur)
+
+  // method: default constructor
+  //
+  MplpcBuffers() {
+    wbuf_d = autocor_d = rc_d = pc_d = filt_d = (T*)NULL;
+    impres_d = hacor_d = tmp_d = ccor_d = (T*)NULL;
+  }
+
+  // method: resize
+  //
+  void resize(long lp_order_a, long n_wdur_a, long n_fdur_a,
+	      long n_impres_a) {
+
+    T** bufs[] = {&wbuf_d, &autocor_d, &rc_d, &pc_d, &filt_d,
+		  &impres_d, &hacor_d, &tmp_d, &ccor_d};
+    long lens[] = {n_wdur_a, lp_order_a + 1, lp_order_a, lp_order_a + 1,
+		   lp_order_a + 1, n_impres_a, n_impres_a,
+		   n_fdur_a + n_impres_a, n_fdur_a};
+    long num_bufs = sizeof(lens) / sizeof(lens[0]);
+
+    // round each buffer up to a whole number of cache lines, plus one
+    // line of slack to align the start of the storage
+    //
+    long total = ALIGN;
+    for (long i = 0; i < num_bufs; i++) {
+      total += (lens[i] + ALIGN - 1) / ALIGN * ALIGN;
+    }
+    if ((long)mem_d.size() < total) {
+      mem_d.resize(total);
+    }
+
+    // carve up the storage
+    //
+    uintptr_t base = (uintptr_t)mem_d.data();
+    long line = ALIGN * sizeof(T);
+    T* ptr = (T*)((base + line - 1) / line * line);
+    for (long i = 0; i < num_bufs; i++) {
+      *bufs[i] = ptr;
+      ptr += (lens[i] + ALIGN - 1) / ALIGN * ALIGN;
+    }
+  }
+
+private:
+
+  std::vector<T> mem_d;                 // storage for all the buffers
+};
+
+// MplpcWork: the workspace of one worker thread. The double precision
+// frame buffers are the object itself, so mixed and double precision
+// analyses use them directly; a single precision analysis uses flt_d.
+//
+class MplpcWork : public MplpcBuffers<double> {
+public:
+
+  MplpcBuffers<float> flt_d;            // single precision frame buffers
+  MplpcProfile prof_d;                  // stage times of this worker
+  std::vector<double> lanes_d;          // channel-interleaved storage
+  std::vector<float> lanes_f_d;         // the same, in single precision
+
+  // method: get_buffers
+  //
+  template <class T> MplpcBuffers<T>& get_buffers();
+
+  // method: get_lanes
+  //
+  // returns storage for the channel-interleaved engine, with room for
+  // at least n samples
+  //
+  template <class T> T* get_lanes(long n);
+};
+
+template <>
+inline MplpcBuffers<double>& MplpcWork::get_buffers<double>() {
+  return *this;
+}
+
+template <>
+inline MplpcBuffers<float>& MplpcWork::get_buffers<float>() {
+  return flt_d;
+}
+
+template <>
+inline double* MplpcWork::get_lanes<double>(long n_a) {
+  if ((long)lanes_d.size() < n_a) {
+    lanes_d.resize(n_a);
+  }
+  return lanes_d.data();
+}
+
+template <>
+inline float* MplpcWork::get_lanes<float>(long n_a) {
+  if ((long)lanes_f_d.size() < n_a) {
+    lanes_f_d.resize(n_a);
+  }
+  return lanes_f_d.data();
+}
+
+// a workspace per worker thread
+//
+typedef std::vector<MplpcWork> VMplpcWork;
+
+// MplpcEdfHeader: the parts of an EDF header needed to read the data
+// records of a file directly, a few records at a time.
+//
+class MplpcEdfHeader {
+public:
+
+  long hdr_bytes_d;                     // size of the header in bytes
+  long file_bytes_d;                    // size of the file in bytes
+  long num_recs_d;                      // number of data records
+  double rec_dur_d;                     // duration of a data record (secs)
+  long num_sigs_d;                      // number of signals
+  long rec_samps_d;                     // samples in a data record
+  std::vector<std::string> labels_d;    // signal labels (uppercase)
+  std::vector<long> samps_d;            // samples per record per signal
+  std::vector<long> offs_d;             // offset of a signal in a record
+  std::vector<double> scale_d;          // digital to physical scale
+  std::vector<double> offset_d;         // digital to physical offset
+};
+
+// MplpcInput: a file opened, and possibly read, ahead of its analysis
+// (see Mplpc::open_input and Mplpc::read_file).
+//
+// The file is opened once: the descriptor stays open for the reader,
+// and the header of an EDF file is parsed once and kept here. An EDF
+// file may also be held decoded, after the channel selection and the
+// montage, together with what the analysis needs to know about it.
+// Inputs own their descriptor, so they can be moved but not copied.
+//
+class MplpcInput {
+public:
+
+  std::string fname_d;                  // input filename
+  bool decoded_d;                       // sig_d holds the signals
+  VVectorDouble sig_d;                  // signals after the montage
+  float sample_freq_d;                  // sample frequency of sig_d
+  long num_chan_file_d;                 // number of channels in the file
+  long num_chan_proc_d;                 // number of channels selected
+  MplpcProfile prof_d;                  // time spent reading the file
+  int fd_d;                             // open descriptor, or -1
+  bool is_edf_d;                        // the file is an EDF file
+  bool has_hdr_d;                       // hdr_d holds its parsed header
+  MplpcEdfHeader hdr_d;                 // the EDF header
+
+  // method: default constructor
+  //
+  MplpcInput() {
+    fd_d = -1;
+    clear();
+  }
+
+  // method: move constructor
+  //
+  MplpcInput(MplpcInput&& in_a) {
+    fd_d = -1;
+    *this = std::move(in_a);
+  }
+
+  // method: destructor
+  //
+  ~MplpcInput() {
+    clear();
+  }
+
+  // method: move assignment: the descriptor changes hands
+  //
+  MplpcInput& operator=(MplpcInput&& in_a) {
+    if (this != &in_a) {
+      clear();
+      fname_d.swap(in_a.fname_d);
+      decoded_d = in_a.decoded_d;
+      sig_d.swap(in_a.sig_d);
+      sample_freq_d = in_a.sample_freq_d;
+      num_chan_file_d = in_a.num_chan_file_d;
+      num_chan_proc_d = in_a.num_chan_proc_d;
+      prof_d = in_a.prof_d;
+      std::swap(fd_d, in_a.fd_d);
+      is_edf_d = in_a.is_edf_d;
+      has_hdr_d = in_a.has_hdr_d;
+      std::swap(hdr_d, in_a.hdr_d);
+      in_a.clear();
+    }
+    return *this;
+  }
+
+  // method: close_file: the decoded signal, if any, is kept
+  //
+  void close_file() {
+    if (fd_d >= 0) {
+      ::close(fd_d);
+      fd_d = -1;
+    }
+  }
+
+  // method: clear
+  //
+  void clear() {
+    close_file();
+    is_edf_d = false;
+    has_hdr_d = false;
+    fname_d.clear();
+    decoded_d = false;
+    VVectorDouble().swap(sig_d);
+    sample_freq_d = 0;
+    num_chan_file_d = -1;
+    num_chan_proc_d = -1;
+    prof_d.clear();
+  }
+
+private:
+
+  // inputs can't be copied
+  //
+  MplpcInput(const MplpcInput&);
+  MplpcInput& operator=(const MplpcInput&);
+};
+
+// MplpcWriter: a buffered writer for feature files.
+//
+// Samples are collected in a page-aligned block that is written with a
+// single system call when it fills up, instead of one library call per
+// sample. A caller asks for space at the end of the block with
+// reserve(), stores up to that many samples there and then hands them
+// over with commit(). With direct i/o the file is opened with O_DIRECT
+// so the blocks bypass the page cache; file systems that don't support
+// it fall back to ordinary writes.
+//
+// When the writer is opened with a queue, full blocks are written by a
+// thread of its own and the caller moves on to the next block at once.
+// The queue holds at most that many blocks: once they are all waiting
+// to be written, commit() waits for the thread to finish one, so a
+// slow disk holds back the producer instead of using more memory. An
+// error in the thread is reported by the next commit() or by close().
+//
+class MplpcWriter {
+public:
+
+  // define the size of a block and its alignment
+  //
+  static const long BLOCK_BYTES = 1 << 20;
+  static const long ALIGN_BYTES = 4096;
+
+  MplpcWriter();
+  ~MplpcWriter();
+
+  bool open(const char* fname, bool direct = false, long num_queued = 0);
+  short int* reserve(long& num);
+  bool commit(long num);
+  bool close();
+
+private:
+
+  // the writer owns a file descriptor and buffers, so it is not copied
+  //
+  MplpcWriter(const MplpcWriter&);
+  MplpcWriter& operator=(const MplpcWriter&);
+
+  bool alloc_blocks(long num);
+  bool submit_block();
+  bool write_block(const char* buf, long nbytes);
+  void run_io();
+
+  int fd_d;                             // output file descriptor
+  bool direct_d;                        // the file uses O_DIRECT
+  char* buf_d;                          // block being filled
+  long len_d;                           // bytes in the block
+  std::string fname_d;                  // filename, for messages
+
+  // the i/o thread: queue_d holds full blocks in file order and free_d
+  // the blocks that can be filled
+  //
+  std::vector<char*> blocks_d;          // all the aligned blocks
+  std::vector<char*> free_d;            // blocks not in the queue
+  std::deque<std::pair<char*, long> > queue_d;  // blocks to be written
+  std::thread io_d;                     // writes the queued blocks
+  std::mutex mutex_d;                   // guards the members below
+  std::condition_variable cond_d;       // signals queue changes
+  bool stop_d;                          // no more blocks will come
+  bool io_status_d;                     // no write has failed
+};
+
+// MplpcPool: the worker threads of an Mplpc object (see run_workers).
+//
+// The threads are started the first time they are needed and then wait
+// for the next batch of tasks, so an analysis that runs a batch per
+// block of a stream doesn't create and join threads for every block.
+// The caller takes part as worker 0. Batches must not be nested.
+//
+class MplpcPool {
+public:
+
+  MplpcPool();
+  ~MplpcPool();
+
+  bool run(long num_workers, long num_tasks,
+	   const std::function<bool(long, long)>& task);
+
+private:
+
+  // the pool owns threads, so it is not copied
+  //
+  MplpcPool(const MplpcPool&);
+  MplpcPool& operator=(const MplpcPool&);
+
+  void run_tasks(long worker);
+  void run_thread(long worker, long batch);
+
+  std::vector<std::thread> threads_d;   // workers 1 and up
+  std::mutex mutex_d;                   // guards the members below
+  std::condition_variable start_d;      // signals a new batch
+  std::condition_variable done_d;       // signals the end of a batch
+  const std::function<bool(long, long)>* task_d;  // the batch's task
+  long num_workers_d;                   // workers in the batch
+  long num_tasks_d;                     // tasks in the batch
+  long batch_d;                         // counts the batches
+  long busy_d;                          // threads still in the batch
+  bool stop_d;                          // the threads are to exit
+  std::atomic<long> next_d;             // next unclaimed task
+  std::atomic<bool> status_d;           // no task has failed
+};
+
+// MplpcRing: batched reads for the EDF readers (see read_edf_records).
+//
+// Reads are queued with add() and issued together by wait(), which
+// returns once they are all in. On Linux they are submitted to an
+// io_uring, so a block of records reaches the device as many requests
+// at once instead of one read at a time. The ring is set up with the
+// system calls themselves, so no library is needed. When the kernel
+// has no io_uring, or it is disabled, the reads are made one after
+// another with pread(). A ring is used by one thread at a time.
+//
+class MplpcRing {
+public:
+
+  // define the number of reads in flight at once, and the size long
+  // reads are split into
+  //
+  static const long QUEUE_DEPTH = 32;
+  static const long CHUNK_BYTES = 256 * 1024;
+
+  MplpcRing();
+  ~MplpcRing();
+
+  void add(int fd, void* buf, long nbytes, long off);
+  bool wait();
+
+private:
+
+  // the ring owns a descriptor and mappings, so it is not copied
+  //
+  MplpcRing(const MplpcRing&);
+  MplpcRing& operator=(const MplpcRing&);
+
+  bool setup();
+  void release();
+  void submit(long beg, long num);
+
+  // a queued read: iov_d is the part that is still to be read
+  //
+  struct Read {
+    int fd_d;
+    long off_d;
+    long done_d;
+    struct iovec iov_d;
+  };
+  std::vector<Read> reads_d;            // the reads wait() issues
+
+  bool tried_d;                         // setup() has been called
+  int ring_fd_d;                        // the ring, or -1 for pread()
+  unsigned sq_entries_d;                // size of the submission queue
+  void* sq_ptr_d;                       // submission ring mapping
+  long sq_bytes_d;
+  void* cq_ptr_d;                       // completion ring mapping
+  long cq_bytes_d;
+  void* sqes_d;                         // submission entries mapping
+  long sqes_bytes_d;
+  unsigned* sq_head_d;                  // fields of the mapped rings
+  unsigned* sq_tail_d;
+  unsigned* sq_mask_d;
+  unsigned* sq_array_d;
+  unsigned* cq_head_d;
+  unsigned* cq_tail_d;
+  unsigned* cq_mask_d;
+  void* cqes_d;
+};
+
 // Mplpc: a class that performs multipulse linear predictive coding (MPLPC)
 // analysis.
 //
 class Mplpc {
 
+  // the kernel benchmark (bench_mplpc.cc) drives the private kernels
+  //
+  friend class MplpcBench;
+
   //###########################################################################
   //
   // public constants
@@ -30,6 +802,23 @@ public:
   //
   static const float MAX_VALUE;
 
+  // define the number of frames converted at a time when reading
+  // memory-mapped raw sample files
+  //
+  static const long MMAP_FRAMES = 16;
+
+  // define the largest number of channels the channel-interleaved
+  // engine analyzes in lockstep (see compute_lanes)
+  //
+  static const long MAX_LANES = 16;
+
+  // define a worker index that asks for the frames of a channel to be
+  // split among all the worker threads, and the number of blocks of
+  // frames per thread a split channel is cut into
+  //
+  static const long ALL_WORKERS = -1;
+  static const long SPLIT_BLOCKS = 4;
+
   // define a debug level and verbosity:
   //
   Dbgl debug_level_d;
@@ -58,6 +847,15 @@ protected:
 
   enum FEAT_TYPE {FEAT_EXCIT = 0, FEAT_PC, FEAT_RC,
 		  DEF_FEAT_TYPE = FEAT_EXCIT};
+
+  enum SEARCH_MODE {SRCH_FULL = 0, SRCH_INCR,
+		    DEF_SEARCH_MODE = SRCH_FULL};
+
+  enum SIMD_MODE {SIMD_NONE = 0, SIMD_AUTO, SIMD_SCALAR, SIMD_SSE2,
+		  SIMD_AVX2, SIMD_AVX512, DEF_SIMD_MODE = SIMD_NONE};
+
+  enum PRECISION {PREC_MIXED = 0, PREC_FLOAT, PREC_DOUBLE,
+		  DEF_PRECISION = PREC_MIXED};
   
   //###########################################################################
   //
@@ -77,6 +875,9 @@ protected:
   static const char* DEF_WINDOW_ALIGN_NAME;
   static const char* DEF_DEBIAS_MODE_NAME;
   static const char* DEF_FEAT_TYPE_NAME;
+  static const char* DEF_SEARCH_MODE_NAME;
+  static const char* DEF_SIMD_MODE_NAME;
+  static const char* DEF_PRECISION_NAME;
 
   // frame-related constants
   //
@@ -92,6 +893,21 @@ protected:
   static float DEF_IMPRES_DURATION;
   static long DEF_NUM_PULSES;
 
+  // parallel processing-related parameters
+  //
+  static long DEF_NUM_THREADS;
+  static long DEF_NUM_LANES;
+
+  // streaming-related parameters
+  //
+  static long DEF_STREAM_RECORDS;
+  static long DEF_DIRECT_READ;
+
+  // output-related parameters
+  //
+  static long DEF_OUTPUT_DIRECT;
+  static long DEF_OUTPUT_QUEUE;
+
   
   //###########################################################################
   //
@@ -143,6 +959,26 @@ protected:
   static const char* DEBIAS_MODE_NAME_01;
   static const char* DEBIAS_MODE_NAME_02;  
 
+  // pulse search-related parameters
+  //
+  static const char* SEARCH_MODE_NAME_00;
+  static const char* SEARCH_MODE_NAME_01;
+
+  // simd kernel-related parameters
+  //
+  static const char* SIMD_MODE_NAME_00;
+  static const char* SIMD_MODE_NAME_01;
+  static const char* SIMD_MODE_NAME_02;
+  static const char* SIMD_MODE_NAME_03;
+  static const char* SIMD_MODE_NAME_04;
+  static const char* SIMD_MODE_NAME_05;
+
+  // precision policy-related parameters
+  //
+  static const char* PRECISION_NAME_00;
+  static const char* PRECISION_NAME_01;
+  static const char* PRECISION_NAME_02;
+
   //----------------------------------------
   //
   // section 3: parameters related to feature file generation
@@ -201,6 +1037,9 @@ protected:
   char win_align_str_d[Edf::MAX_SSTR_LENGTH];   // window alignment
   char debias_mode_str_d[Edf::MAX_SSTR_LENGTH]; // debias mode
   char feat_type_str_d[Edf::MAX_SSTR_LENGTH]; // feature type
+  char search_mode_str_d[Edf::MAX_SSTR_LENGTH]; // pulse search mode
+  char simd_mode_str_d[Edf::MAX_SSTR_LENGTH];   // simd kernel mode
+  char precision_str_d[Edf::MAX_SSTR_LENGTH];   // precision policy
 
   //----------------------------------------
   //
@@ -214,6 +1053,8 @@ protected:
   char odir_d[Edf::MAX_LSTR_LENGTH];            // feat file output directory
   char odir_repl_d[Edf::MAX_LSTR_LENGTH];       // feat file replace directory
   char oext_d[Edf::MAX_SSTR_LENGTH];            // feat file output extension
+  long out_direct_d;                            // bypass the page cache
+  long out_queue_d;                             // blocks queued for output
 
   //###########################################################################
   //
@@ -279,6 +1120,32 @@ protected:
   float impres_dur_d;			      // lpc impulse response duration
   long num_pulses_d;                          // number of pulses per frame
   FEAT_TYPE feat_type_d;                      // type of features to generate
+  SEARCH_MODE search_mode_d;                  // pulse search mode
+
+  // define the simd kernels: simd_isa_d is the instruction set actually
+  // in use after an automatic mode has been resolved
+  //
+  SIMD_MODE simd_mode_d;                      // requested simd mode
+  SIMD_MODE simd_isa_d;                       // selected instruction set
+  double (*kern_dot_d)(const double* x, const double* y, long n);
+  void (*kern_mul_d)(double* z, const double* x, const double* y, long n);
+  float (*kern_dot_f)(const float* x, const float* y, long n);
+  void (*kern_mul_f)(float* z, const float* x, const float* y, long n);
+  void (*kern_clip_d)(short int* z, const double* x, long n);
+
+  // define the precision policy of the signal path
+  //
+  PRECISION precision_d;                      // precision policy
+
+  // define parallel processing parameters
+  //
+  long num_threads_d;                         // channel worker threads
+  long num_lanes_d;                           // channels per simd group
+
+  // define streaming parameters
+  //
+  long stream_recs_d;                         // edf records per block
+  long direct_read_d;                         // read edf data records
   
   // editedV
   // variables for fft plotting (for method stolen from Fe class)
@@ -305,9 +1172,32 @@ protected:
   //
   //----------------------------------------
 
-  // define a vector for the window function
+  // define a vector for the window function, and a single precision
+  // copy of it for the float policy
   //
   VectorDouble win_fct_d;
+  std::vector<float> win_fct_f_d;
+
+  // define the frame workspaces: one per worker thread, kept across
+  // channels and files (see run_workers)
+  //
+  VMplpcWork work_d;
+  MplpcPool pool_d;
+
+  // define the batched reader of the EDF data records
+  //
+  MplpcRing ring_d;
+
+  // define the profile of the last file processed: the frame stages
+  // are collected in the workspaces and merged in at the end
+  //
+  bool profile_d;
+  MplpcProfile prof_d;
+
+  // define the consumer of finished channels (see channels_done): it is
+  // only set while compute() streams a file to its output
+  //
+  std::function<bool(long, long)> chans_done_d;
 
   //###########################################################################
   //
@@ -356,17 +1246,73 @@ public:
     return true;
   }
 
+  // parameter file methods (mplpc_01)
+  //
+  bool set_num_threads(long arg) {
+    num_threads_d = (arg < 1) ? 1 : arg;
+    return true;
+  }
+
+  // profiling methods: the profile covers the last call to compute()
+  //
+  bool set_profile(bool arg) {
+    profile_d = arg;
+    return true;
+  }
+  const MplpcProfile& get_profile() const {
+    return prof_d;
+  }
+
   // computational methods (mplpc_02)
   //
   bool compute(char* oname, char* iname);
-  bool compute_00(VVVectorDouble& isig, char* iname);
+  bool compute_file(VMplpcPulses& osig, char* iname);
+  bool compute_file(VMplpcPulses& osig, MplpcInput& in);
+  bool compute_00(VMplpcPulses& osig, MplpcInput& in);
+
+  // the stages of compute() on their own, so a driver can read, analyze
+  // and write different files at the same time: each stage needs its
+  // own object
+  //
+  bool read_file(MplpcInput& in, char* iname);
+  bool compute_input(VMplpcPulses& osig, MplpcInput& in);
+  bool write_file(char* oname, char* iname, VMplpcPulses& sig);
 
   // might need to revise
   //
-  bool compute_00_edf(VVVectorDouble& isig, char* iname);
+  bool compute_00_edf(VMplpcPulses& osig, char* iname);
+  bool compute_00_edf(VMplpcPulses& osig, MplpcInput& in);
+  bool read_edf_input(MplpcInput& in);
+  bool compute_00_edf_stream(VMplpcPulses& osig, MplpcInput& in);
 
+  bool compute_mplpc(VMplpcPulses& osig, const VVectorDouble& isig);
+  bool compute_mplpc(MplpcPulses& osig, const VectorDouble& isig,
+		     long worker = 0);
+
+  // dense versions of the above: these expand the pulses into a
+  // per-sample signal
+  //
   bool compute_mplpc(VVVectorDouble& osig, VVectorDouble& isig);
   bool compute_mplpc(VVectorDouble& osig, VectorDouble& isig);
+  bool expand_pulses(VVVectorDouble& osig, VMplpcPulses& isig);
+  bool expand_pulses(VVectorDouble& osig, MplpcPulses& isig);
+  bool expand_pulses(VectorDouble& osig, MplpcPulses& isig);
+
+  // block-by-block versions of the single channel analysis: these
+  // give the same pulses as compute_mplpc on the concatenated blocks
+  //
+  bool compute_mplpc_open(MplpcState& state, MplpcPulses& osig,
+			  double bias = 0.0);
+  bool compute_mplpc_block(MplpcState& state, MplpcPulses& osig,
+			   const VectorDouble& isig, long worker = 0);
+  bool compute_mplpc_close(MplpcState& state, MplpcPulses& osig,
+			   long worker = 0);
+
+  // differential verification (mplpc_08): analyzes a file with the
+  // reference implementation and with the configured engine and
+  // compares the results
+  //
+  bool verify(MplpcVerify& result, char* iname);
 
 
 
@@ -419,6 +1365,7 @@ private:
   //
   short int clip_value(float value);
   bool create_window();
+  double compute_mean(const VectorDouble& sig);
   double debias(VectorDouble& sig);
   bool compute_autocor(VectorDouble& autocor, VectorDouble& sig,
 		       long lp_order);
@@ -428,11 +1375,144 @@ private:
 			VectorDouble& pc, long idx, long n_fdur);
   bool compute_impulse_response(VectorDouble& h, VectorDouble& pc,
 				long num_samples);
+  bool compute_crosscor(VectorDouble& crosscor, VectorDouble& sig,
+			VectorDouble& h, long num_lags);
+
+  // versions of the above on preallocated buffers, templated on the
+  // precision policy (see MplpcPrecision)
+  //
+  template <class P>
+  bool compute_autocor(typename P::sample_t* autocor,
+		       const typename P::sample_t* sig, long n, long lp_order);
+  template <class P>
+  bool accumulate_autocor(typename P::sample_t* acc,
+			  const typename P::sample_t* sig, long j_beg,
+			  long j_end, long lp_order);
+  template <class P>
+  bool compute_lpc(typename P::sample_t* rc, typename P::sample_t* pc,
+		   const typename P::sample_t* autocor, long lp_order);
+  template <class P>
+  bool compute_impulse_response(typename P::sample_t* h,
+				typename P::sample_t* filt,
+				const typename P::sample_t* pc, long flen,
+				long num_samples);
+  template <class P>
+  bool compute_crosscor(typename P::sample_t* crosscor,
+			const typename P::sample_t* sig, long n,
+			const typename P::sample_t* h, long m, long num_lags);
+
+  // the simd kernels for a sample type
+  //
+  double kern_dot(const double* x_a, const double* y_a, long n_a) {
+    return kern_dot_d(x_a, y_a, n_a);
+  }
+  float kern_dot(const float* x_a, const float* y_a, long n_a) {
+    return kern_dot_f(x_a, y_a, n_a);
+  }
+  void kern_mul(double* z_a, const double* x_a, const double* y_a,
+		long n_a) {
+    kern_mul_d(z_a, x_a, y_a, n_a);
+  }
+  void kern_mul(float* z_a, const float* x_a, const float* y_a, long n_a) {
+    kern_mul_f(z_a, x_a, y_a, n_a);
+  }
+  void kern_clip(short int* z_a, const double* x_a, long n_a) {
+    kern_clip_d(z_a, x_a, n_a);
+  }
+
+  // the window function in a sample type
+  //
+  template <class T> const T* get_window() const;
+
+  // frame-level analysis and parallel execution (mplpc_02)
+  //
+  bool check_analysis();
+  MplpcWork* get_work(long worker);
+  MplpcWork* get_split_work(long worker, bool& split);
+  template <class P>
+  bool compute_mplpc(MplpcPulses& osig, const VectorDouble& isig,
+		     MplpcWork& work, bool split);
+  template <class P>
+  bool compute_mplpc_block(MplpcState& state, MplpcPulses& osig,
+			   const VectorDouble& isig, MplpcWork& work,
+			   bool split);
+  template <class P>
+  bool compute_mplpc_close(MplpcState& state, MplpcPulses& osig,
+			   MplpcWork& work);
+  template <class P>
+  bool compute_frames(MplpcWork& work, MplpcPulses& osig,
+		      const double* sig, double bias, long off, long avail,
+		      long frame, long num_frames, bool split);
+  template <class P>
+  bool compute_frame(MplpcWork& work, MplpcPulses& osig, const double* sig,
+		     double bias, long off, long avail, long frame);
+  template <class P>
+  bool compute_pulses(MplpcWork& work, MplpcPulses& osig,
+		      typename P::sample_t* sig_tmp,
+		      typename P::accum_t impres_egy, long frame);
+  template <class P>
+  bool window_frame(typename P::sample_t* wbuf,
+		    typename P::sample_t* autocor, const double* sig,
+		    double bias, long off, long frame);
+  template <class P>
+  void preemphasize(typename P::sample_t* osig, const double* isig,
+		    double bias, long n, bool first,
+		    const typename P::sample_t* win);
+  long window_lookback();
+  bool run_workers(long num_tasks,
+		   const std::function<bool(long, long)>& task);
+
+  // channel-interleaved analysis (mplpc_09)
+  //
+  bool compute_lanes(VMplpcPulses& osig, const VVectorDouble& isig);
+  template <class P>
+  bool compute_lane_group(VMplpcPulses& osig, const VVectorDouble& isig,
+			  long chan, long num_chans, MplpcWork& work);
+
+  // direct and streaming edf input (mplpc_06)
+  //
+  bool open_input(MplpcInput& in, char* iname);
+  bool read_edf_header(MplpcEdfHeader& hdr, int fd);
+  bool read_edf_records(VVectorDouble& sig, MplpcEdfHeader& hdr, int fd,
+			long rec, long num_recs, const std::vector<char>& need);
+  bool read_edf_direct(MplpcInput& in, std::vector<long>& chan_a,
+		       std::vector<long>& chan_b, std::vector<char>& need,
+		       long num_sel);
+  bool resolve_channels(std::vector<long>& chan_a, std::vector<long>& chan_b,
+			long& num_sel, MplpcEdfHeader& hdr);
+  bool resolve_direct(std::vector<long>& chan_a, std::vector<long>& chan_b,
+		      std::vector<char>& need, long& num_sel,
+		      MplpcEdfHeader& hdr);
+  long find_label(MplpcEdfHeader& hdr, std::vector<char>& sel,
+		  const char* name, bool partial);
+
+  // simd kernel selection (mplpc_05)
+  //
+  bool select_kernels();
+
+  // feature file output (mplpc_10): while a file is analyzed,
+  // chans_done_d is told about channels as soon as their pulses are
+  // final, so they can be written while the rest are still analyzed
+  //
+  bool write_channel(MplpcWriter& out, const MplpcPulses& pulses);
+  bool channels_done(long chan, long num_chans);
   
   //
   // end of class
 };
 
+// the window function in each sample type
+//
+template <>
+inline const double* Mplpc::get_window<double>() const {
+  return win_fct_d.data();
+}
+
+template <>
+inline const float* Mplpc::get_window<float>() const {
+  return win_fct_f_d.data();
+}
+
 // end of include file
 //
 #endif
@@ -0,0 +1,624 @@
+// file: bench_mplpc.cc
+//
+// This is a micro-benchmark for the signal processing kernels in
+// mplpc_03.cc (create_window, compute_autocor, compute_lpc,
+// compute_impulse_response, compute_residual), the fused front end of
+// a frame (window_frame) and the step 8 pulse search
+// (compute_pulses). Each kernel is timed in isolation over a grid
+// of lp_order, n_wdur, n_impres and num_pulses on a synthetic signal
+// (three sinewaves plus a little noise, as in the x3_sinewave example).
+//
+// Each measurement runs a warmup, then times a number of repetitions of
+// a batch of calls, the batch being sized so that it takes about a
+// millisecond. It reports the mean, minimum and standard deviation of
+// the time per call (i.e., per frame) and a nominal GFLOP/s based on the
+// arithmetic a straightforward implementation of the kernel does.
+//
+// The frame kernels and the search run in the precision policy given
+// by -precision (mixed, float or double; see MplpcPrecision in Mplpc.h).
+//
+// usage: bench_mplpc [-reps N] [-warmup N] [-simd mode]
+//                    [-precision mode] [-quick]
+//
+
+// system include files
+//
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// local include files
+//
+#include "Mplpc.h"
+
+// MplpcBench: a friend of Mplpc that can drive its private kernels
+//
+class MplpcBench {
+public:
+
+  // define the sample frequency used throughout (as in the examples)
+  //
+  static constexpr float SAMPLE_FREQ = 8000.0;
+
+  // define the target duration of a timed batch in nanoseconds
+  //
+  static constexpr double BATCH_NS = 1.0e6;
+
+  // statistics of the time per call in nanoseconds
+  //
+  class Stats {
+  public:
+    double mean_d;
+    double min_d;
+    double sd_d;
+  };
+
+  // benchmark settings
+  //
+  long reps_d;
+  long warmup_d;
+  char simd_d[Edf::MAX_SSTR_LENGTH];
+  char precision_d[Edf::MAX_SSTR_LENGTH];
+
+  // the grid
+  //
+  std::vector<long> orders_d;
+  std::vector<long> wdurs_d;
+  std::vector<long> fdurs_d;
+  std::vector<long> impres_d;
+  std::vector<long> pulses_d;
+
+  //---------------------------------------------------------------------------
+  //
+  // helper methods
+  //
+  //---------------------------------------------------------------------------
+
+  // method: measure
+  //
+  // arguments:
+  //  F fn: the code to be timed, called with no arguments (input)
+  //
+  // return: statistics of the time per call
+  //
+  // This method runs fn warmup_d times, sizes a batch of calls to take
+  // about BATCH_NS, and then times reps_d batches.
+  //
+  template <class F>
+  Stats measure(F fn) {
+
+    typedef std::chrono::steady_clock Clock;
+
+    // warm up the caches and branch predictors
+    //
+    for (long i = 0; i < warmup_d; i++) {
+      fn();
+    }
+
+    // size the batch
+    //
+    long batch = 1;
+    while (true) {
+      Clock::time_point t0 = Clock::now();
+      for (long i = 0; i < batch; i++) {
+	fn();
+      }
+      double ns = std::chrono::duration<double, std::nano>
+	(Clock::now() - t0).count();
+      if ((ns >= BATCH_NS) || (batch >= (1L << 24))) {
+	break;
+      }
+      batch *= 2;
+    }
+
+    // time the repetitions
+    //
+    std::vector<double> per_call(reps_d);
+    for (long r = 0; r < reps_d; r++) {
+      Clock::time_point t0 = Clock::now();
+      for (long i = 0; i < batch; i++) {
+	fn();
+      }
+      per_call[r] = std::chrono::duration<double, std::nano>
+	(Clock::now() - t0).count() / batch;
+    }
+
+    // compute the statistics
+    //
+    Stats st;
+    double sum = 0.0;
+    double sum2 = 0.0;
+    st.min_d = per_call[0];
+    for (long r = 0; r < reps_d; r++) {
+      sum += per_call[r];
+      sum2 += per_call[r] * per_call[r];
+      st.min_d = std::min(st.min_d, per_call[r]);
+    }
+    st.mean_d = sum / reps_d;
+    st.sd_d = sqrt(std::max(0.0, sum2 / reps_d - st.mean_d * st.mean_d));
+    return st;
+  }
+
+  // method: report
+  //
+  // arguments:
+  //  const char* kernel: kernel name (input)
+  //  const char* params: description of the grid point (input)
+  //  Stats& st: timing statistics (input)
+  //  double flops: nominal floating point operations per call (input)
+  //
+  // return: none
+  //
+  void report(const char* kernel_a, const char* params_a, Stats& st_a,
+	      double flops_a) {
+    fprintf(stdout, "%-12s %-30s %12.1f %12.1f %8.1f", kernel_a, params_a,
+	    st_a.mean_d, st_a.min_d, st_a.sd_d);
+    if (flops_a > 0) {
+      fprintf(stdout, " %8.3f\n", flops_a / st_a.mean_d);
+    }
+    else {
+      fprintf(stdout, " %8s\n", "-");
+    }
+    fflush(stdout);
+  }
+
+  // method: configure
+  //
+  // arguments:
+  //  Mplpc& mplpc: the object to configure (output)
+  //  long lp_order: linear prediction order (input)
+  //  long n_wdur: window duration in samples (input)
+  //  long n_fdur: frame duration in samples (input)
+  //  long n_impres: impulse response duration in samples (input)
+  //  long num_pulses: number of pulses per frame (input)
+  //  const char* search: pulse search mode (input)
+  //
+  // return: a boolean indicating status
+  //
+  // This method sets up an Mplpc object for one grid point, as a
+  // parameter file would, and sizes its first workspace.
+  //
+  bool configure(Mplpc& mplpc_a, long lp_order_a, long n_wdur_a,
+		 long n_fdur_a, long n_impres_a, long num_pulses_a,
+		 const char* search_a) {
+
+    mplpc_a.sample_freq_d = SAMPLE_FREQ;
+    mplpc_a.window_duration_d = n_wdur_a / SAMPLE_FREQ;
+    mplpc_a.frame_duration_d = n_fdur_a / SAMPLE_FREQ;
+    mplpc_a.impres_dur_d = n_impres_a / SAMPLE_FREQ;
+    mplpc_a.lp_order_d = lp_order_a;
+    mplpc_a.num_pulses_d = num_pulses_a;
+    mplpc_a.preemphasis_d = 0.95;
+    strcpy(mplpc_a.win_type_str_d, "hamming");
+    strcpy(mplpc_a.win_norm_str_d, "energy");
+    strcpy(mplpc_a.win_align_str_d, "right");
+    strcpy(mplpc_a.search_mode_str_d, search_a);
+    strcpy(mplpc_a.simd_mode_str_d, simd_d);
+    strcpy(mplpc_a.precision_str_d, precision_d);
+    if (!mplpc_a.convert_to_enums()) {
+      return false;
+    }
+    return mplpc_a.create_window() && (mplpc_a.get_work(0) != NULL);
+  }
+
+  // method: make_signal
+  //
+  // arguments:
+  //  std::vector<T>& sig: the signal (output)
+  //  long nsamps: number of samples (input)
+  //  double preemphasis: preemphasis coefficient (input)
+  //
+  // return: none
+  //
+  // This method generates three sinewaves plus a little noise at the
+  // amplitude of 16-bit audio, and preemphasizes it. window_frame
+  // preemphasizes its input itself, so it is given the raw signal.
+  //
+  template <class T>
+  void make_signal(std::vector<T>& sig_a, long nsamps_a,
+		   double preemphasis_a = 0.95) {
+
+    sig_a.resize(nsamps_a);
+    unsigned long seed = 12345;
+    double pre = 0.0;
+    for (long n = 0; n < nsamps_a; n++) {
+      seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+      double noise = (double)(seed >> 40) / (double)(1UL << 24) - 0.5;
+      double t = n / SAMPLE_FREQ;
+      double x = 8000.0 * sin(2.0 * M_PI * 250.0 * t) +
+	4000.0 * sin(2.0 * M_PI * 1000.0 * t) +
+	2000.0 * sin(2.0 * M_PI * 2500.0 * t) + 200.0 * noise;
+      sig_a[n] = x + preemphasis_a * pre;
+      pre = x;
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  //
+  // benchmarks
+  //
+  //---------------------------------------------------------------------------
+
+  // method: bench_window
+  //
+  bool bench_window(long n_wdur_a) {
+
+    Mplpc mplpc;
+    if (!configure(mplpc, 10, n_wdur_a, n_wdur_a, 1, 1, "full")) {
+      return false;
+    }
+    char params[64];
+    sprintf(params, "N=%ld", n_wdur_a);
+    Stats st = measure([&]() { mplpc.create_window(); });
+    report("window", params, st, 0.0);
+    return true;
+  }
+
+  // method: bench_autocor
+  //
+  template <class P>
+  bool bench_autocor(long lp_order_a, long n_wdur_a) {
+
+    typedef typename P::sample_t T;
+    Mplpc mplpc;
+    if (!configure(mplpc, lp_order_a, n_wdur_a, n_wdur_a, 1, 1, "full")) {
+      return false;
+    }
+    std::vector<T> sig;
+    make_signal(sig, n_wdur_a);
+    MplpcBuffers<T>& work = mplpc.get_work(0)->get_buffers<T>();
+
+    char params[64];
+    sprintf(params, "p=%ld N=%ld", lp_order_a, n_wdur_a);
+    Stats st = measure([&]() {
+      mplpc.compute_autocor<P>(work.autocor_d, sig.data(), n_wdur_a,
+			       lp_order_a);
+    });
+    double flops = 0.0;
+    for (long i = 0; i <= lp_order_a; i++) {
+      flops += 2.0 * (n_wdur_a - i);
+    }
+    report("autocor", params, st, flops);
+    return true;
+  }
+
+  // method: bench_frontend
+  //
+  // The preemphasis, window and autocorrelation of a frame as
+  // compute_frame runs them: in one sweep in the scalar mode, the
+  // window and then compute_autocor otherwise.
+  //
+  template <class P>
+  bool bench_frontend(long lp_order_a, long n_wdur_a) {
+
+    typedef typename P::sample_t T;
+    long n_fdur = n_wdur_a / 2;
+    Mplpc mplpc;
+    if (!configure(mplpc, lp_order_a, n_wdur_a, n_fdur, 1, 1, "full")) {
+      return false;
+    }
+    VectorDouble sig;
+    make_signal(sig, 2 * n_wdur_a, 0.0);
+    MplpcBuffers<T>& work = mplpc.get_work(0)->get_buffers<T>();
+    bool fused = (mplpc.simd_mode_d == Mplpc::SIMD_NONE);
+
+    char params[64];
+    sprintf(params, "p=%ld N=%ld", lp_order_a, n_wdur_a);
+    Stats st = measure([&]() {
+      mplpc.window_frame<P>(work.wbuf_d, fused ? work.autocor_d : (T*)NULL,
+			    sig.data(), 0.0, 2 * n_fdur, 2);
+      if (!fused) {
+	mplpc.compute_autocor<P>(work.autocor_d, work.wbuf_d, n_wdur_a,
+				 lp_order_a);
+      }
+    });
+    double flops = 3.0 * n_wdur_a;
+    for (long i = 0; i <= lp_order_a; i++) {
+      flops += 2.0 * (n_wdur_a - i);
+    }
+    report("frontend", params, st, flops);
+    return true;
+  }
+
+  // method: bench_lpc
+  //
+  template <class P>
+  bool bench_lpc(long lp_order_a) {
+
+    typedef typename P::sample_t T;
+    long n_wdur = 320;
+    Mplpc mplpc;
+    if (!configure(mplpc, lp_order_a, n_wdur, n_wdur, 1, 1, "full")) {
+      return false;
+    }
+    VectorDouble sig;
+    make_signal(sig, n_wdur, 0.0);
+    MplpcBuffers<T>& work = mplpc.get_work(0)->get_buffers<T>();
+    mplpc.window_frame<P>(work.wbuf_d, (T*)NULL, sig.data(), 0.0, 0, 0);
+    mplpc.compute_autocor<P>(work.autocor_d, work.wbuf_d, n_wdur,
+			     lp_order_a);
+
+    char params[64];
+    sprintf(params, "p=%ld", lp_order_a);
+    Stats st = measure([&]() {
+      mplpc.compute_lpc<P>(work.rc_d, work.pc_d, work.autocor_d,
+			   lp_order_a);
+    });
+    double flops = 0.0;
+    for (long i = 1; i <= lp_order_a; i++) {
+      flops += 2.0 * i + 4.0 * (i / 2) + 4.0;
+    }
+    report("lpc", params, st, flops);
+    return true;
+  }
+
+  // method: bench_impres
+  //
+  template <class P>
+  bool bench_impres(long lp_order_a, long n_impres_a) {
+
+    typedef typename P::sample_t T;
+    long n_wdur = 320;
+    Mplpc mplpc;
+    if (!configure(mplpc, lp_order_a, n_wdur, n_wdur, n_impres_a, 1,
+		   "full")) {
+      return false;
+    }
+    VectorDouble sig;
+    make_signal(sig, n_wdur, 0.0);
+    MplpcBuffers<T>& work = mplpc.get_work(0)->get_buffers<T>();
+    mplpc.window_frame<P>(work.wbuf_d, (T*)NULL, sig.data(), 0.0, 0, 0);
+    mplpc.compute_autocor<P>(work.autocor_d, work.wbuf_d, n_wdur,
+			     lp_order_a);
+    mplpc.compute_lpc<P>(work.rc_d, work.pc_d, work.autocor_d, lp_order_a);
+
+    char params[64];
+    sprintf(params, "p=%ld M=%ld", lp_order_a, n_impres_a);
+    Stats st = measure([&]() {
+      mplpc.compute_impulse_response<P>(work.impres_d, work.filt_d,
+					work.pc_d, lp_order_a + 1,
+					n_impres_a);
+    });
+    report("impres", params, st, 2.0 * lp_order_a * (n_impres_a - 1));
+    return true;
+  }
+
+  // method: bench_residual
+  //
+  bool bench_residual(long lp_order_a, long n_fdur_a) {
+
+    long n_wdur = std::max(n_fdur_a, 320L);
+    Mplpc mplpc;
+    if (!configure(mplpc, lp_order_a, n_wdur, n_fdur_a, 1, 1, "full")) {
+      return false;
+    }
+    VectorDouble sig;
+    make_signal(sig, n_wdur + n_fdur_a);
+    VectorDouble res(sig.size());
+    VectorDouble rc;
+    VectorDouble pc;
+    VectorDouble autocor;
+    VectorDouble wsig(n_wdur);
+    mplpc.window_frame<MplpcMixed>(wsig.data(), (double*)NULL, sig.data(),
+				   0.0, 0, 0);
+    mplpc.compute_autocor(autocor, wsig, lp_order_a);
+    mplpc.compute_lpc(rc, pc, autocor, lp_order_a);
+
+    char params[64];
+    sprintf(params, "p=%ld N=%ld", lp_order_a, n_fdur_a);
+    Stats st = measure([&]() {
+      mplpc.compute_residual(res, sig, pc, n_wdur, n_fdur_a);
+    });
+    report("residual", params, st, 2.0 * (pc.size() - 1) * n_fdur_a);
+    return true;
+  }
+
+  // method: bench_search
+  //
+  // The search is timed with the impulse response of a real frame. The
+  // full search modifies its signal, so every call starts from a fresh
+  // copy of it, as compute_frame does.
+  //
+  template <class P>
+  bool bench_search(long lp_order_a, long n_fdur_a, long n_impres_a,
+		    long num_pulses_a, const char* search_a) {
+
+    typedef typename P::sample_t T;
+    long n_wdur = 2 * n_fdur_a;
+    Mplpc mplpc;
+    if (!configure(mplpc, lp_order_a, n_wdur, n_fdur_a, n_impres_a,
+		   num_pulses_a, search_a)) {
+      return false;
+    }
+    std::vector<T> sig;
+    make_signal(sig, n_wdur + n_impres_a);
+    MplpcWork& ws = *mplpc.get_work(0);
+    MplpcBuffers<T>& work = ws.get_buffers<T>();
+    VectorDouble raw;
+    make_signal(raw, n_wdur + n_impres_a, 0.0);
+    mplpc.window_frame<P>(work.wbuf_d, (T*)NULL, raw.data(), 0.0, n_fdur_a,
+			  1);
+    mplpc.compute_autocor<P>(work.autocor_d, work.wbuf_d, n_wdur,
+			     lp_order_a);
+    mplpc.compute_lpc<P>(work.rc_d, work.pc_d, work.autocor_d, lp_order_a);
+    mplpc.compute_impulse_response<P>(work.impres_d, work.filt_d, work.pc_d,
+				      lp_order_a + 1, n_impres_a);
+    typename P::accum_t egy = 0;
+    for (long j = 0; j < n_impres_a; j++) {
+      egy += work.impres_d[j] * work.impres_d[j];
+    }
+
+    long n_tmp = n_fdur_a + n_impres_a;
+    const T* src = sig.data() + n_fdur_a;
+    MplpcPulses pulses;
+    pulses.reserve(num_pulses_a);
+
+    char params[64];
+    sprintf(params, "%s N=%ld M=%ld P=%ld", search_a, n_fdur_a, n_impres_a,
+	    num_pulses_a);
+    Stats st = measure([&]() {
+      std::copy(src, src + n_tmp, work.tmp_d);
+      pulses.clear();
+      mplpc.compute_pulses<P>(ws, pulses, work.tmp_d, egy, 0);
+    });
+
+    // the full search correlates every lag for every pulse; the
+    // incremental search correlates once and then updates the overlap
+    //
+    double flops;
+    if (strcmp(search_a, "incremental") == 0) {
+      flops = 2.0 * n_fdur_a * n_impres_a + 2.0 * n_impres_a * n_impres_a +
+	num_pulses_a * (n_fdur_a + 4.0 * n_impres_a);
+    }
+    else {
+      flops = num_pulses_a * (2.0 * n_fdur_a * n_impres_a + n_fdur_a +
+			      2.0 * n_impres_a);
+    }
+    report("search", params, st, flops);
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  //
+  // driver
+  //
+  //---------------------------------------------------------------------------
+
+  // method: run
+  //
+  // arguments: none
+  //
+  // return: a boolean indicating status
+  //
+  // This method runs every benchmark over the grid in the precision of
+  // the policy P.
+  //
+  template <class P>
+  bool run() {
+
+    bool status = true;
+    for (long n : wdurs_d) {
+      status &= bench_window(n);
+    }
+    for (long p : orders_d) {
+      for (long n : wdurs_d) {
+	status &= bench_autocor<P>(p, n);
+      }
+    }
+    for (long p : orders_d) {
+      for (long n : wdurs_d) {
+	status &= bench_frontend<P>(p, n);
+      }
+    }
+    for (long p : orders_d) {
+      status &= bench_lpc<P>(p);
+    }
+    for (long p : orders_d) {
+      for (long m : impres_d) {
+	status &= bench_impres<P>(p, m);
+      }
+    }
+    for (long p : orders_d) {
+      for (long n : fdurs_d) {
+	status &= bench_residual(p, n);
+      }
+    }
+    for (const char* mode : {"full", "incremental"}) {
+      for (long n : fdurs_d) {
+	for (long m : impres_d) {
+	  for (long np : pulses_d) {
+	    status &= bench_search<P>(16, n, m, np, mode);
+	  }
+	}
+      }
+    }
+    return status;
+  }
+};
+
+// main: driver program
+//
+// This program runs the benchmark grid and prints one line per grid
+// point.
+//
+int main(int argc, const char** argv) {
+
+  // parse the command line
+  //
+  MplpcBench bench;
+  bench.reps_d = 20;
+  bench.warmup_d = 100;
+  strcpy(bench.simd_d, "none");
+  strcpy(bench.precision_d, "mixed");
+  bool quick = false;
+
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "-reps") == 0) && (i + 1 < argc)) {
+      bench.reps_d = std::max(1L, atol(argv[++i]));
+    }
+    else if ((strcmp(argv[i], "-warmup") == 0) && (i + 1 < argc)) {
+      bench.warmup_d = atol(argv[++i]);
+    }
+    else if ((strcmp(argv[i], "-simd") == 0) && (i + 1 < argc)) {
+      strcpy(bench.simd_d, argv[++i]);
+    }
+    else if ((strcmp(argv[i], "-precision") == 0) && (i + 1 < argc)) {
+      strcpy(bench.precision_d, argv[++i]);
+    }
+    else if (strcmp(argv[i], "-quick") == 0) {
+      quick = true;
+    }
+    else {
+      fprintf(stdout, "usage: bench_mplpc [-reps N] [-warmup N] "
+	      "[-simd mode] [-precision mode] [-quick]\n");
+      return 1;
+    }
+  }
+
+  // define the grid
+  //
+  bench.orders_d = {8, 12, 16, 24};
+  bench.wdurs_d = {160, 320, 640};
+  bench.fdurs_d = {80, 160};
+  bench.impres_d = {16, 40, 80};
+  bench.pulses_d = {4, 8, 16};
+  if (quick) {
+    bench.orders_d = {16};
+    bench.wdurs_d = {320};
+    bench.fdurs_d = {80};
+    bench.impres_d = {40};
+    bench.pulses_d = {8};
+  }
+
+  // run the benchmarks
+  //
+  fprintf(stdout, "bench_mplpc: fs = %.0f Hz, simd = %s, precision = %s, "
+	  "reps = %ld, warmup = %ld\n", MplpcBench::SAMPLE_FREQ,
+	  bench.simd_d, bench.precision_d, bench.reps_d, bench.warmup_d);
+  fprintf(stdout, "%-12s %-30s %12s %12s %8s %8s\n", "kernel", "params",
+	  "ns/frame", "min", "sd", "GFLOP/s");
+
+  bool status = true;
+  if (strcmp(bench.precision_d, "float") == 0) {
+    status = bench.run<MplpcFloat>();
+  }
+  else if (strcmp(bench.precision_d, "double") == 0) {
+    status = bench.run<MplpcDouble>();
+  }
+  else {
+    status = bench.run<MplpcMixed>();
+  }
+
+  // exit gracefully
+  //
+  if (!status) {
+    fprintf(stdout, "**> bench_mplpc: a benchmark could not be configured\n");
+  }
+  return status ? 0 : 1;
+}
+
+//
+// end of file
@@ -63,6 +63,13 @@ Mplpc::Mplpc() {
   vptrs_d[i++] = (void*)&(impres_dur_d);
   vptrs_d[i++] = (void*)&(num_pulses_d);
   vptrs_d[i++] = (void*)&(feat_type_d);
+  vptrs_d[i++] = (void*)&(search_mode_str_d);
+  vptrs_d[i++] = (void*)&(simd_mode_str_d);
+  vptrs_d[i++] = (void*)&(precision_str_d);
+  vptrs_d[i++] = (void*)&(num_threads_d);
+  vptrs_d[i++] = (void*)&(num_lanes_d);
+  vptrs_d[i++] = (void*)&(stream_recs_d);
+  vptrs_d[i++] = (void*)&(direct_read_d);
 
   //vptrs_d[i++] = (void*)&(algo_mode_str_d);
 
@@ -72,6 +79,8 @@ Mplpc::Mplpc() {
   vptrs_d[i++] = (void*)&(odir_d);
   vptrs_d[i++] = (void*)&(odir_repl_d);
   vptrs_d[i++] = (void*)&(oext_d);
+  vptrs_d[i++] = (void*)&(out_direct_d);
+  vptrs_d[i++] = (void*)&(out_queue_d);
 
   //---------------------------------------------------------------------------
   //
@@ -105,6 +114,16 @@ Mplpc::Mplpc() {
   lp_order_d = DEF_LP_ORDER;
   num_pulses_d = DEF_NUM_PULSES;
   feat_type_d = DEF_FEAT_TYPE;
+  strcpy(search_mode_str_d, DEF_SEARCH_MODE_NAME);
+  search_mode_d = DEF_SEARCH_MODE;
+  strcpy(simd_mode_str_d, DEF_SIMD_MODE_NAME);
+  simd_mode_d = DEF_SIMD_MODE;
+  strcpy(precision_str_d, DEF_PRECISION_NAME);
+  precision_d = DEF_PRECISION;
+  num_threads_d = DEF_NUM_THREADS;
+  num_lanes_d = DEF_NUM_LANES;
+  stream_recs_d = DEF_STREAM_RECORDS;
+  direct_read_d = DEF_DIRECT_READ;
   
   // section 3: feature file generation
   //
@@ -112,6 +131,8 @@ Mplpc::Mplpc() {
   odir_d[0] = (char)NULL;
   odir_repl_d[0] = (char)NULL;
   oext_d[0] = (char)NULL;
+  out_direct_d = DEF_OUTPUT_DIRECT;
+  out_queue_d = DEF_OUTPUT_QUEUE;
 
   //---------------------------------------------------------------------------
   //
@@ -125,8 +146,12 @@ Mplpc::Mplpc() {
   num_chan_proc_d = -1;
   sample_freq_d = -1;
 
-  // section 2: signal processing
+  // section 2: signal processing: the serial path always uses
+  //  the first workspace
   //
+  select_kernels();
+  work_d.resize(1);
+  profile_d = false;
 
   // section 3: output file generation
   //
@@ -201,6 +226,13 @@ const char* Mplpc::vnames_d[Mplpc::MAX_NVN] = {
   "impulse_response_duration",
   "num_pulses",
   "feat_type",
+  "pulse_search",
+  "simd_mode",
+  "precision",
+  "num_threads",
+  "channel_lanes",
+  "stream_records",
+  "direct_read",
   
   // section 3: output file generation
   //
@@ -208,6 +240,8 @@ const char* Mplpc::vnames_d[Mplpc::MAX_NVN] = {
   "output_directory",
   "output_replace",
   "output_extension",
+  "output_direct",
+  "output_queue",
 };
 
 // constants: variable types for variables appearing in the parameter file:
@@ -239,6 +273,13 @@ const char* Mplpc::vtypes_d[Mplpc::MAX_NVN] = {
   "float",		// impulse response duration: impres_dur_d
   "long",		// num_pulses: num_pulses_d
   "string",             // feat_type: excitation, pc, rc
+  "string",		// pulse search: search_mode_d
+  "string",		// simd mode: simd_mode_d
+  "string",		// precision: precision_d
+  "long",		// num_threads: num_threads_d
+  "long",		// channel_lanes: num_lanes_d
+  "long",		// stream_records: stream_recs_d
+  "long",		// direct_read: direct_read_d
   
   // section 5: feature file generation
   //
@@ -246,6 +287,8 @@ const char* Mplpc::vtypes_d[Mplpc::MAX_NVN] = {
   "string",		// output directory: odir_d
   "string",             // output directory replace: odir_repl_d 
   "string",		// output extension: oext_d
+  "long",		// output direct: out_direct_d
+  "long",		// output queue: out_queue_d
 };
 
 //-----------------------------------------------------------------------------
@@ -262,6 +305,9 @@ const char* Mplpc::DEF_SELMODE_NAME(Mplpc::SELMODE_NAME_00);
 const char* Mplpc::DEF_MATMODE_NAME(Mplpc::MATMODE_NAME_00);
 const char* Mplpc::DEF_DEBIAS_MODE_NAME(Mplpc::DEBIAS_MODE_NAME_00);
 const char* Mplpc::DEF_FEAT_TYPE_NAME(Mplpc::FEAT_TYPE_NAME_00);
+const char* Mplpc::DEF_SEARCH_MODE_NAME(Mplpc::SEARCH_MODE_NAME_00);
+const char* Mplpc::DEF_SIMD_MODE_NAME(Mplpc::SIMD_MODE_NAME_00);
+const char* Mplpc::DEF_PRECISION_NAME(Mplpc::PRECISION_NAME_00);
 const char* Mplpc::DEF_WINDOW_TYPE_NAME(Mplpc::WINDOW_TYPE_NAME_00);
 const char* Mplpc::DEF_WINDOW_NORM_NAME(Mplpc::WINDOW_NORM_NAME_00);
 const char* Mplpc::DEF_WINDOW_ALIGN_NAME(Mplpc::WINDOW_ALIGN_NAME_00);
@@ -310,6 +356,26 @@ const char* Mplpc::FEAT_TYPE_NAME_00("mplpc");
 const char* Mplpc::FEAT_TYPE_NAME_01("pc");
 const char* Mplpc::FEAT_TYPE_NAME_02("rc");
 
+// constants: pulse search modes
+//
+const char* Mplpc::SEARCH_MODE_NAME_00("full");
+const char* Mplpc::SEARCH_MODE_NAME_01("incremental");
+
+// constants: simd kernel modes
+//
+const char* Mplpc::SIMD_MODE_NAME_00("none");
+const char* Mplpc::SIMD_MODE_NAME_01("auto");
+const char* Mplpc::SIMD_MODE_NAME_02("scalar");
+const char* Mplpc::SIMD_MODE_NAME_03("sse2");
+const char* Mplpc::SIMD_MODE_NAME_04("avx2");
+const char* Mplpc::SIMD_MODE_NAME_05("avx512");
+
+// constants: precision policies
+//
+const char* Mplpc::PRECISION_NAME_00("mixed");
+const char* Mplpc::PRECISION_NAME_01("float");
+const char* Mplpc::PRECISION_NAME_02("double");
+
 // mplpc-related parameters
 //
 float Mplpc::DEF_PREEMPHASIS = 0.95;
@@ -318,5 +384,34 @@ long Mplpc::DEF_LP_ORDER = 16;
 float Mplpc::DEF_IMPRES_DURATION = 0.01;
 long Mplpc::DEF_NUM_PULSES = 2;
 
+// parallel processing-related parameters
+//
+long Mplpc::DEF_NUM_THREADS = 1;
+
+// channel-interleaved engine: zero means one channel at a time
+//
+long Mplpc::DEF_NUM_LANES = 0;
+
+// streaming-related parameters: zero means read the whole file. the
+// streaming reader decodes the data records itself rather than through
+// the Edf class, so it is only used when asked for (run_mplpc/make
+// check compares it with the Edf class)
+//
+long Mplpc::DEF_STREAM_RECORDS = 0;
+
+// whole-file reads of edf files go through the Edf class unless this
+// is set
+//
+long Mplpc::DEF_DIRECT_READ = 0;
+
+// output-related parameters: zero means write through the page cache
+//
+long Mplpc::DEF_OUTPUT_DIRECT = 0;
+
+// the number of output blocks queued for the writer thread: zero means
+// the blocks are written by the thread that fills them
+//
+long Mplpc::DEF_OUTPUT_QUEUE = 4;
+
 //
 // end of file
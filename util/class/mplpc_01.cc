@@ -226,6 +226,16 @@ bool Mplpc::print_parameters(FILE* fp_a) {
   fprintf(fp_a, " lp_order = [%lu]\n", lp_order_d);
   fprintf(fp_a, " impres_dur = [%lu]\n", impres_dur_d);
   fprintf(fp_a, " num_pulses = [%lu]\n", num_pulses_d);
+  fprintf(fp_a, " pulse_search = [%s] [%lu]\n",
+	  search_mode_str_d, (long)search_mode_d);
+  fprintf(fp_a, " simd_mode = [%s] [%lu] [%lu]\n",
+	  simd_mode_str_d, (long)simd_mode_d, (long)simd_isa_d);
+  fprintf(fp_a, " precision = [%s] [%lu]\n",
+	  precision_str_d, (long)precision_d);
+  fprintf(fp_a, " num_threads = [%lu]\n", num_threads_d);
+  fprintf(fp_a, " channel_lanes = [%lu]\n", num_lanes_d);
+  fprintf(fp_a, " stream_records = [%lu]\n", stream_recs_d);
+  fprintf(fp_a, " direct_read = [%lu]\n", direct_read_d);
 
   // dump the output file generation parameters
   //
@@ -233,6 +243,8 @@ bool Mplpc::print_parameters(FILE* fp_a) {
   fprintf(fp_a, " output_directory = [%s]\n", odir_d);
   fprintf(fp_a, " output_replace = [%s]\n", odir_repl_d);
   fprintf(fp_a, " output_extension = [%s]\n", oext_d);
+  fprintf(fp_a, " output_direct = [%lu]\n", out_direct_d);
+  fprintf(fp_a, " output_queue = [%lu]\n", out_queue_d);
 
   // display debug information
   //
@@ -320,6 +332,130 @@ bool Mplpc::convert_to_enums() {
     return false;
   }
 
+  // convert the pulse search mode
+  //
+  if (strcmp(search_mode_str_d, SEARCH_MODE_NAME_00) == 0) {
+    search_mode_d = SRCH_FULL;
+  }
+  else if (strcmp(search_mode_str_d, SEARCH_MODE_NAME_01) == 0) {
+    search_mode_d = SRCH_INCR;
+  }
+  else {
+    fprintf(stdout,
+	    "**> error in Mplpc::convert_to_enums(): invalid pulse search mode [%s]\n",
+	    search_mode_str_d);
+    return false;
+  }
+
+  // convert the precision policy
+  //
+  if (strcmp(precision_str_d, PRECISION_NAME_00) == 0) {
+    precision_d = PREC_MIXED;
+  }
+  else if (strcmp(precision_str_d, PRECISION_NAME_01) == 0) {
+    precision_d = PREC_FLOAT;
+  }
+  else if (strcmp(precision_str_d, PRECISION_NAME_02) == 0) {
+    precision_d = PREC_DOUBLE;
+  }
+  else {
+    fprintf(stdout,
+	    "**> error in Mplpc::convert_to_enums(): invalid precision [%s]\n",
+	    precision_str_d);
+    return false;
+  }
+
+  // check the number of channel lanes: zero or one turns the
+  // channel-interleaved engine off
+  //
+  if ((num_lanes_d != 0) && (num_lanes_d != 1) && (num_lanes_d != 4) &&
+      (num_lanes_d != 8) && (num_lanes_d != 16)) {
+    fprintf(stdout,
+	    "**> error in Mplpc::convert_to_enums(): invalid channel "
+	    "lanes [%ld] (must be 0, 1, 4, 8 or 16)\n", num_lanes_d);
+    return false;
+  }
+
+  // check the direct output flag
+  //
+  if ((out_direct_d != 0) && (out_direct_d != 1)) {
+    fprintf(stdout,
+	    "**> error in Mplpc::convert_to_enums(): invalid output direct [%ld] (must be 0 or 1)\n",
+	    out_direct_d);
+    return false;
+  }
+
+  // check the output queue length
+  //
+  if (out_queue_d < 0) {
+    fprintf(stdout,
+	    "**> error in Mplpc::convert_to_enums(): invalid output queue [%ld] (must be 0 or more)\n",
+	    out_queue_d);
+    return false;
+  }
+
+  // check the streaming block size: a streamed file is never loaded
+  // into the Edf object, which edf feature files are written from
+  //
+  if (stream_recs_d < 0) {
+    fprintf(stdout,
+	    "**> error in Mplpc::convert_to_enums(): invalid stream "
+	    "records [%ld] (must be 0 or more)\n", stream_recs_d);
+    return false;
+  }
+  if ((stream_recs_d > 0) && (strcmp(oext_d, Edf::FFMT_NAME_01) == 0)) {
+    fprintf(stdout,
+	    "**> error in Mplpc::convert_to_enums(): stream records must "
+	    "be 0 for [%s] output\n", oext_d);
+    return false;
+  }
+
+  // check the direct reads: like streaming, they leave the Edf object
+  // empty
+  //
+  if ((direct_read_d != 0) && (direct_read_d != 1)) {
+    fprintf(stdout,
+	    "**> error in Mplpc::convert_to_enums(): invalid direct "
+	    "read [%ld] (must be 0 or 1)\n", direct_read_d);
+    return false;
+  }
+  if ((direct_read_d > 0) && (strcmp(oext_d, Edf::FFMT_NAME_01) == 0)) {
+    fprintf(stdout,
+	    "**> error in Mplpc::convert_to_enums(): direct read must "
+	    "be 0 for [%s] output\n", oext_d);
+    return false;
+  }
+
+  // convert the simd mode and bind the kernels
+  //
+  if (strcmp(simd_mode_str_d, SIMD_MODE_NAME_00) == 0) {
+    simd_mode_d = SIMD_NONE;
+  }
+  else if (strcmp(simd_mode_str_d, SIMD_MODE_NAME_01) == 0) {
+    simd_mode_d = SIMD_AUTO;
+  }
+  else if (strcmp(simd_mode_str_d, SIMD_MODE_NAME_02) == 0) {
+    simd_mode_d = SIMD_SCALAR;
+  }
+  else if (strcmp(simd_mode_str_d, SIMD_MODE_NAME_03) == 0) {
+    simd_mode_d = SIMD_SSE2;
+  }
+  else if (strcmp(simd_mode_str_d, SIMD_MODE_NAME_04) == 0) {
+    simd_mode_d = SIMD_AVX2;
+  }
+  else if (strcmp(simd_mode_str_d, SIMD_MODE_NAME_05) == 0) {
+    simd_mode_d = SIMD_AVX512;
+  }
+  else {
+    fprintf(stdout,
+	    "**> error in Mplpc::convert_to_enums(): invalid simd mode [%s]\n",
+	    simd_mode_str_d);
+    return false;
+  }
+  if (!select_kernels()) {
+    return false;
+  }
+
   // exit gracefully
   //
   return true;
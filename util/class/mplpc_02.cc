@@ -3,6 +3,14 @@
 
 // include the global modules
 //
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 // local include files
 //
@@ -22,12 +30,29 @@
 // result to a file. Currently we process raw sampled data signals,
 // but this needs to be changed to EDF signals.
 //
+// Raw feature files are written while the file is analyzed: the output
+// is opened once the input is, and as soon as a channel and all the
+// channels before it are finished, it is converted and queued for the
+// writer thread (see MplpcWriter), so the analysis goes on during the
+// writes. If the analysis fails, the partial output file is removed.
+//
 bool Mplpc::compute(char* oname_a, char* iname_a) {
   
   // declare local variables
   //
   bool status;
-  VVVectorDouble sig;
+  VMplpcPulses sig;
+  MplpcInput in;
+  MPLPC_TRACE_SCOPE("file");
+
+  // start a new profile
+  //
+  long long prof_beg = MplpcTrace::now();
+  long long prof_t = prof_beg;
+  prof_d.clear();
+  for (long i = 0; i < (long)work_d.size(); i++) {
+    work_d[i].prof_d.clear();
+  }
   
   // display a debug message
   //
@@ -36,21 +61,163 @@ bool Mplpc::compute(char* oname_a, char* iname_a) {
 	    "Mplpc::compute(): begin mplpc analysis (sampled data mode)\n");
   }
 
-  // initalize the window function
+  // open the input file: an existing output file is left alone when
+  //  there is nothing to analyze
   //
-  status = create_window();
+  if (!Mplpc::open_input(in, iname_a)) {
+    fprintf(stdout, "   Mplpc::compute(): error opening file (%s)\n",
+	    iname_a);
+    return false;
+  }
+
+  // open the output file of a raw feature file
+  //
+  edf_d.create_filename(oname_a, iname_a, odir_d, oext_d, odir_repl_d);
+  bool raw = (strcmp(oext_d, DEF_FEAT_TYPE_NAME) == 0);
+  MplpcWriter out;
+  if (raw && !out.open(oname_a, out_direct_d != 0, out_queue_d)) {
+    return false;
+  }
+
+  // hand the channels to the writer in order as they are finished:
+  //  the engines may finish them out of order and from several threads
+  //
+  std::mutex out_mutex;
+  std::vector<char> done;
+  long next = 0;
+  if (raw) {
+    chans_done_d = [&](long chan_a, long num_chans_a) {
+      std::lock_guard<std::mutex> lock(out_mutex);
+      done.resize(sig.size(), 0);
+      std::fill(done.begin() + chan_a, done.begin() + chan_a + num_chans_a,
+		1);
+      for (; (next < (long)sig.size()) && done[next]; next++) {
+	if (!Mplpc::write_channel(out, sig[next])) {
+	  return false;
+	}
+      }
+      return true;
+    };
+  }
 
   // do the actual mplpc analysis
   //
+  status = Mplpc::compute_file(sig, in);
+  chans_done_d = nullptr;
+  in.clear();
+
+  // save the sampled data: the profile only counts the time spent
+  // writing after the analysis
+  //
+  MPLPC_TRACE_SCOPE("write");
+  prof_t = MplpcTrace::now();
+
+  // write the channels that weren't handed off during the analysis
+  //
+  if (raw) {
+    for (; status && (next < (long)sig.size()); next++) {
+      if (!Mplpc::write_channel(out, sig[next])) {
+	break;
+      }
+    }
+    if (!out.close() && status) {
+      fprintf(stdout, "   Mplpc::compute(): error writing data\n");
+      status = false;
+    }
+    if (!status) {
+      unlink(oname_a);
+      return false;
+    }
+  }
+
+  // nothing else is written for a file that failed
+  //
+  else if (!status) {
+    return false;
+  }
+
+  else if (strcmp(oext_d, Edf::FFMT_NAME_01) == 0) {
+    VVVectorDouble dense;
+    Mplpc::expand_pulses(dense, sig);
+    edf_d.write_features_raw(dense, oname_a);
+  }
+
+
+  // finish the profile
+  //
+  if (profile_d) {
+    prof_d.lap(MplpcProfile::WRITE, prof_t);
+    for (long i = 0; i < (long)work_d.size(); i++) {
+      prof_d.add(work_d[i].prof_d);
+    }
+    prof_d.wall_d = (MplpcTrace::now() - prof_beg) * 1.0e-9;
+  }
+
+  // exit gracefully
+  //
+  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+    fprintf(stdout, "Mplpc::compute(): end of mplpc analysis\n");
+  }
+  return true;
+}
+
+// method: compute_file
+//
+// arguments:
+//  VMplpcPulses& sig: pulses for each channel (output)
+//  char* iname: EDF or raw sample filename (input)
+//
+// return: a boolean indicating status
+//
+// This method analyzes a file without writing the result: it opens the
+// file and hands it to compute_file() below.
+//
+bool Mplpc::compute_file(VMplpcPulses& sig_a, char* iname_a) {
+
+  MplpcInput in;
+  if (!Mplpc::open_input(in, iname_a)) {
+    fprintf(stdout, "   Mplpc::compute_file(): error opening file (%s)\n",
+	    iname_a);
+    return false;
+  }
+  return Mplpc::compute_file(sig_a, in);
+}
+
+// method: compute_file
+//
+// arguments:
+//  VMplpcPulses& sig: pulses for each channel (output)
+//  MplpcInput& in: a file from open_input (input)
+//
+// return: a boolean indicating status
+//
+// This method creates the window function and hands the file to the
+// reader that matches its type and the streaming setting.
+//
+bool Mplpc::compute_file(VMplpcPulses& sig_a, MplpcInput& in_a) {
+
+  // declare local variables
+  //
+  bool status;
+
+  // initalize the window function
+  //
+  status = create_window();
 
   // case 1: when file is edf
   //
-  if (edf_d.is_edf((char*) iname_a)) {
+  if (in_a.is_edf_d) {
 
-    // mplpc analysis
+    // mplpc analysis: read the whole file or stream it a few records
+    // at a time
     //
-    status = Mplpc::compute_00_edf(sig, iname_a);
-
+    if (stream_recs_d > 0) {
+      status = Mplpc::compute_00_edf_stream(sig_a, in_a);
+    }
+    else {
+      status = Mplpc::read_edf_input(in_a) &&
+	Mplpc::compute_00_edf(sig_a, in_a);
+    }
   }
   // case 2: when file is not edf
   //
@@ -58,89 +225,181 @@ bool Mplpc::compute(char* oname_a, char* iname_a) {
 
     // mplpc analysis
     //
-    status = Mplpc::compute_00(sig, iname_a);
+    status = Mplpc::compute_00(sig_a, in_a);
    
   }
-  
 
-  // save the sampled data
+  // exit gracefully
   //
-  edf_d.create_filename(oname_a, iname_a, odir_d, oext_d, odir_repl_d);
+  return status;
+}
 
-  // create the output file
-  //
-  FILE* fp = fopen(oname_a, "w");
-  if (fp == (FILE*)NULL) {
-    fprintf(stdout,
-	    "   Mplpc::compute(): error opening output file [%s]\n",
-	    oname_a);
+// method: read_file
+//
+// arguments:
+//  MplpcInput& in: the file, decoded if possible (output)
+//  char* iname: EDF or raw sample filename (input)
+//
+// return: a boolean indicating status
+//
+// This method is the first stage of a pipeline over files (see
+// compute_input): it opens a file and, for an EDF file, decodes it and
+// applies the channel selection and montage, so this can happen while
+// another file is analyzed. Files that are streamed or memory-mapped are
+// not decoded ahead: they are read in small blocks during the analysis
+// anyway, so they are only opened, which starts the kernel reading
+// them. A file that can't be opened or decoded is left to the analysis,
+// which reports the error.
+//
+bool Mplpc::read_file(MplpcInput& in_a, char* iname_a) {
+
+  if (!Mplpc::open_input(in_a, iname_a)) {
+    return false;
+  }
+  if ((stream_recs_d > 0) || !in_a.is_edf_d) {
+    return true;
+  }
+  if (!Mplpc::read_edf_input(in_a)) {
+    Mplpc::open_input(in_a, iname_a);
     return false;
   }
+  in_a.close_file();
 
+  // exit gracefully
+  //
+  return true;
+}
 
-  if (strcmp(oext_d, DEF_FEAT_TYPE_NAME) == 0) {
-  // write the data
+// method: compute_input
+//
+// arguments:
+//  VMplpcPulses& sig: pulses for each channel (output)
+//  MplpcInput& in: a file from read_file (input)
+//
+// return: a boolean indicating status
+//
+// This method is the second stage of a pipeline over files: it analyzes
+// a file that read_file() may have decoded already, and gives the same
+// pulses as compute_file(). The profile covers this call, plus the time
+// read_file() spent on the file.
+//
+bool Mplpc::compute_input(VMplpcPulses& sig_a, MplpcInput& in_a) {
+
+  // declare local variables
+  //
+  bool status;
+  MPLPC_TRACE_SCOPE("file");
+
+  // start a new profile
   //
-  short int val;
-  long ch_end = sig[0].size();
-  long feat_end = sig[0][0].size();
+  long long prof_beg = MplpcTrace::now();
+  prof_d.clear();
+  for (long i = 0; i < (long)work_d.size(); i++) {
+    work_d[i].prof_d.clear();
+  }
 
-  // iterate each channel
+  // analyze the decoded signal, or read the file now
   //
-  for (long j = 0; j < sig.size(); j++) {
-    // iterate each frame
-    //
-    for (long k = 0; k < ch_end; k++) {
-      // iterate over feature dimensions
-      //
-      for (long l = 0; l < feat_end; l++) {
-	val = Mplpc::clip_value(sig[j][k][l]);
+  if (in_a.decoded_d) {
+    create_window();
+    status = Mplpc::compute_00_edf(sig_a, in_a);
+  }
+  else {
+    status = Mplpc::compute_file(sig_a, in_a);
+  }
 
-	if (fwrite(&val, sizeof(short int), 1, fp) != 1) {
-	  fprintf(stdout, "   Mplpc::compute(): error writing data\n");
-	  return false;
-	}
-      }
+  // finish the profile
+  //
+  if (profile_d) {
+    for (long i = 0; i < (long)work_d.size(); i++) {
+      prof_d.add(work_d[i].prof_d);
     }
+    prof_d.wall_d = (MplpcTrace::now() - prof_beg) * 1.0e-9;
   }
 
-  // close the output file
+  // exit gracefully
   //
-  fclose(fp);
-  }
+  return status;
+}
 
+// method: write_file
+//
+// arguments:
+//  char* oname: feature filename (output)
+//  char* iname: EDF or raw sample filename (input)
+//  VMplpcPulses& sig: pulses for each channel (input)
+//
+// return: a boolean indicating status
+//
+// This method is the last stage of a pipeline over files: it writes the
+// pulses of a file in the format the parameters select, as compute()
+// does. The profile covers this call.
+//
+bool Mplpc::write_file(char* oname_a, char* iname_a, VMplpcPulses& sig_a) {
+
+  // declare local variables
+  //
+  bool status = true;
+  MPLPC_TRACE_SCOPE("write");
+
+  long long prof_t = MplpcTrace::now();
+  long long prof_beg = prof_t;
+  prof_d.clear();
+
+  // write the file
+  //
+  edf_d.create_filename(oname_a, iname_a, odir_d, oext_d, odir_repl_d);
+  if (strcmp(oext_d, DEF_FEAT_TYPE_NAME) == 0) {
+    MplpcWriter out;
+    status = out.open(oname_a, out_direct_d != 0, out_queue_d);
+    for (long j = 0; status && (j < (long)sig_a.size()); j++) {
+      status = Mplpc::write_channel(out, sig_a[j]);
+    }
+    status = out.close() && status;
+  }
   else if (strcmp(oext_d, Edf::FFMT_NAME_01) == 0) {
-    edf_d.write_features_raw(sig, oname_a);
+    VVVectorDouble dense;
+    Mplpc::expand_pulses(dense, sig_a);
+    edf_d.write_features_raw(dense, oname_a);
+  }
+  if (!status) {
+    fprintf(stdout, "   Mplpc::write_file(): error writing data\n");
   }
 
-
+  // finish the profile
+  //
+  if (profile_d) {
+    prof_d.lap(MplpcProfile::WRITE, prof_t);
+    prof_d.wall_d = (MplpcTrace::now() - prof_beg) * 1.0e-9;
+  }
 
   // exit gracefully
   //
-  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-    fprintf(stdout, "Mplpc::compute(): end of mplpc analysis\n");
-  }
-  return true;
+  return status;
 }
 
 // method: compute_00
 //
 // arguments:
-//  VVVectorDouble& sig: signal data (output)
-//  char* iname: EDF filename (input)
+//  VMplpcPulses& sig: pulses for each channel (output)
+//  MplpcInput& in: a raw sample file from open_input (input)
 //
 // return: a boolean indicating status
 //
-// This method opens a binary file, retrieves the signal, processes it
-// through the mplpc algorithm, and returns the new data. It outputs
-// a multichannel signal.
+// This method processes a file of raw 16-bit samples through the mplpc
+// algorithm. It outputs a multichannel signal with one channel.
 //
-bool Mplpc::compute_00(VVVectorDouble& sig_a, char* iname_a) {
+// The file is memory-mapped rather than read into a buffer: samples are
+// converted to floating point a few frames at a time and fed to the
+// block-by-block analysis, so the input costs no heap memory beyond
+// one block and the page cache can be shared by concurrent jobs.
+//
+bool Mplpc::compute_00(VMplpcPulses& sig_a, MplpcInput& in_a) {
 
   // declare local variables
   //
-  VVectorDouble sig_t;
-  bool status = false;
+  bool status = true;
+  char* iname = (char*)in_a.fname_d.c_str();
 
   // display a debug message
   //
@@ -149,64 +408,107 @@ bool Mplpc::compute_00(VVVectorDouble& sig_a, char* iname_a) {
 	    "   Mplpc::compute_00(): begin sampled data processing\n");
   }
   
-  // open the file
+  // the file was opened by open_input
   //
-  FILE* fp = fopen(iname_a, "r");
-  if (fp == (FILE*)NULL) {
+  long long prof_t = MplpcTrace::now();
+  int fd = in_a.fd_d;
+  if (fd < 0) {
     fprintf(stdout, "   Mplpc::compute_00(): error opening file (%s)\n",
-	    iname_a);
+	    iname);
+    return false;
   }
   else if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
     fprintf(stdout,
-	    "   Mplpc::compute_00(): file is opened (%s)\n", iname_a);
+	    "   Mplpc::compute_00(): file is opened (%s)\n", iname);
   }
 
   // get the number of samples from the file
   //
-  fseek(fp, 0L, SEEK_END);
-  long num_samples = ftell(fp) / sizeof(short int);
-  rewind(fp);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    fprintf(stdout, "   Mplpc::compute_00(): error reading file (%s)\n",
+	    iname);
+    return false;
+  }
+  long num_samples = st.st_size / sizeof(short int);
 
-  // retrieve the signal:
-  //  we use a temporary buffer so we can delete it and free memory
+  // map the file: the input closes the descriptor, which leaves the
+  // mapping valid
   //
-  short int *buf = new short int[num_samples];
-  long num_samples_read = fread(buf, sizeof(short int), num_samples, fp);
-  if (num_samples_read != num_samples) {
-    fprintf(stdout, "   Mplpc::compute_00(): error reading file (%ld %ld)\n",
-	    num_samples, num_samples_read);
-    fclose(fp);
-    return false;
+  const short int* buf = (const short int*)NULL;
+  if (num_samples > 0) {
+    void* ptr = mmap(NULL, num_samples * sizeof(short int), PROT_READ,
+		     MAP_PRIVATE, fd, 0);
+    if (ptr == MAP_FAILED) {
+      fprintf(stdout, "   Mplpc::compute_00(): error mapping file (%s)\n",
+	      iname);
+      return false;
+    }
+    madvise(ptr, num_samples * sizeof(short int), MADV_SEQUENTIAL);
+    buf = (const short int*)ptr;
   }
-  else if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+
+  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
     fprintf(stdout, "   Mplpc::compute_00(): processing %ld samples\n",
 	    num_samples);
   }
+  if (profile_d) {
+    prof_d.lap(MplpcProfile::READ, prof_t);
+  }
 
-  // resize the VectorDouble signal to be one channel x num_samples (temporary)
+  // step 1: compute the mean of the signal if it is to be debiased:
+  //  this sums the samples in the same order as debias()
   //
-  edf_d.resize(sig_t, (long)1); // set up size for channels
-  edf_d.resize(sig_t[0], num_samples); // set up size for the elements of the vector
+  double bias = 0.0;
+  if ((debias_mode_d == Mplpc::DBS_SIGNAL) && (num_samples > 0)) {
+    double sum = 0;
+    for (long i = 0; i < num_samples; i++) {
+      sum += buf[i];
+    }
+    bias = sum / (double)num_samples;
+  }
+  if (profile_d) {
+    prof_d.lap(MplpcProfile::PREEMPH, prof_t);
+  }
 
-  // transfer the data and delete buf
+  // step 2: do an mplpc analysis, converting a few frames at a time
   //
-  for (long i = 0; i < num_samples; i++) {
-    sig_t[0][i] = buf[i];
+  MplpcState state;
+  long n_block = round(frame_duration_d * sample_freq_d) * MMAP_FRAMES;
+  if (n_block < 1) {
+    n_block = 1;
+  }
+  VectorDouble block;
+  block.reserve(n_block);
+
+  sig_a.resize(1);
+  status = Mplpc::compute_mplpc_open(state, sig_a[0], bias);
+  for (long i = 0; status && (i < num_samples); i += n_block) {
+    long n = std::min(n_block, num_samples - i);
+    if (profile_d) {
+      prof_t = MplpcTrace::now();
+      block.assign(buf + i, buf + i + n);
+      prof_d.lap(MplpcProfile::READ, prof_t);
+    }
+    else {
+      block.assign(buf + i, buf + i + n);
+    }
+    status = Mplpc::compute_mplpc_block(state, sig_a[0], block);
+  }
+  if (status) {
+    status = Mplpc::compute_mplpc_close(state, sig_a[0]);
   }
-  delete [] buf;
 
-  // close the file
+  // unmap the file
   //
-  fclose(fp);
+  if (buf != (const short int*)NULL) {
+    munmap((void*)buf, num_samples * sizeof(short int));
+  }
   if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
     fprintf(stdout,
-	    "   Mplpc::compute_00(): file is closed (%s)\n", iname_a);
+	    "   Mplpc::compute_00(): file is closed (%s)\n", iname);
   }
 
-  // do an mplpc analysis
-  //
-  status = Mplpc::compute_mplpc(sig_a, sig_t);
-
   // display a debug message
   //
   if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
@@ -221,7 +523,7 @@ bool Mplpc::compute_00(VVVectorDouble& sig_a, char* iname_a) {
 // method: compute_00_edf
 // may need to revise
 // arguments:
-//  VVVectorDouble& sig: signal data (output)
+//  VMplpcPulses& sig: pulses for each channel (output)
 //  char* iname: EDF filename (input)
 //
 // return: a boolean indicating status
@@ -230,27 +532,133 @@ bool Mplpc::compute_00(VVVectorDouble& sig_a, char* iname_a) {
 // through the mplpc algorithm, and returns the new data. It outputs
 // a multichannel signal.
 //
-bool Mplpc::compute_00_edf(VVVectorDouble& sig_a, char* iname_a) {
+bool Mplpc::compute_00_edf(VMplpcPulses& sig_a, char* iname_a) {
+
+  // declare local variables
+  //
+  MplpcInput in;
+
+  // read the EDF file and analyze it
+  //
+  Mplpc::open_input(in, iname_a);
+  if (!Mplpc::read_edf_input(in)) {
+    return false;
+  }
+  return Mplpc::compute_00_edf(sig_a, in);
+}
+
+// method: compute_00_edf
+//
+// arguments:
+//  VMplpcPulses& sig: pulses for each channel (output)
+//  MplpcInput& in: decoded signal (input)
+//
+// return: a boolean indicating status
+//
+// This method analyzes a decoded EDF file: it picks up the sample
+// frequency and channel counts of the file and charges the time spent
+// reading it to the profile.
+//
+bool Mplpc::compute_00_edf(VMplpcPulses& sig_a, MplpcInput& in_a) {
+
+  // declare local variables
+  //
+  bool status = false;
+
+  // pick up the sample frequency and number of channels
+  //
+  sample_freq_d = in_a.sample_freq_d;
+  num_chan_file_d = in_a.num_chan_file_d;
+  num_chan_proc_d = in_a.num_chan_proc_d;
+  if (profile_d) {
+    prof_d.add(in_a.prof_d);
+  }
+
+  // do an mplpc analysis
+  //
+  status = Mplpc::compute_mplpc(sig_a, in_a.sig_d);
+
+  // display a debug message
+  //
+  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+    fprintf(stdout, "   Mplpc::compute_00(): end sampled data processing\n");
+  }
+  
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: read_edf_input
+//
+// arguments:
+//  MplpcInput& in: an EDF file from open_input, decoded (input/output)
+//
+// return: a boolean indicating status
+//
+// This method reads a whole EDF file, selects the channels and applies
+// the montage. Only the Edf object of this class is changed, so files
+// can be read by one object while another analyzes.
+//
+// With direct_read_d set, and when the channel selection and the
+// montage can be resolved against the header, only the signals the
+// montage uses are decoded, straight from the data records (see
+// read_edf_direct). Otherwise, or if that read fails, the Edf class
+// decodes every signal and then selects the channels.
+//
+bool Mplpc::read_edf_input(MplpcInput& in_a) {
 
   // declare local variables
   //
   VVectorDouble sig_t;
   VVectorDouble sig_s;
-  VVectorDouble sig_f;
+  std::vector<long> chan_a;
+  std::vector<long> chan_b;
+  std::vector<char> need;
+  long num_sel = 0;
+  char* iname = (char*)in_a.fname_d.c_str();
   bool status = false;
 
   // display a debug message
-  
+  //
   if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
     fprintf(stdout,
-  	    "   Mplpc::compute_00_edf(): begin edf data processing\n");
+	    "   Mplpc::compute_00_edf(): begin edf data processing\n");
   }
-  
+
+  // read only the signals the montage needs
+  //
+  MPLPC_TRACE_START(trace_t);
+  long long prof_t = MplpcTrace::now();
+  if ((direct_read_d > 0) && (in_a.fd_d >= 0) && in_a.has_hdr_d &&
+      Mplpc::resolve_direct(chan_a, chan_b, need, num_sel, in_a.hdr_d)) {
+    if (profile_d) {
+      in_a.prof_d.lap(MplpcProfile::SELECT, prof_t);
+    }
+    if (Mplpc::read_edf_direct(in_a, chan_a, chan_b, need, num_sel)) {
+      MPLPC_TRACE_LAP(trace_t, "read");
+      return true;
+    }
+
+    // fall back to the Edf class
+    //
+    if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+      fprintf(stdout,
+	      "   Mplpc::read_edf_input(): reading through the Edf class\n");
+    }
+    in_a.sig_d.clear();
+    in_a.decoded_d = false;
+    prof_t = MplpcTrace::now();
+  }
+
   // read the EDF file
   //
-  if (!(status = edf_d.read_edf(sig_t, iname_a, true, true))) {
+  if (!(status = edf_d.read_edf(sig_t, iname, true, true))) {
     return status;
   }
+  if (profile_d) {
+    in_a.prof_d.lap(MplpcProfile::READ, prof_t);
+  }
   if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
     fprintf(stdout,
 	    "   Mplpc::compute_01_edf(): signal loaded from the EDF file\n");
@@ -261,6 +669,9 @@ bool Mplpc::compute_00_edf(VVVectorDouble& sig_a, char* iname_a) {
   if (!(status = edf_d.select(sig_s, sig_t, cselect_d, match_mode_d))) {
     return status;
   }
+  if (profile_d) {
+    in_a.prof_d.lap(MplpcProfile::SELECT, prof_t);
+  }
   if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
     fprintf(stdout,
 	    "   Fe::compute_00_select(): channel selection completed\n");
@@ -269,9 +680,9 @@ bool Mplpc::compute_00_edf(VVVectorDouble& sig_a, char* iname_a) {
 
   // pick up the sample frequency and number of channels
   //
-  sample_freq_d = edf_d.get_sample_frequency();
-  num_chan_file_d = edf_d.get_num_channels_file();
-  num_chan_proc_d = edf_d.get_num_channels_proc();
+  in_a.sample_freq_d = edf_d.get_sample_frequency();
+  in_a.num_chan_file_d = edf_d.get_num_channels_file();
+  in_a.num_chan_proc_d = edf_d.get_num_channels_proc();
 
   // apply the montage
   //
@@ -279,42 +690,53 @@ bool Mplpc::compute_00_edf(VVVectorDouble& sig_a, char* iname_a) {
     fprintf(stdout,
 	    "   Mplpc::compute_00_select(): applying the montage\n");
   }
-  if (!(status = edf_d.apply_montage(sig_f, sig_s, montage_d, match_mode_d))) {
+  if (!(status = edf_d.apply_montage(in_a.sig_d, sig_s, montage_d,
+				      match_mode_d))) {
     return status;
   }
-
-  // do an mplpc analysis
-  //
-  status = Mplpc::compute_mplpc(sig_a, sig_f);
-
-  // display a debug message
-  //
-  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-    fprintf(stdout, "   Mplpc::compute_00(): end sampled data processing\n");
+  MPLPC_TRACE_LAP(trace_t, "read");
+  if (profile_d) {
+    in_a.prof_d.lap(MplpcProfile::MONTAGE, prof_t);
   }
-  
+  in_a.decoded_d = true;
+
   // exit gracefully
   //
   return status;
 }
 
-
 // method: compute_mplpc
 //
 // arguments:
-//  VVVectorDouble& osig: signal data (output)
-//  VVectorDouble& isig: signal data (input)
+//  VMplpcPulses& osig: pulses for each channel (output)
+//  const VVectorDouble& isig: signal data (input)
 //
 // return: a boolean indicating status
 //
-// This method processes a multichannel signal by iterating over its
-// channels one channel at a time.
+// This method processes a multichannel signal. Channels are independent,
+// so when num_threads_d > 1 they are handed out to a pool of worker
+// threads (see run_workers) that write into preallocated output slots.
+// The single-channel method only reads shared state, so the result is
+// identical to the serial path. When there are fewer channels than
+// threads, the channels are instead analyzed one at a time with their
+// frames split among the threads (see compute_frames). When
+// num_lanes_d > 1 the channels are analyzed in groups by the
+// channel-interleaved engine (see compute_lanes). Each channel is
+// reported to channels_done() as soon as it is finished.
 //
-bool Mplpc::compute_mplpc(VVVectorDouble& osig_a, VVectorDouble& isig_a) {
+bool Mplpc::compute_mplpc(VMplpcPulses& osig_a,
+			  const VVectorDouble& isig_a) {
 
   // declare local variables
   //
   bool status = true;
+  long num_chans = isig_a.size();
+
+  // use the channel-interleaved engine if it is selected
+  //
+  if (num_lanes_d > 1) {
+    return Mplpc::compute_lanes(osig_a, isig_a);
+  }
 
   if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
     fprintf(stdout,
@@ -324,25 +746,46 @@ bool Mplpc::compute_mplpc(VVVectorDouble& osig_a, VVectorDouble& isig_a) {
 
   // resize the output signal
   //
-  edf_d.resize(osig_a, isig_a.size());
+  osig_a.resize(num_chans);
 
-  // resize the osig_a based on the number of frames, channels and out-dimensions/features
-  //
-  
-  // loop over all the channels
+  // case 1: too few channels to keep the threads busy - split each
+  // channel's frames among them
   //
-  for (long i = 0; i < isig_a.size(); i++) {
+  if ((num_threads_d > 1) && (num_chans < num_threads_d)) {
+    for (long i = 0; i < num_chans; i++) {
+      if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+	fprintf(stdout,
+		"   Mplpc::compute_mplpc(): processing channel %ld "
+		"(split frames)\n", i);
+      }
+      if (!Mplpc::compute_mplpc(osig_a[i], isig_a[i], Mplpc::ALL_WORKERS)) {
+	fprintf(stdout,
+		"   Mplpc::compute_mplpc(): error processing channel %ld\n", i);
+	return false;
+      }
+      if (!Mplpc::channels_done(i, 1)) {
+	return false;
+      }
+    }
+    return status;
+  }
 
+  // case 2: loop over all the channels: each task writes to its own slot
+  //
+  status = Mplpc::run_workers(num_chans, [&](long i, long w) {
     if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
       fprintf(stdout,
 	      "   Mplpc::compute_mplpc(): processing channel %ld\n", i);
     }
-    status = Mplpc::compute_mplpc(osig_a[i], isig_a[i]);
-    if (!status) {
+    if (!Mplpc::compute_mplpc(osig_a[i], isig_a[i], w)) {
       fprintf(stdout,
-	      "   Mplpc::compute_mplpc(): error processing channel %d\n", i);
-      return status;
-    }	
+	      "   Mplpc::compute_mplpc(): error processing channel %ld\n", i);
+      return false;
+    }
+    return Mplpc::channels_done(i, 1);
+  });
+  if (!status) {
+    return status;
   }
 
   // exit gracefully
@@ -358,34 +801,72 @@ bool Mplpc::compute_mplpc(VVVectorDouble& osig_a, VVectorDouble& isig_a) {
 // method: compute_mplpc
 //
 // arguments:
-//  VVectorDouble& osig: signal data (output)
-//  VectorDouble& isig: signal data (input)
+//  MplpcPulses& osig: pulses (output)
+//  const VectorDouble& isig: signal data (input)
+//  long worker: index of the frame workspace to use, or ALL_WORKERS
+//               to split the frames among the worker threads (input)
 //
 // return: a boolean indicating status
 //
 // This method processes a single channel through the algorithm known
 // as multipulse linear prediction. This is main processing function
-// that does all the heavy lifting.
+// that does all the heavy lifting: it picks up a workspace and runs
+// the analysis in the precision the parameters select.
 //
-bool Mplpc::compute_mplpc(VVectorDouble& osig_a, VectorDouble& isig_a) {
+bool Mplpc::compute_mplpc(MplpcPulses& osig_a, const VectorDouble& isig_a,
+			  long worker_a) {
 
-  // make sure the right analysis parameters are set. to keep things simple,
-  // we currently only support these configurations:
-  //    window duration >= frame duration
-  //    right-aligned windows
+  // time the whole channel
   //
-  if (win_align_d != Mplpc::WNAL_RIGHT) {
+  MPLPC_TRACE_SCOPE("channel");
+
+  // make sure the right analysis parameters are set
+  //
+  if (!Mplpc::check_analysis()) {
     return false;
   }
-  else if (frame_duration_d > window_duration_d) {
+
+  // get a frame workspace
+  //
+  bool split = false;
+  MplpcWork* work = Mplpc::get_split_work(worker_a, split);
+  if (work == (MplpcWork*)NULL) {
     return false;
   }
-  else if (debias_mode_d == Mplpc::DBS_WINDOW) {
-    return false;
+
+  // run the analysis with the selected precision policy
+  //
+  if (precision_d == Mplpc::PREC_FLOAT) {
+    return Mplpc::compute_mplpc<MplpcFloat>(osig_a, isig_a, *work, split);
   }
+  else if (precision_d == Mplpc::PREC_DOUBLE) {
+    return Mplpc::compute_mplpc<MplpcDouble>(osig_a, isig_a, *work, split);
+  }
+  return Mplpc::compute_mplpc<MplpcMixed>(osig_a, isig_a, *work, split);
+}
+
+// method: compute_mplpc
+//
+// arguments:
+//  MplpcPulses& osig: pulses (output)
+//  const VectorDouble& isig: signal data (input)
+//  MplpcWork& work: frame workspace, sized by get_work (scratch)
+//  bool split: split the frames among the worker threads (input)
+//
+// return: a boolean indicating status
+//
+// This method is the single channel analysis in the precision of the
+// policy P. The signal is not modified: each frame debiases and
+// preemphasizes the samples it reads (see window_frame), so only the
+// mean of the signal is computed up front.
+//
+template <class P>
+bool Mplpc::compute_mplpc(MplpcPulses& osig_a, const VectorDouble& isig_a,
+			  MplpcWork& work_a, bool split_a) {
 
   // declare local variables
   //
+  MplpcWork* work = &work_a;
   bool status = true;
 
   // convert parameters from time (secs) to integers (samples):
@@ -395,181 +876,411 @@ bool Mplpc::compute_mplpc(VVectorDouble& osig_a, VectorDouble& isig_a) {
   long n_fdur = round(frame_duration_d * sample_freq_d);
   long n_wdur = round(window_duration_d * sample_freq_d);
   long num_frames = nsamps / n_fdur;
-  long n_impres = round(impres_dur_d * sample_freq_d);
 
   if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
   fprintf(stdout, "   Mplpc::compute_mplpc(): nsamps = %ld, n_fdur = %ld, n_wdur = %ld, num_frames = %ld\n", nsamps, n_fdur, n_wdur, num_frames);
   }
  
-  // resize the output signal to make room for the output data
-  //
-  edf_d.resize(osig_a, isig_a.size());
-
-  // calculate output feature dimensions from info collected from
-  // parameter file
+  // clear the pulse store and make room for all the pulses
   //
-  long out_dim = 1;
+  osig_a.clear(nsamps);
+  osig_a.reserve(num_frames * num_pulses_d);
+  long long prof_t = profile_d ? MplpcTrace::now() : 0;
   
-  // initialize the output signal array so that pulses
-  // at various indices can be loaded at any time in the loop
+  // step 1: compute the value that debiasing removes
   //
-  for (int i = 0; i < osig_a.size(); i++) {
-    edf_d.resize(osig_a[i], out_dim);
+  double bias = 0.0;
+  if (debias_mode_d == Mplpc::DBS_SIGNAL) {
+    bias = Mplpc::compute_mean(isig_a);
+  }
+  if (profile_d) {
+    work->prof_d.lap(MplpcProfile::PREEMPH, prof_t);
+    work->prof_d.nsamps_d += nsamps;
+    work->prof_d.nchans_d++;
   }
   
-  // step 1: debias the data
+  // step 2: loop over the signal by frames: the windows are read
+  // straight out of the signal
   //
-  if (debias_mode_d == Mplpc::DBS_SIGNAL) {
-    float avg = Mplpc::debias(isig_a);
+  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+    fprintf(stdout, "   Mplpc::compute_mplpc(): looping over frames\n");
   }
+  status = Mplpc::compute_frames<P>(*work, osig_a, isig_a.data(), bias, 0,
+				    nsamps, 0, num_frames, split_a);
 
-  // step 2: preemphasize the signal "in place" to save memory
+  // exit gracefully
   //
-  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-    fprintf(stdout, "   Mplpc::compute_mplpc(): preemphasis\n");
-  }
-  float pre = 0.0;
-  float cur = 0.0;
+  return status;
+}
 
-  // fprintf(stdout, "preemphsize begin...");
-  for (long i = 0; i < nsamps; i++) {
-    cur = isig_a[i];
-    isig_a[i] = cur + preemphasis_d * pre;
-    pre = cur;
-    // fprintf(stdout, "isig updated at %d -> %f\n", i, isig_a[i]);
+// method: check_analysis
+//
+// arguments: none
+//
+// return: a boolean indicating status
+//
+// This method makes sure the right analysis parameters are set. to keep
+// things simple, we currently only support these configurations:
+//    window duration >= frame duration
+//    right-aligned windows
+//
+bool Mplpc::check_analysis() {
+
+  if (win_align_d != Mplpc::WNAL_RIGHT) {
+    return false;
   }
-  
-  // declare a buffer to use for windowing and clear it
+  else if (frame_duration_d > window_duration_d) {
+    return false;
+  }
+  else if (debias_mode_d == Mplpc::DBS_WINDOW) {
+    return false;
+  }
+
+  // exit gracefully
   //
-  VectorDouble sig_pbuf(n_wdur, (double)0);
-  
-  // loop over the signal by frames
+  return true;
+}
+
+// method: compute_frames
+//
+// arguments:
+//  MplpcWork& work: frame workspace of the calling thread (scratch)
+//  MplpcPulses& osig: pulses (output)
+//  const double* isig: signal (input)
+//  double bias: value debiasing removes from the signal (input)
+//  long off: index of the first sample of the first frame in isig (input)
+//  long avail: number of samples available in isig from off (input)
+//  long frame: index of the first frame (input)
+//  long num_frames: number of frames to analyze (input)
+//  bool split: split the frames among the worker threads (input)
+//
+// return: a boolean indicating status
+//
+// This method analyzes consecutive frames of a channel. Frames only
+// depend on the signal, from which each one reads its window history
+// in place, so when split is set the frames are cut
+// into SPLIT_BLOCKS blocks per thread that are analyzed in parallel.
+// Each block collects its pulses separately and the blocks are joined
+// in order, so the pulses are the same as a serial analysis gives.
+// split must only be set by a caller that is not itself a task of
+// run_workers.
+//
+template <class P>
+bool Mplpc::compute_frames(MplpcWork& work_a, MplpcPulses& osig_a,
+			   const double* isig_a, double bias_a, long off_a,
+			   long avail_a, long frame_a, long num_frames_a,
+			   bool split_a) {
+
+  // declare local variables
   //
-  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-    fprintf(stdout, "   Mplpc::compute_mplpc(): looping over frames\n");
+  bool status = true;
+  long n_fdur = round(frame_duration_d * sample_freq_d);
+  long num_blocks = 1;
+  if (split_a && (num_threads_d > 1)) {
+    num_blocks = std::min(num_frames_a, num_threads_d * SPLIT_BLOCKS);
   }
-  for (long i = 0; i < num_frames; i++) {
 
-    // resize the output signal to make room for the output data
-    //
-    //edf_d.resize(osig_a[i], out_dim);
-    
-    // compute the start and end indexes of the frame and window in the signal
-    //
-    long n_offset = n_wdur - n_fdur;
-    long i_frame_beg = i * n_fdur;
-   
-    // copy the newest data to the front of the window
-    //
-    if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-      fprintf(stdout, "   Mplpc::compute_mplpc(): copying data\n");
+  // case 1: analyze the frames in order
+  //
+  if (num_blocks <= 1) {
+    for (long i = 0; i < num_frames_a; i++) {
+      status = Mplpc::compute_frame<P>(work_a, osig_a, isig_a, bias_a,
+				       off_a + i * n_fdur,
+				       avail_a - i * n_fdur, frame_a + i);
     }
-    long n = n_offset;
-    long m = i_frame_beg;
-    for (long j = 0; j < n_fdur; j++) {
-      sig_pbuf[n] = isig_a[m];
-       n++;
-       m++;
-     }
+    return status;
+  }
 
-    // step 3: Hamming window the data
-    //
-    if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-      fprintf(stdout, "   Mplpc::compute_mplpc(): windowing data\n");
+  // case 2: analyze blocks of frames in parallel
+  //
+  std::vector<MplpcPulses> parts(num_blocks);
+  status = Mplpc::run_workers(num_blocks, [&](long b, long w) {
+    MplpcWork* work = Mplpc::get_work(w);
+    if (work == (MplpcWork*)NULL) {
+      return false;
     }
-    VectorDouble sig_wbuf(n_wdur, (double)0.0);
-    for (long j = 0; j < n_wdur; j++) {
-      sig_wbuf[j] = sig_pbuf[j] * win_fct_d[j];
+    long i_beg = num_frames_a * b / num_blocks;
+    long i_end = num_frames_a * (b + 1) / num_blocks;
+    bool block_status = true;
+    parts[b].reserve((i_end - i_beg) * num_pulses_d);
+    for (long i = i_beg; i < i_end; i++) {
+      block_status = Mplpc::compute_frame<P>(*work, parts[b], isig_a,
+					     bias_a, off_a + i * n_fdur,
+					     avail_a - i * n_fdur,
+					     frame_a + i);
     }
+    return block_status;
+  });
 
-    // step 4: autocorrelation computation
-    //
-    if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-      fprintf(stdout, "   Mplpc::compute_mplpc(): autocorrelation\n");
-    }
-    VectorDouble autocor;
-    status = compute_autocor(autocor, sig_wbuf, lp_order_d);
+  // join the blocks
+  //
+  for (long b = 0; b < num_blocks; b++) {
+    osig_a.append(parts[b]);
+  }
 
-    // step 5: linear prediction computation
-    //
-    if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-      fprintf(stdout, "   Mplpc::compute_mplpc(): linear prediction\n");
-    }
-    VectorDouble rc;
-    VectorDouble pc;
-    status = compute_lpc(rc, pc, autocor, lp_order_d);
-      
-    // step 6: compute impulse response and the energy of the impulse response
-    //
-    if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-      fprintf(stdout, "   Mplpc::compute_mplpc(): impulse response\n");
-    }
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: compute_frame
+//
+// arguments:
+//  MplpcWork& work: frame workspace (scratch)
+//  MplpcPulses& osig: pulses (output)
+//  const double* isig: signal (input)
+//  double bias: value debiasing removes from the signal (input)
+//  long off: index of the first sample of the frame in isig (input)
+//  long avail: number of samples available in isig from off (input)
+//  long i: frame index (input)
+//
+// return: a boolean indicating status
+//
+// This method analyzes one frame: it windows the data, computes the
+// lpc model and impulse response and finds the pulses. The frame is
+// read from isig starting at off, which lets a signal be processed in
+// pieces as long as window_lookback() + 1 samples of history are kept
+// before off. The samples are debiased and preemphasized as they are
+// read. The pulse search looks n_impres samples past the end of the
+// frame when at least that many are available. All intermediate
+// results live in the workspace buffers of the policy's sample type,
+// which must have been sized by get_work.
+//
+template <class P>
+bool Mplpc::compute_frame(MplpcWork& work_a, MplpcPulses& osig_a,
+			  const double* isig_a, double bias_a, long off_a,
+			  long avail_a, long i) {
+
+  // declare local variables
+  //
+  typedef typename P::sample_t sample_t;
+  typedef typename P::accum_t accum_t;
+  MplpcBuffers<sample_t>& bufs = work_a.get_buffers<sample_t>();
+  bool status = true;
+  long n_fdur = round(frame_duration_d * sample_freq_d);
+  long n_wdur = round(window_duration_d * sample_freq_d);
+  long n_impres = round(impres_dur_d * sample_freq_d);
+
+  // check the debug level once per frame
+  //
+  bool dbg_stages = (debug_level_d >= Dbgl::LEVEL_DETAILED);
+  MplpcProfile* prof = profile_d ? &work_a.prof_d : (MplpcProfile*)NULL;
+  long long prof_t = prof ? MplpcTrace::now() : 0;
+  MPLPC_TRACE_START(trace_t);
+
+  // step 3: preemphasize and Hamming window the data. the scalar
+  // code computes the autocorrelation in the same sweep.
+  //
+  if (dbg_stages) {
+    fprintf(stdout, "   Mplpc::compute_frame(): windowing data\n");
+  }
+  sample_t* sig_wbuf = bufs.wbuf_d;
+  sample_t* autocor = bufs.autocor_d;
+  bool fused = (simd_mode_d == Mplpc::SIMD_NONE);
+  status = window_frame<P>(sig_wbuf, fused ? autocor : (sample_t*)NULL,
+			   isig_a, bias_a, off_a, i);
+  MPLPC_TRACE_LAP(trace_t, "window");
+  if (prof) {
+    prof->lap(MplpcProfile::WINDOW, prof_t);
+  }
+
+  // step 4: autocorrelation computation
+  //
+  if (dbg_stages) {
+    fprintf(stdout, "   Mplpc::compute_frame(): autocorrelation\n");
+  }
+  if (!fused) {
+    status = compute_autocor<P>(autocor, sig_wbuf, n_wdur, lp_order_d);
+  }
+  MPLPC_TRACE_LAP(trace_t, "autocor");
+  if (prof) {
+    prof->lap(MplpcProfile::AUTOCOR, prof_t);
+  }
+
+  // step 5: linear prediction computation
+  //
+  if (dbg_stages) {
+    fprintf(stdout, "   Mplpc::compute_frame(): linear prediction\n");
+  }
+  sample_t* pc = bufs.pc_d;
+  status = compute_lpc<P>(bufs.rc_d, pc, autocor, lp_order_d);
+  MPLPC_TRACE_LAP(trace_t, "lpc");
+  if (prof) {
+    prof->lap(MplpcProfile::LPC, prof_t);
+  }
+
+  // step 6: compute impulse response and the energy of the impulse response
+  //
+  if (dbg_stages) {
+    fprintf(stdout, "   Mplpc::compute_frame(): impulse response\n");
+  }
 
-    VectorDouble impres;
-    status = compute_impulse_response(impres, pc, n_impres);
-    float impres_egy = 0;
+  sample_t* impres = bufs.impres_d;
+  status = compute_impulse_response<P>(impres, bufs.filt_d, pc,
+				       lp_order_d + 1, n_impres);
+  accum_t impres_egy = 0;
+  if (simd_mode_d != Mplpc::SIMD_NONE) {
+    impres_egy = kern_dot(impres, impres, n_impres);
+  }
+  else {
     for (long j = 0; j < n_impres; j++) {
       impres_egy += impres[j] * impres[j];
     }
+  }
+  MPLPC_TRACE_LAP(trace_t, "impres");
+  if (prof) {
+    prof->lap(MplpcProfile::IMPRES, prof_t);
+  }
 
-    // step 7: transfer a chunk of the signal into a temporary buffer
-    //         so we can work on it without corrupting future frames.
-    //         this buffer needs to be larger than a frame so pulses
-    //         at the edge of a frame can be accurately loaded. we are
-    //         going to find a pulse, subtract out its effect from this
-    //         tmp signal, and find the next pulse.
-    //
-    if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-      fprintf(stdout, "   Mplpc::compute_mplpc(): copying signal\n");
-    }
+  // step 7: transfer a chunk of the signal into a temporary buffer
+  //         so we can work on it without corrupting future frames.
+  //         this buffer needs to be larger than a frame so pulses
+  //         at the edge of a frame can be accurately loaded. we are
+  //         going to find a pulse, subtract out its effect from this
+  //         tmp signal, and find the next pulse.
+  //
+  if (dbg_stages) {
+    fprintf(stdout, "   Mplpc::compute_frame(): copying signal\n");
+  }
 
-    long sig_tmp_len = n_fdur + n_impres;
-    long sig_tmp_off = i_frame_beg;        
-    VectorDouble sig_tmp(sig_tmp_len, (double)0.0);
+  long sig_tmp_size = n_fdur + n_impres;
+  long sig_tmp_len = sig_tmp_size;
+  sample_t* sig_tmp = bufs.tmp_d;
 
-    // check if the loop will exceed the nsamples
-    // if the sig_tmp_off exceeds nsamps we set the
-    // value of sig_tmp_len to the nfdur
-    //
-    if ((sig_tmp_off + sig_tmp_len)> nsamps){
-      sig_tmp_len = n_fdur;
-    }
+  // check if the loop will exceed the nsamples
+  // if the sig_tmp_off exceeds nsamps we set the
+  // value of sig_tmp_len to the nfdur
+  //
+  if (sig_tmp_len > avail_a){
+    sig_tmp_len = n_fdur;
+  }
 
-    for (long j = 0; j < sig_tmp_len; j++) {
-      // if (sig_tmp_off < nsamps) {
-	sig_tmp[j] = isig_a[sig_tmp_off];
-	sig_tmp_off++;
-	//      }
-    }
+  // the chunk is preemphasized as it is copied
+  //
+  preemphasize<P>(sig_tmp, isig_a + off_a, bias_a, sig_tmp_len, i == 0,
+		  (const sample_t*)NULL);
+  for (long j = sig_tmp_len; j < sig_tmp_size; j++) {
+    sig_tmp[j] = 0.0;
+  }
+  MPLPC_TRACE_LAP(trace_t, "copy");
+
+  // step 8: loop over all the pulses
+  //
+  if (dbg_stages) {
+    fprintf(stdout, "   Mplpc::compute_frame(): finding pulses\n");
+  }
+  status = compute_pulses<P>(work_a, osig_a, sig_tmp, impres_egy, i);
+  MPLPC_TRACE_LAP(trace_t, "search");
+  if (prof) {
+    prof->lap(MplpcProfile::SEARCH, prof_t);
+    prof->nframes_d++;
+  }
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: compute_pulses
+//
+// arguments:
+//  MplpcWork& work: frame workspace holding the impulse response (input)
+//  MplpcPulses& osig: pulses (output)
+//  sample_t* sig_tmp: n_fdur + n_impres samples starting at the frame
+//                     (input, modified by the full search)
+//  accum_t impres_egy: energy of the impulse response (input)
+//  long i: frame index (input)
+//
+// return: a boolean indicating status
+//
+// This method is step 8 of the frame analysis: it finds num_pulses_d
+// pulses in one frame by repeatedly locating the peak of the
+// crosscorrelation between the signal and the impulse response and
+// removing that pulse's contribution.
+//
+template <class P>
+bool Mplpc::compute_pulses(MplpcWork& work_a, MplpcPulses& osig_a,
+			   typename P::sample_t* sig_tmp,
+			   typename P::accum_t impres_egy, long i) {
+
+  // declare local variables
+  //
+  typedef typename P::sample_t sample_t;
+  typedef typename P::accum_t accum_t;
+  MplpcBuffers<sample_t>& bufs = work_a.get_buffers<sample_t>();
+  bool status = true;
+  long n_fdur = round(frame_duration_d * sample_freq_d);
+  long n_impres = round(impres_dur_d * sample_freq_d);
+  long sig_tmp_size = n_fdur + n_impres;
+  long i_frame_beg = i * n_fdur;
+  sample_t* impres = bufs.impres_d;
+  bool dbg_pulses = (debug_level_d > Dbgl::LEVEL_BRIEF);
+
+  // the incremental search computes the crosscorrelation once per frame
+  // and, after each pulse is found, updates it in place using the
+  // autocorrelation of the impulse response:
+  //
+  //  crosscor'[k] = crosscor[k] - gain * impres_acor[|k - max_loc|]
+  //
+  // this is the same as subtracting the pulse from sig_tmp and
+  // recomputing, since sig_tmp always extends n_impres samples past
+  // the last candidate location.
+  //
+  sample_t* crosscor = bufs.ccor_d;
+  sample_t* impres_acor = bufs.hacor_d;
+  if (search_mode_d == Mplpc::SRCH_INCR) {
+    status = compute_crosscor<P>(crosscor, sig_tmp, sig_tmp_size, impres,
+				 n_impres, n_fdur);
+    status = compute_crosscor<P>(impres_acor, impres, n_impres, impres,
+				 n_impres, n_impres);
+  }
 
-    // step 8: loop over all the pulses
+  for (long j = 0; j < num_pulses_d; j++) {
+
+    // step 8a: find the maximum in the crosscorrelation function
     //
-    if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-      fprintf(stdout, "   Mplpc::compute_mplpc(): finding pulses\n");
-    }
+    long max_loc = (long)0;
+    accum_t max_val = (accum_t)0.0;
 
-    for (long j = 0; j < num_pulses_d; j++) {
+    if (search_mode_d == Mplpc::SRCH_INCR) {
+      sample_t max_cc = 0.0;
+      for (long k = 0; k < n_fdur; k++) {
+	if (fabs(crosscor[k]) > fabs(max_cc)) {
+	  max_cc = crosscor[k];
+	  max_loc = k;
+	}
+      }
+      max_val = max_cc;
+    }
+    else if (simd_mode_d != Mplpc::SIMD_NONE) {
 
-      // step 8a: find the maximum in the crosscorrelation function
+      // sig_tmp always holds n_fdur + n_impres samples, so the
+      // crosscorrelation never runs off the end of the buffer
       //
-      long max_loc = (long)0;
-      float max_val = (float)0.0;
-
+      for (long k = 0; k < n_fdur; k++) {
+	sample_t sum = kern_dot(sig_tmp + k, impres, n_impres);
+	if (fabs(sum) > fabs(max_val)) {
+	  max_val = sum;
+	  max_loc = k;
+	}
+      }
+    }
+    else {
       for (long k = 0; k < n_fdur; k++) {
 
 	// compute the crosscorrelation: make sure we don't go over the end
 	// of the signal buffer
 	//
-	float sum = (float)0.0;
+	accum_t sum = (accum_t)0.0;
 	long cc_off = k;
 	
 	for (long l = 0; l < n_impres; l++) {
-	  if (cc_off < sig_tmp.size()) {
+	  if (cc_off < sig_tmp_size) {
 	    sum += sig_tmp[cc_off] * impres[l];
 	    cc_off++;
 	  }
 	}
-      
+
 	// find the maximum: note we must preserve the sign, so we
 	// have to take the absolute value
 	//
@@ -578,46 +1289,47 @@ bool Mplpc::compute_mplpc(VVectorDouble& osig_a, VectorDouble& isig_a) {
 	  max_loc = k;
 	}
       }
+    }
 
-      // compute the gain of the pulse: crosscorrelation / energy
-      //
-      float gain = max_val / impres_egy;
-      // fprintf(stdout, " max_value and impulse resp energy is: %f and %f\n", max_val, impres_egy);
+    // compute the gain of the pulse: crosscorrelation / energy
+    //
+    accum_t gain = max_val / impres_egy;
+    // fprintf(stdout, " max_value and impulse resp energy is: %f and %f\n", max_val, impres_egy);
 
-      // subtract off the effects of the pulse
-      //
+    // subtract off the effects of the pulse: the incremental search
+    // only needs to touch the lags that overlap the pulse
+    //
+    if (search_mode_d == Mplpc::SRCH_INCR) {
+      long k_beg = max_loc - n_impres + 1;
+      long k_end = max_loc + n_impres;
+      if (k_beg < 0) {
+	k_beg = 0;
+      }
+      if (k_end > n_fdur) {
+	k_end = n_fdur;
+      }
+      for (long k = k_beg; k < k_end; k++) {
+	crosscor[k] -= gain * impres_acor[labs(k - max_loc)];
+      }
+    }
+    else {
       long m = max_loc;
 
       for (long k = 0; k < n_impres; k++) {
-	  sig_tmp[m] -= gain * impres[k];
+	sig_tmp[m] -= gain * impres[k];
 	m++;
       }
-
-      // output the pulse location and amplitude
-      //
-      if (debug_level_d > Dbgl::LEVEL_BRIEF) {
-	fprintf(stdout, "frame no: %d, pulse no. %d, loc/amp = (%d, %f)\n",
-		i, j, i_frame_beg + max_loc, max_val);
-      }
-      // fprintf(stdout, "osig index is %d\n", i);
-      // fprintf(stdout, "index for osig is: %d\n", (int) i_frame_beg + max_loc); 
-      osig_a[i_frame_beg + max_loc][0] += gain;
-      // osig_a[i_frame_beg + max_loc][0] += max_val;
-      
-      // fprintf(stdout, "osig value at index %d is: %f", i, osig_a[i_frame_beg + max_loc][0]); 
     }
 
-    // shift the window:
-    //  we should really do a block move here
+    // output the pulse location and amplitude
     //
-    if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-      fprintf(stdout, "   Mplpc::compute_mplpc(): shifting the signal\n");
-    }
-    long num_to_shift = n_wdur - n_fdur;
-    long k = n_fdur - 1;
-    for (long j = 0; j < num_to_shift; j++) {
-      sig_pbuf[j] = sig_pbuf[k++];
+    if (dbg_pulses) {
+      fprintf(stdout, "frame no: %d, pulse no. %d, loc/amp = (%d, %f)\n",
+	      i, j, i_frame_beg + max_loc, max_val);
     }
+    // fprintf(stdout, "osig index is %d\n", i);
+    // fprintf(stdout, "index for osig is: %d\n", (int) i_frame_beg + max_loc); 
+    osig_a.add(i_frame_beg + max_loc, gain, i);
   }
 
   // exit gracefully
@@ -625,5 +1337,828 @@ bool Mplpc::compute_mplpc(VVectorDouble& osig_a, VectorDouble& isig_a) {
   return status;
 }
 
+// method: window_frame
+//
+// arguments:
+//  sample_t* wbuf: windowed data, n_wdur values (output)
+//  sample_t* autocor: autocorrelation, lp_order + 1 values, or NULL
+//                     to leave it to compute_autocor (output)
+//  const double* sig: signal (input)
+//  double bias: value debiasing removes from the signal (input)
+//  long off: index of the first sample of the frame in sig (input)
+//  long i: frame index (input)
+//
+// return: a boolean indicating status
+//
+// This method applies the window function to the analysis window of a
+// frame, reading the window straight out of the signal rather than
+// from a copy of it. The last n_fdur samples of the window are the
+// frame itself. The samples before them reproduce the window history
+// buffer this analysis has always used, which is shifted by n_fdur - 1
+// samples (not n_fdur) from one frame to the next. Going back t frames
+// therefore moves a sample t positions, and window sample j < n_offset
+// holds:
+//
+//  sig[off - n_offset + j - t],  t = ceil((n_offset - j) / (n_fdur - 1))
+//
+// or zero when t > i, since the buffer started out cleared. For each t
+// this is a contiguous piece of the signal. The pieces are produced
+// oldest first, each one debiased, preemphasized and windowed in a
+// single pass, and when autocor is given each is added to the lags of
+// the autocorrelation while it is still in cache (see
+// accumulate_autocor). The result is the same as compute_autocor on
+// the finished window in the scalar mode.
+//
+template <class P>
+bool Mplpc::window_frame(typename P::sample_t* wbuf_a,
+			 typename P::sample_t* autocor_a, const double* sig_a,
+			 double bias_a, long off_a, long i) {
+
+  // declare local variables
+  //
+  typedef typename P::sample_t sample_t;
+  typedef typename P::accum_t accum_t;
+  long n_fdur = round(frame_duration_d * sample_freq_d);
+  long n_wdur = round(window_duration_d * sample_freq_d);
+  long n_offset = n_wdur - n_fdur;
+  long step = n_fdur - 1;
+  long first = off_a - i * n_fdur;
+  const sample_t* win = get_window<sample_t>();
+
+  // clear the lags
+  //
+  if (autocor_a != (sample_t*)NULL) {
+    for (long k = 0; k <= lp_order_d; k++) {
+      autocor_a[k] = 0.0;
+    }
+  }
+
+  // whatever precedes the start of the signal is zero. the terms are
+  // still added, so the sums are exactly those of the whole window.
+  //
+  long j_sig = n_offset;
+  long t_max = 0;
+  if (step > 0) {
+    t_max = std::min(i, (n_offset + step - 1) / step);
+    j_sig = std::max(n_offset - t_max * step, 0L);
+  }
+  for (long j = 0; j < j_sig; j++) {
+    wbuf_a[j] = 0.0;
+  }
+  if (autocor_a != (sample_t*)NULL) {
+    accumulate_autocor<P>(autocor_a, wbuf_a, 0, j_sig, lp_order_d);
+  }
+
+  // window the history, oldest piece first, and then the frame. the
+  // products are exact, so this gives the same result as the kernels
+  // in every simd mode.
+  //
+  for (long t = t_max; t >= 0; t--) {
+    long j_beg = (t > 0) ? std::max(n_offset - t * step, 0L) : n_offset;
+    long j_end = (t > 0) ? n_offset - (t - 1) * step : n_wdur;
+    long n = off_a - n_offset + j_beg - t;
+    preemphasize<P>(wbuf_a + j_beg, sig_a + n, bias_a, j_end - j_beg,
+		    n == first, win + j_beg);
+    if (autocor_a != (sample_t*)NULL) {
+      accumulate_autocor<P>(autocor_a, wbuf_a, j_beg, j_end, lp_order_d);
+    }
+  }
+
+  // scale the lags
+  //
+  if (autocor_a != (sample_t*)NULL) {
+    accum_t N_1 = 1.0 / (accum_t)n_wdur;
+    for (long k = 0; k <= lp_order_d; k++) {
+      autocor_a[k] = (accum_t)autocor_a[k] * N_1;
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: preemphasize
+//
+// arguments:
+//  sample_t* osig: preemphasized signal, n values (output)
+//  const double* isig: signal, from the first sample to convert (input)
+//  double bias: value debiasing removes from the signal (input)
+//  long n: number of samples (input)
+//  bool first: isig starts at the first sample of the signal, so
+//              there is no isig[-1] (input)
+//  const sample_t* win: window to apply, or NULL (input)
+//
+// return: none
+//
+// This method debiases and preemphasizes a piece of the signal in the
+// precision of the policy P, optionally multiplying it by a window.
+// Every sample is computed as a whole-signal pass would have, so any
+// piece can be converted on its own.
+//
+template <class P>
+void Mplpc::preemphasize(typename P::sample_t* osig_a, const double* isig_a,
+			 double bias_a, long n_a, bool first_a,
+			 const typename P::sample_t* win_a) {
+
+  // declare local variables
+  //
+  typedef typename P::sample_t sample_t;
+  typedef typename P::accum_t accum_t;
+  accum_t pre = first_a ? (accum_t)0.0 : (accum_t)(isig_a[-1] - bias_a);
+  accum_t cur = 0.0;
+
+  // convert the samples
+  //
+  if (win_a == (const sample_t*)NULL) {
+    for (long j = 0; j < n_a; j++) {
+      cur = isig_a[j] - bias_a;
+      osig_a[j] = cur + preemphasis_d * pre;
+      pre = cur;
+    }
+    return;
+  }
+  for (long j = 0; j < n_a; j++) {
+    cur = isig_a[j] - bias_a;
+    sample_t val = cur + preemphasis_d * pre;
+    osig_a[j] = val * win_a[j];
+    pre = cur;
+  }
+}
+
+// method: window_lookback
+//
+// arguments: none
+//
+// return: the number of samples of history window_frame reads before
+//         the start of a frame. preemphasis needs one sample more.
+//
+long Mplpc::window_lookback() {
+
+  // declare local variables
+  //
+  long n_fdur = round(frame_duration_d * sample_freq_d);
+  long n_wdur = round(window_duration_d * sample_freq_d);
+  long n_offset = n_wdur - n_fdur;
+
+  // with a one sample frame the history is never updated
+  //
+  if ((n_fdur <= 1) || (n_offset <= 0)) {
+    return 0;
+  }
+
+  // exit gracefully: the oldest sample is t = ceil(n_offset / (n_fdur - 1))
+  // positions before the start of the window
+  //
+  return n_offset + (n_offset + n_fdur - 2) / (n_fdur - 1);
+}
+
+// method: get_work
+//
+// arguments:
+//  long worker: index of the workspace (input)
+//
+// return: a pointer to the workspace, or NULL on error
+//
+// This method returns the frame workspace of a worker, with the buffers
+// of the selected precision sized for the current analysis parameters.
+// Sizing only allocates when a workspace has to grow, so this is cheap
+// enough to call per block.
+//
+MplpcWork* Mplpc::get_work(long worker_a) {
+
+  // check the index: workspaces are only added by run_workers
+  //
+  if ((worker_a < 0) || (worker_a >= (long)work_d.size())) {
+    fprintf(stdout,
+	    "**> error in Mplpc::get_work(): no workspace [%ld]\n", worker_a);
+    return (MplpcWork*)NULL;
+  }
+
+  // size the workspace
+  //
+  long n_fdur = round(frame_duration_d * sample_freq_d);
+  long n_wdur = round(window_duration_d * sample_freq_d);
+  long n_impres = round(impres_dur_d * sample_freq_d);
+  if (precision_d == Mplpc::PREC_FLOAT) {
+    work_d[worker_a].flt_d.resize(lp_order_d, n_wdur, n_fdur, n_impres);
+  }
+  else {
+    work_d[worker_a].resize(lp_order_d, n_wdur, n_fdur, n_impres);
+  }
+
+  // exit gracefully
+  //
+  return &work_d[worker_a];
+}
+
+// method: get_split_work
+//
+// arguments:
+//  long worker: index of the workspace, or ALL_WORKERS (input)
+//  bool& split: whether the frames are to be split among the worker
+//               threads (output)
+//
+// return: a pointer to the workspace of the calling thread, or NULL on
+//         error
+//
+// This method resolves the worker argument of the single channel
+// methods. ALL_WORKERS means the caller is not a worker thread and
+// wants the frames split among the threads: it then analyzes with the
+// first workspace, and a workspace is made for every thread up front
+// so that run_workers never moves the one the caller holds.
+//
+MplpcWork* Mplpc::get_split_work(long worker_a, bool& split_a) {
+
+  split_a = (worker_a == Mplpc::ALL_WORKERS);
+  if (split_a) {
+    worker_a = 0;
+    if ((long)work_d.size() < num_threads_d) {
+      work_d.resize(num_threads_d);
+    }
+  }
+
+  // exit gracefully
+  //
+  return Mplpc::get_work(worker_a);
+}
+
+// method: run_workers
+//
+// arguments:
+//  long num_tasks: number of tasks (input)
+//  const std::function<bool(long, long)>& task: function that runs a
+//   task (input)
+//
+// return: a boolean indicating status
+//
+// This method runs task(0, w) .. task(num_tasks - 1, w). When
+// num_threads_d > 1 the tasks are handed out to a pool of worker
+// threads (see MplpcPool), each of which pulls the next unclaimed task
+// until all tasks have been claimed. The tasks must be independent. w is the index of
+// the worker running the task, which the task uses to pick a frame
+// workspace. The return value is false if any task failed.
+//
+bool Mplpc::run_workers(long num_tasks_a,
+			const std::function<bool(long, long)>& task_a) {
+
+  // compute the number of workers: there is no point in having more
+  // workers than tasks
+  //
+  long num_workers = num_threads_d;
+  if (num_workers > num_tasks_a) {
+    num_workers = num_tasks_a;
+  }
+
+  // make sure there is a workspace for each worker: this has to
+  // happen before any worker starts
+  //
+  if ((long)work_d.size() < num_workers) {
+    work_d.resize(num_workers);
+  }
+
+  // case 1: serial processing - stop at the first failure
+  //
+  if (num_workers <= 1) {
+    for (long i = 0; i < num_tasks_a; i++) {
+      if (!task_a(i, 0)) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  // case 2: parallel processing
+  //
+  return pool_d.run(num_workers, num_tasks_a, task_a);
+}
+
+// method: compute_mplpc_open
+//
+// arguments:
+//  MplpcState& state: analysis state (output)
+//  MplpcPulses& osig: pulses (output)
+//  double bias: value to subtract from every sample (input)
+//
+// return: a boolean indicating status
+//
+// This method starts a block-by-block analysis of a single channel.
+// Since debiasing needs the mean of the whole signal, the caller
+// supplies it as bias (e.g., from a prescan of the signal).
+//
+bool Mplpc::compute_mplpc_open(MplpcState& state_a, MplpcPulses& osig_a,
+			       double bias_a) {
+
+  // make sure the right analysis parameters are set
+  //
+  if (!Mplpc::check_analysis()) {
+    return false;
+  }
+
+  // initialize the state: this mirrors the start of compute_mplpc
+  //
+  state_a.bias_d = bias_a;
+  state_a.pend_d.clear();
+  state_a.pos_d = 0;
+  state_a.frame_d = 0;
+  state_a.nsamps_d = 0;
+  osig_a.clear();
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: compute_mplpc_block
+//
+// arguments:
+//  MplpcState& state: analysis state (input/output)
+//  MplpcPulses& osig: pulses (output)
+//  const VectorDouble& isig: the next block of the signal (input)
+//  long worker: index of the frame workspace to use, or ALL_WORKERS
+//               to split the frames among the worker threads (input)
+//
+// return: a boolean indicating status
+//
+// This method appends a block of samples to the samples still pending
+// from previous blocks and analyzes every frame whose pulse search
+// window (n_fdur + n_impres samples) is complete. Those frames see
+// exactly the data compute_mplpc would give them, so the block size
+// does not change the result. The pending samples keep
+// window_lookback() + 1 samples of history before the next frame so
+// its window can be read and preemphasized in place. The input is not
+// modified.
+//
+bool Mplpc::compute_mplpc_block(MplpcState& state_a, MplpcPulses& osig_a,
+				const VectorDouble& isig_a, long worker_a) {
+
+  // time the whole block
+  //
+  MPLPC_TRACE_SCOPE("block");
+
+  // get a frame workspace: blocks of one channel can be analyzed by
+  // different workers, since nothing in it carries over between frames
+  //
+  bool split = false;
+  MplpcWork* work = Mplpc::get_split_work(worker_a, split);
+  if (work == (MplpcWork*)NULL) {
+    return false;
+  }
+
+  // analyze the block with the selected precision policy
+  //
+  if (precision_d == Mplpc::PREC_FLOAT) {
+    return Mplpc::compute_mplpc_block<MplpcFloat>(state_a, osig_a, isig_a,
+						  *work, split);
+  }
+  else if (precision_d == Mplpc::PREC_DOUBLE) {
+    return Mplpc::compute_mplpc_block<MplpcDouble>(state_a, osig_a, isig_a,
+						   *work, split);
+  }
+  return Mplpc::compute_mplpc_block<MplpcMixed>(state_a, osig_a, isig_a,
+						*work, split);
+}
+
+// method: compute_mplpc_block
+//
+// arguments:
+//  MplpcState& state: analysis state (input/output)
+//  MplpcPulses& osig: pulses (output)
+//  const VectorDouble& isig: the next block of the signal (input)
+//  MplpcWork& work: frame workspace, sized by get_work (scratch)
+//  bool split: split the frames among the worker threads (input)
+//
+// return: a boolean indicating status
+//
+// This method is the block analysis in the precision of the policy P.
+//
+template <class P>
+bool Mplpc::compute_mplpc_block(MplpcState& state_a, MplpcPulses& osig_a,
+				const VectorDouble& isig_a, MplpcWork& work_a,
+				bool split_a) {
+
+  // declare local variables
+  //
+  MplpcWork* work = &work_a;
+  bool status = true;
+  long n_fdur = round(frame_duration_d * sample_freq_d);
+  long n_impres = round(impres_dur_d * sample_freq_d);
+  long nsamps = isig_a.size();
+
+  // append the block
+  //
+  long long prof_t = profile_d ? MplpcTrace::now() : 0;
+  VectorDouble& pend = state_a.pend_d;
+  pend.insert(pend.end(), isig_a.begin(), isig_a.end());
+  state_a.nsamps_d += nsamps;
+  if (profile_d) {
+    work->prof_d.lap(MplpcProfile::PREEMPH, prof_t);
+    work->prof_d.nsamps_d += nsamps;
+  }
+
+  // analyze every frame that has its full lookahead
+  //
+  long off = state_a.pos_d;
+  long avail = (long)pend.size() - off;
+  long num_frames = 0;
+  if (avail >= n_fdur + n_impres) {
+    num_frames = (avail - n_fdur - n_impres) / n_fdur + 1;
+  }
+  status = Mplpc::compute_frames<P>(*work, osig_a, pend.data(),
+				    state_a.bias_d, off, avail, state_a.frame_d,
+				    num_frames, split_a);
+  state_a.frame_d += num_frames;
+  off += num_frames * n_fdur;
+
+  // discard the samples that are no longer needed
+  //
+  long keep = std::min(off, Mplpc::window_lookback() + 1);
+  pend.erase(pend.begin(), pend.begin() + (off - keep));
+  state_a.pos_d = keep;
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: compute_mplpc_close
+//
+// arguments:
+//  MplpcState& state: analysis state (input/output)
+//  MplpcPulses& osig: pulses (output)
+//  long worker: index of the frame workspace to use (input)
+//
+// return: a boolean indicating status
+//
+// This method finishes a block-by-block analysis: the frames at the end
+// of the signal are analyzed with whatever lookahead is left, as in
+// compute_mplpc.
+//
+bool Mplpc::compute_mplpc_close(MplpcState& state_a, MplpcPulses& osig_a,
+				long worker_a) {
+
+  // get a frame workspace
+  //
+  MplpcWork* work = Mplpc::get_work(worker_a);
+  if (work == (MplpcWork*)NULL) {
+    return false;
+  }
+
+  // finish the analysis with the selected precision policy
+  //
+  if (precision_d == Mplpc::PREC_FLOAT) {
+    return Mplpc::compute_mplpc_close<MplpcFloat>(state_a, osig_a, *work);
+  }
+  else if (precision_d == Mplpc::PREC_DOUBLE) {
+    return Mplpc::compute_mplpc_close<MplpcDouble>(state_a, osig_a, *work);
+  }
+  return Mplpc::compute_mplpc_close<MplpcMixed>(state_a, osig_a, *work);
+}
+
+// method: compute_mplpc_close
+//
+// arguments:
+//  MplpcState& state: analysis state (input/output)
+//  MplpcPulses& osig: pulses (output)
+//  MplpcWork& work: frame workspace, sized by get_work (scratch)
+//
+// return: a boolean indicating status
+//
+// This method finishes a block analysis in the precision of the policy P.
+//
+template <class P>
+bool Mplpc::compute_mplpc_close(MplpcState& state_a, MplpcPulses& osig_a,
+				MplpcWork& work_a) {
+
+  // declare local variables
+  //
+  MplpcWork* work = &work_a;
+  bool status = true;
+  long n_fdur = round(frame_duration_d * sample_freq_d);
+  VectorDouble& pend = state_a.pend_d;
+
+  // analyze the remaining complete frames
+  //
+  long off = state_a.pos_d;
+  while ((long)pend.size() - off >= n_fdur) {
+    status = Mplpc::compute_frame<P>(*work, osig_a, pend.data(),
+				     state_a.bias_d, off, pend.size() - off,
+				     state_a.frame_d);
+    state_a.frame_d++;
+    off += n_fdur;
+  }
+  pend.clear();
+  state_a.pos_d = 0;
+
+  // record the length of the signal
+  //
+  osig_a.nsamps_d = state_a.nsamps_d;
+  if (profile_d) {
+    work->prof_d.nchans_d++;
+  }
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: compute_mplpc
+//
+// arguments:
+//  VVVectorDouble& osig: signal data (output)
+//  VVectorDouble& isig: signal data (input)
+//
+// return: a boolean indicating status
+//
+// This method processes a multichannel signal and returns the pulses
+// as a dense signal with one feature per sample.
+//
+bool Mplpc::compute_mplpc(VVVectorDouble& osig_a, VVectorDouble& isig_a) {
+
+  // declare local variables
+  //
+  VMplpcPulses pulses;
+
+  // analyze the signal and expand the pulses
+  //
+  if (!Mplpc::compute_mplpc(pulses, isig_a)) {
+    return false;
+  }
+  return Mplpc::expand_pulses(osig_a, pulses);
+}
+
+// method: compute_mplpc
+//
+// arguments:
+//  VVectorDouble& osig: signal data (output)
+//  VectorDouble& isig: signal data (input)
+//
+// return: a boolean indicating status
+//
+// This method processes a single channel and returns the pulses as a
+// dense signal with one feature per sample.
+//
+bool Mplpc::compute_mplpc(VVectorDouble& osig_a, VectorDouble& isig_a) {
+
+  // declare local variables
+  //
+  MplpcPulses pulses;
+
+  // analyze the signal and expand the pulses
+  //
+  if (!Mplpc::compute_mplpc(pulses, isig_a)) {
+    return false;
+  }
+  return Mplpc::expand_pulses(osig_a, pulses);
+}
+
+// method: expand_pulses
+//
+// arguments:
+//  VVVectorDouble& osig: dense signal (output)
+//  VMplpcPulses& isig: pulses for each channel (input)
+//
+// return: a boolean indicating status
+//
+// This method converts a multichannel pulse store to a dense signal
+// with one feature per sample.
+//
+bool Mplpc::expand_pulses(VVVectorDouble& osig_a, VMplpcPulses& isig_a) {
+
+  // loop over all the channels
+  //
+  osig_a.resize(isig_a.size());
+  for (long i = 0; i < (long)isig_a.size(); i++) {
+    Mplpc::expand_pulses(osig_a[i], isig_a[i]);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: expand_pulses
+//
+// arguments:
+//  VVectorDouble& osig: dense signal (output)
+//  MplpcPulses& isig: pulses (input)
+//
+// return: a boolean indicating status
+//
+// This method converts a pulse store to a dense signal with one
+// feature per sample.
+//
+bool Mplpc::expand_pulses(VVectorDouble& osig_a, MplpcPulses& isig_a) {
+
+  // declare local variables
+  //
+  long out_dim = 1;
+
+  // create a zero signal
+  //
+  osig_a.resize(isig_a.nsamps_d);
+  for (long i = 0; i < isig_a.nsamps_d; i++) {
+    osig_a[i].assign(out_dim, (double)0.0);
+  }
+
+  // add in the pulses
+  //
+  for (long i = 0; i < (long)isig_a.size(); i++) {
+    osig_a[isig_a.loc_d[i]][0] += isig_a.gain_d[i];
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: expand_pulses
+//
+// arguments:
+//  VectorDouble& osig: dense signal (output)
+//  MplpcPulses& isig: pulses (input)
+//
+// return: a boolean indicating status
+//
+// This method converts a pulse store to a flat dense signal.
+//
+bool Mplpc::expand_pulses(VectorDouble& osig_a, MplpcPulses& isig_a) {
+
+  // create a zero signal
+  //
+  osig_a.assign(isig_a.nsamps_d, (double)0.0);
+
+  // add in the pulses
+  //
+  for (long i = 0; i < (long)isig_a.size(); i++) {
+    osig_a[isig_a.loc_d[i]] += isig_a.gain_d[i];
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// MplpcPool methods
+//
+//-----------------------------------------------------------------------------
+
+// method: default constructor
+//
+MplpcPool::MplpcPool() {
+  task_d = (const std::function<bool(long, long)>*)NULL;
+  num_workers_d = 0;
+  num_tasks_d = 0;
+  batch_d = 0;
+  busy_d = 0;
+  stop_d = false;
+  next_d = 0;
+  status_d = true;
+}
+
+// method: destructor
+//
+// the threads are idle between batches, so they only have to be woken
+//
+MplpcPool::~MplpcPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_d);
+    stop_d = true;
+  }
+  start_d.notify_all();
+  for (long i = 0; i < (long)threads_d.size(); i++) {
+    threads_d[i].join();
+  }
+}
+
+// method: run
+//
+// arguments:
+//  long num_workers: number of workers, including the caller (input)
+//  long num_tasks: number of tasks (input)
+//  const std::function<bool(long, long)>& task: function that runs a
+//   task (input)
+//
+// return: a boolean indicating status
+//
+// This method runs a batch of tasks on num_workers workers, starting
+// threads the first time a batch needs more than there are, and returns
+// when all the tasks are done. The return value is false if any task
+// failed.
+//
+bool MplpcPool::run(long num_workers_a, long num_tasks_a,
+		    const std::function<bool(long, long)>& task_a) {
+
+  // start the batch, and any threads it needs that aren't running
+  //
+  {
+    std::lock_guard<std::mutex> lock(mutex_d);
+    while ((long)threads_d.size() < num_workers_a - 1) {
+      threads_d.push_back(std::thread(&MplpcPool::run_thread, this,
+				      (long)threads_d.size() + 1, batch_d));
+    }
+    task_d = &task_a;
+    num_workers_d = num_workers_a;
+    num_tasks_d = num_tasks_a;
+    next_d = 0;
+    status_d = true;
+    busy_d = num_workers_a - 1;
+    batch_d++;
+  }
+  start_d.notify_all();
+
+  // work as worker 0 and wait for the others
+  //
+  run_tasks(0);
+  std::unique_lock<std::mutex> lock(mutex_d);
+  done_d.wait(lock, [&]() { return busy_d == 0; });
+  task_d = (const std::function<bool(long, long)>*)NULL;
+
+  // exit gracefully
+  //
+  return status_d;
+}
+
+// method: run_tasks
+//
+// arguments:
+//  long worker: index of the worker (input)
+//
+// return: none
+//
+// This method pulls the next unclaimed task of the batch until all
+// have been claimed.
+//
+void MplpcPool::run_tasks(long worker_a) {
+
+  long i;
+  while ((i = next_d++) < num_tasks_d) {
+    if (!(*task_d)(i, worker_a)) {
+      status_d = false;
+    }
+  }
+}
+
+// method: run_thread
+//
+// arguments:
+//  long worker: index of the worker (input)
+//  long batch: the last batch before the thread started (input)
+//
+// return: none
+//
+// This is the body of a worker thread: it waits for a batch, takes part
+// in it if the batch has enough workers, and reports back.
+//
+void MplpcPool::run_thread(long worker_a, long batch_a) {
+
+  std::unique_lock<std::mutex> lock(mutex_d);
+  while (true) {
+    start_d.wait(lock, [&]() { return stop_d || (batch_d != batch_a); });
+    if (stop_d) {
+      break;
+    }
+    batch_a = batch_d;
+    if (worker_a >= num_workers_d) {
+      continue;
+    }
+
+    // work without holding the lock
+    //
+    lock.unlock();
+    run_tasks(worker_a);
+    lock.lock();
+
+    if (--busy_d == 0) {
+      done_d.notify_all();
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+//
+// instantiate the frame methods the kernel benchmark calls directly for
+// each precision policy
+//
+//-----------------------------------------------------------------------------
+
+template bool Mplpc::window_frame<MplpcMixed>(double*, double*,
+					       const double*, double, long,
+					       long);
+template bool Mplpc::window_frame<MplpcFloat>(float*, float*, const double*,
+					      double, long, long);
+template bool Mplpc::window_frame<MplpcDouble>(double*, double*,
+						const double*, double, long,
+						long);
+
+template bool Mplpc::compute_pulses<MplpcMixed>
+(MplpcWork&, MplpcPulses&, double*, float, long);
+template bool Mplpc::compute_pulses<MplpcFloat>
+(MplpcWork&, MplpcPulses&, float*, float, long);
+template bool Mplpc::compute_pulses<MplpcDouble>
+(MplpcWork&, MplpcPulses&, double*, double, long);
+
 //
 // end of file
@@ -5,6 +5,359 @@
 //
 #include "Mplpc.h"
 
+//-----------------------------------------------------------------------------
+//
+// fixed-order kernels: versions of the lpc kernels with the order as a
+// template argument, instantiated for the orders we run. with the order
+// known at compile time the loops over it unroll, and the coefficients
+// and filter state stay in registers. each does exactly the arithmetic
+// of the generic method, in the same order, so the results are the
+// same. the methods below look the order up in a table and fall back to
+// the generic code when there is no entry.
+//
+//-----------------------------------------------------------------------------
+
+// define the largest order that can have an entry in the table
+//
+static const long MAX_FIXED_ORDER = 24;
+
+// function: autocor_fixed
+//
+// arguments:
+//  sample_t* autocor: autocorrelation function, ORDER + 1 values (output)
+//  const sample_t* sig: signal (input)
+//  long N: number of samples in the signal (input)
+//  accum_t N_1: 1 / N (input)
+//
+// return: none
+//
+// This is the scalar path of compute_autocor. Rather than one pass over
+// the signal per lag, it makes a single pass and keeps an accumulator
+// per lag. Each lag still sums its terms in order of increasing j.
+//
+template <class P, long ORDER>
+static void autocor_fixed(typename P::sample_t* autocor_a,
+			  const typename P::sample_t* sig_a, long N,
+			  typename P::accum_t N_1) {
+
+  typedef typename P::sample_t sample_t;
+  typedef typename P::accum_t accum_t;
+
+  accum_t acc[ORDER + 1];
+  for (long i = 0; i <= ORDER; i++) {
+    acc[i] = 0.0;
+  }
+
+  // every lag has a term for the samples before N - ORDER
+  //
+  long j = 0;
+  for (; j < N - ORDER; j++) {
+    sample_t x = sig_a[j];
+    for (long i = 0; i <= ORDER; i++) {
+      acc[i] += x * sig_a[j + i];
+    }
+  }
+
+  // the last samples only contribute to the shorter lags
+  //
+  for (; j < N; j++) {
+    sample_t x = sig_a[j];
+    for (long i = 0; (i <= ORDER) && (i < N - j); i++) {
+      acc[i] += x * sig_a[j + i];
+    }
+  }
+
+  for (long i = 0; i <= ORDER; i++) {
+    autocor_a[i] = acc[i] * N_1;
+  }
+}
+
+// function: lags_fixed
+//
+// arguments:
+//  sample_t* acc: partial sums of the lags, ORDER + 1 values (input/output)
+//  const sample_t* sig: signal, from its first sample (input)
+//  long j_beg: first sample to add (input)
+//  long j_end: one past the last sample to add (input)
+//
+// return: none
+//
+// This is accumulate_autocor: the same sums as autocor_fixed, but each
+// sample is paired with the ones before it, so the signal can be added
+// a piece at a time as it is produced.
+//
+template <class P, long ORDER>
+static void lags_fixed(typename P::sample_t* acc_a,
+		       const typename P::sample_t* sig_a, long j_beg_a,
+		       long j_end_a) {
+
+  typedef typename P::sample_t sample_t;
+  typedef typename P::accum_t accum_t;
+
+  accum_t acc[ORDER + 1];
+  for (long i = 0; i <= ORDER; i++) {
+    acc[i] = acc_a[i];
+  }
+
+  // the first samples only have predecessors for the shorter lags
+  //
+  long j = j_beg_a;
+  for (; (j < j_end_a) && (j < ORDER); j++) {
+    sample_t x = sig_a[j];
+    for (long i = 0; i <= j; i++) {
+      acc[i] += sig_a[j - i] * x;
+    }
+  }
+
+  // every lag has a term for the rest
+  //
+  for (; j < j_end_a; j++) {
+    sample_t x = sig_a[j];
+    for (long i = 0; i <= ORDER; i++) {
+      acc[i] += sig_a[j - i] * x;
+    }
+  }
+
+  for (long i = 0; i <= ORDER; i++) {
+    acc_a[i] = acc[i];
+  }
+}
+
+// function: lpc_fixed
+//
+// arguments:
+//  sample_t* rc: reflection coefficients, ORDER values (output)
+//  sample_t* pc: predictor coefficients, ORDER + 1 values (output)
+//  const sample_t* autocor: autocorrelation function (input)
+//
+// return: none
+//
+// This is compute_lpc on local copies of the autocorrelation and the
+// predictor coefficients.
+//
+template <class P, long ORDER>
+static void lpc_fixed(typename P::sample_t* rc_a, typename P::sample_t* pc_a,
+		      const typename P::sample_t* autocor_a) {
+
+  typedef typename P::sample_t sample_t;
+  typedef typename P::accum_t accum_t;
+
+  sample_t r[ORDER + 1];
+  sample_t pc[ORDER + 1];
+  for (long i = 0; i <= ORDER; i++) {
+    r[i] = autocor_a[i];
+  }
+
+  accum_t err_egy = r[0];
+  pc[0] = 1.0;
+
+  for (long i = 1; i <= ORDER; i++) {
+    accum_t acc = 0.0;
+    for (long j = 1; j <= i; j++) {
+      acc -= pc[i-j] * r[j];
+    }
+    pc[i] = acc / err_egy;
+    rc_a[i-1] = pc[i];
+
+    for (long k = 1; k <= i/2; k++) {
+      accum_t pci = pc[k] + pc[i] * pc[i - k];
+      accum_t pcki = pc[i - k] + pc[i] * pc[k];
+      pc[k] = pci;
+      pc[i - k] = pcki;
+    }
+
+    err_egy = err_egy * (1.0 - pc[i]*pc[i]);
+  }
+
+  for (long i = 0; i <= ORDER; i++) {
+    pc_a[i] = pc[i];
+  }
+}
+
+// function: impres_fixed
+//
+// arguments:
+//  sample_t* hres: impulse response, num_samples values (output)
+//  sample_t* filt: filter memory, ORDER + 1 values (scratch)
+//  const sample_t* pc: predictor coefficients, ORDER + 1 values (input)
+//  long num_samples: number of samples to generate (input)
+//
+// return: none
+//
+// This is compute_impulse_response with the coefficients and the filter
+// memory held in local arrays, so the shift of the memory is a handful
+// of register moves.
+//
+template <class P, long ORDER>
+static void impres_fixed(typename P::sample_t* hres_a,
+			 typename P::sample_t* filt_a,
+			 const typename P::sample_t* pc_a, long num_samples_a) {
+
+  typedef typename P::sample_t sample_t;
+  typedef typename P::accum_t accum_t;
+
+  sample_t pc[ORDER + 1];
+  sample_t filt[ORDER + 1];
+  for (long j = 0; j <= ORDER; j++) {
+    pc[j] = pc_a[j];
+    filt[j] = 0.0;
+  }
+  hres_a[0] = 1.0 * pc[0];
+  filt[0] = hres_a[0];
+
+  for (long i = 1; i < num_samples_a; i++) {
+    for (long j = ORDER; j > 0; j--) {
+      filt[j] = filt[j-1];
+    }
+    accum_t sum = 0.0;
+    for (long j = 1; j <= ORDER; j++) {
+      sum += pc[j] * filt[j];
+    }
+    hres_a[i] = sum;
+    filt[0] = sum;
+  }
+
+  // leave the filter memory as the generic method does
+  //
+  for (long j = 0; j <= ORDER; j++) {
+    filt_a[j] = filt[j];
+  }
+}
+
+// function: residual_fixed
+//
+// arguments:
+//  sample_t* osig: residual signal (output)
+//  const sample_t* isig: original signal (input)
+//  const sample_t* pc: predictor coefficients, ntaps values (input)
+//  long ntaps: number of predictor coefficients, at least ORDER + 1 (input)
+//  long i_beg: first sample to filter (input)
+//  long i_end: one past the last sample to filter (input)
+//
+// return: none
+//
+// This is the filter loop of compute_residual. The first ORDER taps are
+// unrolled; any taps past them (compute_lpc leaves one extra, zero
+// coefficient) are applied by a loop, in the same order as before.
+// Samples with less than a full filter of history take the generic
+// path.
+//
+template <class P, long ORDER>
+static void residual_fixed(typename P::sample_t* osig_a,
+			   const typename P::sample_t* isig_a,
+			   const typename P::sample_t* pc_a, long ntaps_a,
+			   long i_beg_a, long i_end_a) {
+
+  typedef typename P::sample_t sample_t;
+  typedef typename P::accum_t accum_t;
+
+  sample_t pc[ORDER + 1];
+  for (long j = 1; j <= ORDER; j++) {
+    pc[j] = pc_a[j];
+  }
+
+  for (long i = i_beg_a; i < i_end_a; i++) {
+    accum_t sum = isig_a[i];
+    if (i >= ntaps_a - 1) {
+      for (long j = 1; j <= ORDER; j++) {
+	sum -= isig_a[i - j] * pc[j];
+      }
+      for (long j = ORDER + 1; j < ntaps_a; j++) {
+	sum -= isig_a[i - j] * pc_a[j];
+      }
+    }
+    else {
+      for (long j = 1; j < ntaps_a; j++) {
+	if ((i - j) >= 0) {
+	  sum -= isig_a[i - j] * pc_a[j];
+	}
+      }
+    }
+    osig_a[i] = sum;
+  }
+}
+
+// MplpcOrderKernels: the fixed-order kernels of one order
+//
+template <class P>
+class MplpcOrderKernels {
+public:
+  typedef typename P::sample_t sample_t;
+  typedef typename P::accum_t accum_t;
+
+  void (*autocor_d)(sample_t* autocor, const sample_t* sig, long n,
+		    accum_t n_1);
+  void (*lags_d)(sample_t* acc, const sample_t* sig, long j_beg,
+		 long j_end);
+  void (*lpc_d)(sample_t* rc, sample_t* pc, const sample_t* autocor);
+  void (*impres_d)(sample_t* h, sample_t* filt, const sample_t* pc,
+		   long num_samples);
+  void (*residual_d)(sample_t* osig, const sample_t* isig,
+		     const sample_t* pc, long ntaps, long i_beg, long i_end);
+};
+
+// MplpcOrderTable: the dispatch table, indexed by order. Orders without
+// fixed-order kernels have null entries.
+//
+template <class P>
+class MplpcOrderTable {
+public:
+  MplpcOrderKernels<P> kern_d[MAX_FIXED_ORDER + 1];
+
+  // method: default constructor
+  //
+  MplpcOrderTable() {
+    for (long i = 0; i <= MAX_FIXED_ORDER; i++) {
+      kern_d[i].autocor_d = NULL;
+      kern_d[i].lags_d = NULL;
+      kern_d[i].lpc_d = NULL;
+      kern_d[i].impres_d = NULL;
+      kern_d[i].residual_d = NULL;
+    }
+    add<8>();
+    add<10>();
+    add<12>();
+    add<16>();
+    add<20>();
+    add<24>();
+  }
+
+  // method: add
+  //
+  template <long ORDER>
+  void add() {
+    kern_d[ORDER].autocor_d = autocor_fixed<P, ORDER>;
+    kern_d[ORDER].lags_d = lags_fixed<P, ORDER>;
+    kern_d[ORDER].lpc_d = lpc_fixed<P, ORDER>;
+    kern_d[ORDER].impres_d = impres_fixed<P, ORDER>;
+    kern_d[ORDER].residual_d = residual_fixed<P, ORDER>;
+  }
+};
+
+// function: find_order_kernels
+//
+// arguments:
+//  long order: linear prediction order (input)
+//
+// return: the fixed-order kernels for the order, or NULL if there are none
+//
+template <class P>
+static const MplpcOrderKernels<P>* find_order_kernels(long order_a) {
+
+  static const MplpcOrderTable<P> table;
+  if ((order_a < 0) || (order_a > MAX_FIXED_ORDER) ||
+      (table.kern_d[order_a].lpc_d == NULL)) {
+    return (const MplpcOrderKernels<P>*)NULL;
+  }
+  return &table.kern_d[order_a];
+}
+
+//-----------------------------------------------------------------------------
+//
+// Mplpc methods
+//
+//-----------------------------------------------------------------------------
+
 // method: clip_value
 //
 // arguments:
@@ -129,6 +482,10 @@ bool Mplpc::create_window() {
     }
   }
 
+  // keep a single precision copy for the float policy
+  //
+  win_fct_f_d.assign(win_fct_d.begin(), win_fct_d.end());
+
   // display debug information
   //
   if (debug_level_d >= Dbgl::LEVEL_FULL) {
@@ -151,18 +508,18 @@ bool Mplpc::create_window() {
   return status;
 }
 
-// method: debias
-// 
+// method: compute_mean
+//
 // arguments:
-//  VectorDouble& sig: the signal vector (input/output)
+//  const VectorDouble& sig: the signal vector (input)
 //
 // return: a double value containing the average value of the signal
 //
-// this code computes the average of a signal and subtracts it from
-// each sample value.
+// this code computes the average of a signal. the analysis subtracts
+// it from the samples as it reads them, so the signal is not modified.
 //
-double Mplpc::debias(VectorDouble& sig_a) {
-  
+double Mplpc::compute_mean(const VectorDouble& sig_a) {
+
   // get the number of samples
   //
   long ns = sig_a.size();
@@ -175,9 +532,34 @@ double Mplpc::debias(VectorDouble& sig_a) {
   }
   double avg = sum / (double)ns;
   if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
-    fprintf(stdout, "   Mplpc::debias(): average value = %f\n", avg);
+    fprintf(stdout, "   Mplpc::compute_mean(): average value = %f\n", avg);
   }
 
+  // exit gracefully
+  //
+  return avg;
+}
+
+// method: debias
+// 
+// arguments:
+//  VectorDouble& sig: the signal vector (input/output)
+//
+// return: a double value containing the average value of the signal
+//
+// this code computes the average of a signal and subtracts it from
+// each sample value.
+//
+double Mplpc::debias(VectorDouble& sig_a) {
+  
+  // get the number of samples
+  //
+  long ns = sig_a.size();
+
+  // compute the average
+  //
+  double avg = Mplpc::compute_mean(sig_a);
+
   // subtract the average
   //
   for (long i = 0; i < ns; i++) {
@@ -205,21 +587,64 @@ double Mplpc::debias(VectorDouble& sig_a) {
 bool Mplpc::compute_autocor(VectorDouble& autocor_a, VectorDouble& sig_a,
 			    long lp_order_a) {
 
+  // create output space
+  //
+  autocor_a.resize(lp_order_a + 1);
+
+  // compute the autocorrelation
+  //
+  return Mplpc::compute_autocor<MplpcMixed>(autocor_a.data(), sig_a.data(),
+					    sig_a.size(), lp_order_a);
+}
+
+// method: compute_autocor
+//
+// arguments:
+//  sample_t* autocor: autocorrelation function, lp_order + 1 values (output)
+//  const sample_t* sig: signal (input)
+//  long N: number of samples in the signal (input)
+//  long lp_order: the order of the autocorrelation analysis (input)
+//
+// return: a logical variable indicating status
+//
+// This version works on preallocated buffers (see MplpcWork) in the
+// precision of the policy P.
+//
+template <class P>
+bool Mplpc::compute_autocor(typename P::sample_t* autocor_a,
+			    const typename P::sample_t* sig_a,
+			    long N, long lp_order_a) {
+
   // declare local variables
   //
+  typedef typename P::accum_t accum_t;
   long status = true;
-  long N = sig_a.size();
-  float N_1 = 1.0 / (float)N;
+  accum_t N_1 = 1.0 / (accum_t)N;
 
-  // create output space
+  // use the simd kernels when they are enabled: these accumulate in
+  // the sample type
   //
-  autocor_a.resize(lp_order_a + 1);
+  if (simd_mode_d != SIMD_NONE) {
+    for (long i = 0; i <= lp_order_a; i++) {
+      autocor_a[i] = (i < N) ?
+	kern_dot(sig_a, sig_a + i, N - i) * N_1 : 0.0;
+    }
+    return status;
+  }
+
+  // use the fixed-order kernel if there is one
+  //
+  const MplpcOrderKernels<P>* fixed = find_order_kernels<P>(lp_order_a);
+  if (fixed != NULL) {
+    fixed->autocor_d(autocor_a, sig_a, N, N_1);
+    return status;
+  }
 
   // loop over the order
   //
   for (long i = 0; i <= lp_order_a; i++) {
 
-    float sum = 0.0;
+    accum_t sum = 0.0;
     for (long j = 0; j < N - i; j++) {
       sum += sig_a[j] * sig_a[j + i];
     }
@@ -231,6 +656,61 @@ bool Mplpc::compute_autocor(VectorDouble& autocor_a, VectorDouble& sig_a,
   return status;
 }
 
+// method: accumulate_autocor
+//
+// arguments:
+//  sample_t* acc: partial sums of the lags, lp_order + 1 values (input/output)
+//  const sample_t* sig: signal, from its first sample (input)
+//  long j_beg: first sample to add (input)
+//  long j_end: one past the last sample to add (input)
+//  long lp_order: the order of the autocorrelation analysis (input)
+//
+// return: a logical variable indicating status
+//
+// This method adds the terms of samples j_beg to j_end - 1 to the lags
+// of an autocorrelation, pairing each sample with the ones before it:
+//
+//  acc[i] += sig[j - i] * sig[j]
+//
+// Called on consecutive pieces of a signal starting with zeroed sums,
+// it gives the sums compute_autocor scales by 1 / N in its scalar mode,
+// term for term and in the same order. This lets the window be
+// correlated while it is produced (see window_frame). The sums are
+// held in the sample type but rounded to the accumulator type, which
+// the sample type always represents exactly.
+//
+template <class P>
+bool Mplpc::accumulate_autocor(typename P::sample_t* acc_a,
+			       const typename P::sample_t* sig_a,
+			       long j_beg_a, long j_end_a, long lp_order_a) {
+
+  // declare local variables
+  //
+  typedef typename P::sample_t sample_t;
+  typedef typename P::accum_t accum_t;
+
+  // use the fixed-order kernel if there is one
+  //
+  const MplpcOrderKernels<P>* fixed = find_order_kernels<P>(lp_order_a);
+  if (fixed != NULL) {
+    fixed->lags_d(acc_a, sig_a, j_beg_a, j_end_a);
+    return true;
+  }
+
+  // loop over the samples
+  //
+  for (long j = j_beg_a; j < j_end_a; j++) {
+    sample_t x = sig_a[j];
+    for (long i = 0; (i <= lp_order_a) && (i <= j); i++) {
+      acc_a[i] = (accum_t)(acc_a[i] + sig_a[j - i] * x);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
 // method: compute_lpc
 //
 // arguments:
@@ -247,28 +727,62 @@ bool Mplpc::compute_autocor(VectorDouble& autocor_a, VectorDouble& sig_a,
 bool Mplpc::compute_lpc(VectorDouble& rc_a, VectorDouble& pc_a,
 			VectorDouble& autocor_a, long lp_order_a) {
 
-
-  long status = true;
+  // create output space: pc carries one extra (zero) coefficient
+  //
   long pc_order = lp_order_a + 1;
-  VectorDouble tmp(pc_order, (double)0.0);
-
   rc_a.resize(lp_order_a, (double)0.0);
   pc_a.resize(pc_order+1, (double)0.0);
-  fprintf(stdout, "in compute method...");
-  float err_egy = autocor_a[0];  
+
+  // compute the model
+  //
+  return Mplpc::compute_lpc<MplpcMixed>(rc_a.data(), pc_a.data(),
+					autocor_a.data(), lp_order_a);
+}
+
+// method: compute_lpc
+//
+// arguments:
+//  sample_t* rc: reflection coefficients, lp_order values (output)
+//  sample_t* pc: predictor coefficients, lp_order + 1 values (output)
+//  const sample_t* autocor: autocorrelation function (input)
+//  long lp_order: the order of the lpc analysis (input)
+//
+// return: a logical variable indicating status
+//
+// This version works on preallocated buffers (see MplpcWork) in the
+// precision of the policy P.
+//
+template <class P>
+bool Mplpc::compute_lpc(typename P::sample_t* rc_a,
+			typename P::sample_t* pc_a,
+			const typename P::sample_t* autocor_a,
+			long lp_order_a) {
+
+  typedef typename P::accum_t accum_t;
+  long status = true;
+
+  // use the fixed-order kernel if there is one
+  //
+  const MplpcOrderKernels<P>* fixed = find_order_kernels<P>(lp_order_a);
+  if (fixed != NULL) {
+    fixed->lpc_d(rc_a, pc_a, autocor_a);
+    return status;
+  }
+
+  accum_t err_egy = autocor_a[0];  
   //  rc_a[0] = autocor_a[0];// PROBABLY THIS SHOULDB'T BE HERE....
   pc_a[0] = 1.0;
 
   for (long i = 1; i <= lp_order_a; i++) {
-    float acc = 0.0;
+    accum_t acc = 0.0;
     for (long j = 1; j <= i; j++) {
       acc -= pc_a[i-j] * autocor_a[j];
     }
     pc_a[i] = acc / err_egy;
     rc_a[i-1] = pc_a[i];
 
-    float pci = 0.0;
-    float pcki = 0.0;
+    accum_t pci = 0.0;
+    accum_t pcki = 0.0;
     for (long k = 1; k <= i/2; k++) {
       pci = pc_a[k] + pc_a[i] * pc_a[i - k];
       pcki = pc_a[i - k] + pc_a[i] * pc_a[k];
@@ -278,7 +792,6 @@ bool Mplpc::compute_lpc(VectorDouble& rc_a, VectorDouble& pc_a,
        
     err_egy = err_egy * (1.0 - pc_a[i]*pc_a[i]);
   }
-  fprintf(stdout, "compute method finished...");
   return status;
 }
 
@@ -303,6 +816,17 @@ bool Mplpc::compute_residual(VectorDouble& osig_a, VectorDouble& isig_a,
   long i_end = idx_a + n_fdur_a;
   bool status = true;
 
+  // use the fixed-order kernel if there is one: the order is that of
+  // the coefficients compute_lpc produces, which carry an extra zero
+  //
+  const MplpcOrderKernels<MplpcMixed>* fixed =
+    find_order_kernels<MplpcMixed>((long)pc_a.size() - 2);
+  if (fixed != NULL) {
+    fixed->residual_d(osig_a.data(), isig_a.data(), pc_a.data(),
+		      pc_a.size(), idx_a, i_end);
+    return status;
+  }
+
   // filter the input signal
   //
   for (long i = idx_a; i < i_end; i++) {
@@ -337,21 +861,60 @@ bool Mplpc::compute_residual(VectorDouble& osig_a, VectorDouble& isig_a,
 bool Mplpc::compute_impulse_response(VectorDouble& hres_a,
 				     VectorDouble& pc_a, long num_samples_a) {
 
+  // create space
+  //
+  VectorDouble filt(pc_a.size(), (double)0.0);
+  hres_a.resize(num_samples_a);
+
+  // compute the impulse response
+  //
+  return Mplpc::compute_impulse_response<MplpcMixed>(hres_a.data(),
+						     filt.data(), pc_a.data(),
+						     pc_a.size(),
+						     num_samples_a);
+}
+
+// method: compute_impulse_response
+//
+// arguments:
+//  sample_t* hres: impulse response, num_samples values (output)
+//  sample_t* filt: filter memory, flen values (scratch)
+//  const sample_t* pc: predictor coefficients (input)
+//  long flen: number of predictor coefficients (input)
+//  long num_samples: number of samples to generate (input)
+//
+// return: a logical variable indicating status
+//
+// This version works on preallocated buffers (see MplpcWork) in the
+// precision of the policy P.
+//
+template <class P>
+bool Mplpc::compute_impulse_response(typename P::sample_t* hres_a,
+				     typename P::sample_t* filt_a,
+				     const typename P::sample_t* pc_a,
+				     long flen, long num_samples_a) {
+
   // declare local variables
   //
-  long flen = pc_a.size();
-  VectorDouble filt(flen, (double)0.0);
+  typedef typename P::accum_t accum_t;
   bool status = true;
 
-  // create space
+  // use the fixed-order kernel if there is one
   //
-  hres_a.resize(num_samples_a);
+  const MplpcOrderKernels<P>* fixed = find_order_kernels<P>(flen - 1);
+  if (fixed != NULL) {
+    fixed->impres_d(hres_a, filt_a, pc_a, num_samples_a);
+    return status;
+  }
 
   // initialize the impulse response and the filter memory:
   //  note only the first sample of the input is non-zero
   //
+  for (long j = 0; j < flen; j++) {
+    filt_a[j] = 0.0;
+  }
   hres_a[0] = 1.0 * pc_a[0];
-  filt[0] = hres_a[0];
+  filt_a[0] = hres_a[0];
 
   // loop over all the output samples
   //
@@ -361,18 +924,18 @@ bool Mplpc::compute_impulse_response(VectorDouble& hres_a,
     //
     long j = flen - 1;
     while (j > 0) {
-      filt[j] = filt[j-1];
+      filt_a[j] = filt_a[j-1];
       j--;
     }
 
     // compute the dot product
     //
-    float sum = 0.0;
+    accum_t sum = 0.0;
     for (long j = 1; j < flen; j++) {
-      sum += pc_a[j] * filt[j];
+      sum += pc_a[j] * filt_a[j];
     }
     hres_a[i] = sum;
-    filt[0] = sum;
+    filt_a[0] = sum;
   }
 
   // exit gracefully
@@ -380,5 +943,127 @@ bool Mplpc::compute_impulse_response(VectorDouble& hres_a,
   return status;
 }
 
+// method: compute_crosscor
+//
+// arguments:
+//  VectorDouble& crosscor: crosscorrelation function (output)
+//  VectorDouble& sig: signal vector (input)
+//  VectorDouble& h: impulse response (input)
+//  long num_lags: number of lags to compute (input)
+//
+// return: a logical variable indicating status
+//
+// This method computes the crosscorrelation of a signal against an
+// impulse response for lags [0, num_lags):
+//
+//  crosscor[k] = sum_l sig[k + l] * h[l]
+//
+// Terms that fall past the end of the signal are dropped. Passing the
+// impulse response as the signal gives its autocorrelation, which is
+// what the incremental pulse search uses to update the crosscorrelation
+// after each pulse is removed.
+//
+bool Mplpc::compute_crosscor(VectorDouble& crosscor_a, VectorDouble& sig_a,
+			     VectorDouble& h_a, long num_lags_a) {
+
+  // create output space
+  //
+  crosscor_a.resize(num_lags_a);
+
+  // compute the crosscorrelation
+  //
+  return Mplpc::compute_crosscor<MplpcMixed>(crosscor_a.data(),
+					     sig_a.data(), sig_a.size(),
+					     h_a.data(), h_a.size(),
+					     num_lags_a);
+}
+
+// method: compute_crosscor
+//
+// arguments:
+//  sample_t* crosscor: crosscorrelation function, num_lags values (output)
+//  const sample_t* sig: signal (input)
+//  long N: number of samples in the signal (input)
+//  const sample_t* h: impulse response (input)
+//  long M: number of samples in the impulse response (input)
+//  long num_lags: number of lags to compute (input)
+//
+// return: a logical variable indicating status
+//
+// This version works on preallocated buffers (see MplpcWork) in the
+// precision of the policy P. It always uses the kernels, which
+// accumulate in the sample type.
+//
+template <class P>
+bool Mplpc::compute_crosscor(typename P::sample_t* crosscor_a,
+			     const typename P::sample_t* sig_a, long N,
+			     const typename P::sample_t* h_a, long M,
+			     long num_lags_a) {
+
+  // declare local variables
+  //
+  bool status = true;
+
+  // loop over all the lags
+  //
+  for (long k = 0; k < num_lags_a; k++) {
+
+    // clip the sum so we don't go over the end of the signal
+    //
+    long l_end = N - k;
+    if (l_end > M) {
+      l_end = M;
+    }
+
+    crosscor_a[k] = (l_end > 0) ?
+      kern_dot(sig_a + k, h_a, l_end) : 0.0;
+  }
+
+  // exit gracefully
+  //
+  return status;
+}
+
+//-----------------------------------------------------------------------------
+//
+// instantiate the kernels for each precision policy
+//
+//-----------------------------------------------------------------------------
+
+template bool Mplpc::compute_autocor<MplpcMixed>(double*, const double*,
+						 long, long);
+template bool Mplpc::compute_autocor<MplpcFloat>(float*, const float*,
+						 long, long);
+template bool Mplpc::compute_autocor<MplpcDouble>(double*, const double*,
+						  long, long);
+
+template bool Mplpc::accumulate_autocor<MplpcMixed>(double*, const double*,
+						    long, long, long);
+template bool Mplpc::accumulate_autocor<MplpcFloat>(float*, const float*,
+						    long, long, long);
+template bool Mplpc::accumulate_autocor<MplpcDouble>(double*, const double*,
+						     long, long, long);
+
+template bool Mplpc::compute_lpc<MplpcMixed>(double*, double*,
+					     const double*, long);
+template bool Mplpc::compute_lpc<MplpcFloat>(float*, float*,
+					     const float*, long);
+template bool Mplpc::compute_lpc<MplpcDouble>(double*, double*,
+					      const double*, long);
+
+template bool Mplpc::compute_impulse_response<MplpcMixed>
+(double*, double*, const double*, long, long);
+template bool Mplpc::compute_impulse_response<MplpcFloat>
+(float*, float*, const float*, long, long);
+template bool Mplpc::compute_impulse_response<MplpcDouble>
+(double*, double*, const double*, long, long);
+
+template bool Mplpc::compute_crosscor<MplpcMixed>
+(double*, const double*, long, const double*, long, long);
+template bool Mplpc::compute_crosscor<MplpcFloat>
+(float*, const float*, long, const float*, long, long);
+template bool Mplpc::compute_crosscor<MplpcDouble>
+(double*, const double*, long, const double*, long, long);
+
 //
 // end of file
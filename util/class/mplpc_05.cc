@@ -0,0 +1,643 @@
+// This file contains the vectorized kernels used by the signal processing
+// methods and the code that selects among them at run time.
+//
+
+// system include files
+//
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MPLPC_X86
+#endif
+
+// local include files
+//
+#include "Mplpc.h"
+
+//-----------------------------------------------------------------------------
+//
+// kernels: each kernel comes in a scalar version and, on x86, SSE2, AVX2
+// and AVX-512 versions. the x86 versions are compiled with target
+// attributes so a single library build runs on every processor; the
+// version actually used is chosen by select_kernels() using CPUID.
+//
+// each kernel also comes in a single precision version (suffix f) for
+// the float precision policy, with twice as many lanes per register.
+// kernels accumulate in the precision of their arguments.
+//
+//-----------------------------------------------------------------------------
+
+// function: dot_scalar
+//
+// arguments:
+//  const double* x: first vector (input)
+//  const double* y: second vector (input)
+//  long n: number of elements (input)
+//
+// return: the dot product of x and y
+//
+static double dot_scalar(const double* x_a, const double* y_a, long n_a) {
+
+  double sum = 0.0;
+  for (long i = 0; i < n_a; i++) {
+    sum += x_a[i] * y_a[i];
+  }
+  return sum;
+}
+
+// function: mul_scalar
+//
+// arguments:
+//  double* z: product (output)
+//  const double* x: first vector (input)
+//  const double* y: second vector (input)
+//  long n: number of elements (input)
+//
+// return: none
+//
+// This function computes the elementwise product z = x * y.
+//
+static void mul_scalar(double* z_a, const double* x_a, const double* y_a,
+		       long n_a) {
+
+  for (long i = 0; i < n_a; i++) {
+    z_a[i] = x_a[i] * y_a[i];
+  }
+}
+
+// function: dotf_scalar
+//
+// single precision version of dot_scalar.
+//
+static float dotf_scalar(const float* x_a, const float* y_a, long n_a) {
+
+  float sum = 0.0;
+  for (long i = 0; i < n_a; i++) {
+    sum += x_a[i] * y_a[i];
+  }
+  return sum;
+}
+
+// function: mulf_scalar
+//
+// single precision version of mul_scalar.
+//
+static void mulf_scalar(float* z_a, const float* x_a, const float* y_a,
+			long n_a) {
+
+  for (long i = 0; i < n_a; i++) {
+    z_a[i] = x_a[i] * y_a[i];
+  }
+}
+
+// function: clip_scalar
+//
+// arguments:
+//  short int* z: 16-bit samples (output)
+//  const double* x: samples (input)
+//  long n: number of elements (input)
+//
+// return: none
+//
+// This function converts samples to 16-bit integers the way
+// Mplpc::clip_value() does: each sample is narrowed to a float, limited
+// to +/- MAX_VALUE and rounded half away from zero.
+//
+static void clip_scalar(short int* z_a, const double* x_a, long n_a) {
+
+  for (long i = 0; i < n_a; i++) {
+    float val = (float)x_a[i];
+    if (val > Mplpc::MAX_VALUE) {
+      z_a[i] = (short int)Mplpc::MAX_VALUE;
+    }
+    else if (val < -Mplpc::MAX_VALUE) {
+      z_a[i] = (short int)-Mplpc::MAX_VALUE;
+    }
+    else {
+      z_a[i] = (short int)round(val);
+    }
+  }
+}
+
+#ifdef MPLPC_X86
+
+// function: dot_sse2
+//
+// SSE2 version of dot_scalar. two accumulators hide the add latency.
+//
+__attribute__((target("sse2")))
+static double dot_sse2(const double* x_a, const double* y_a, long n_a) {
+
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+  long i = 0;
+  for (; i + 4 <= n_a; i += 4) {
+    acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(x_a + i),
+				       _mm_loadu_pd(y_a + i)));
+    acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(x_a + i + 2),
+				       _mm_loadu_pd(y_a + i + 2)));
+  }
+  acc0 = _mm_add_pd(acc0, acc1);
+  double buf[2];
+  _mm_storeu_pd(buf, acc0);
+  double sum = buf[0] + buf[1];
+  for (; i < n_a; i++) {
+    sum += x_a[i] * y_a[i];
+  }
+  return sum;
+}
+
+// function: mul_sse2
+//
+// SSE2 version of mul_scalar.
+//
+__attribute__((target("sse2")))
+static void mul_sse2(double* z_a, const double* x_a, const double* y_a,
+		     long n_a) {
+
+  long i = 0;
+  for (; i + 2 <= n_a; i += 2) {
+    _mm_storeu_pd(z_a + i, _mm_mul_pd(_mm_loadu_pd(x_a + i),
+				      _mm_loadu_pd(y_a + i)));
+  }
+  for (; i < n_a; i++) {
+    z_a[i] = x_a[i] * y_a[i];
+  }
+}
+
+// function: dot_avx2
+//
+// AVX2/FMA version of dot_scalar.
+//
+__attribute__((target("avx2,fma")))
+static double dot_avx2(const double* x_a, const double* y_a, long n_a) {
+
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+  long i = 0;
+  for (; i + 8 <= n_a; i += 8) {
+    acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x_a + i),
+			   _mm256_loadu_pd(y_a + i), acc0);
+    acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(x_a + i + 4),
+			   _mm256_loadu_pd(y_a + i + 4), acc1);
+  }
+  for (; i + 4 <= n_a; i += 4) {
+    acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x_a + i),
+			   _mm256_loadu_pd(y_a + i), acc0);
+  }
+  acc0 = _mm256_add_pd(acc0, acc1);
+  __m128d s = _mm_add_pd(_mm256_castpd256_pd128(acc0),
+			 _mm256_extractf128_pd(acc0, 1));
+  double buf[2];
+  _mm_storeu_pd(buf, s);
+  double sum = buf[0] + buf[1];
+  for (; i < n_a; i++) {
+    sum += x_a[i] * y_a[i];
+  }
+  return sum;
+}
+
+// function: mul_avx2
+//
+// AVX2 version of mul_scalar.
+//
+__attribute__((target("avx2")))
+static void mul_avx2(double* z_a, const double* x_a, const double* y_a,
+		     long n_a) {
+
+  long i = 0;
+  for (; i + 4 <= n_a; i += 4) {
+    _mm256_storeu_pd(z_a + i, _mm256_mul_pd(_mm256_loadu_pd(x_a + i),
+					    _mm256_loadu_pd(y_a + i)));
+  }
+  for (; i < n_a; i++) {
+    z_a[i] = x_a[i] * y_a[i];
+  }
+}
+
+// function: dot_avx512
+//
+// AVX-512 version of dot_scalar. the tail is handled with a masked load.
+//
+__attribute__((target("avx512f")))
+static double dot_avx512(const double* x_a, const double* y_a, long n_a) {
+
+  __m512d acc0 = _mm512_setzero_pd();
+  __m512d acc1 = _mm512_setzero_pd();
+  long i = 0;
+  for (; i + 16 <= n_a; i += 16) {
+    acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x_a + i),
+			   _mm512_loadu_pd(y_a + i), acc0);
+    acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(x_a + i + 8),
+			   _mm512_loadu_pd(y_a + i + 8), acc1);
+  }
+  for (; i + 8 <= n_a; i += 8) {
+    acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x_a + i),
+			   _mm512_loadu_pd(y_a + i), acc0);
+  }
+  if (i < n_a) {
+    __mmask8 m = (__mmask8)((1 << (n_a - i)) - 1);
+    acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, x_a + i),
+			   _mm512_maskz_loadu_pd(m, y_a + i), acc1);
+  }
+  return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+}
+
+// function: mul_avx512
+//
+// AVX-512 version of mul_scalar.
+//
+__attribute__((target("avx512f")))
+static void mul_avx512(double* z_a, const double* x_a, const double* y_a,
+		       long n_a) {
+
+  long i = 0;
+  for (; i + 8 <= n_a; i += 8) {
+    _mm512_storeu_pd(z_a + i, _mm512_mul_pd(_mm512_loadu_pd(x_a + i),
+					    _mm512_loadu_pd(y_a + i)));
+  }
+  if (i < n_a) {
+    __mmask8 m = (__mmask8)((1 << (n_a - i)) - 1);
+    _mm512_mask_storeu_pd(z_a + i, m,
+			  _mm512_mul_pd(_mm512_maskz_loadu_pd(m, x_a + i),
+					_mm512_maskz_loadu_pd(m, y_a + i)));
+  }
+}
+
+// function: dotf_sse2
+//
+// SSE2 version of dotf_scalar.
+//
+__attribute__((target("sse2")))
+static float dotf_sse2(const float* x_a, const float* y_a, long n_a) {
+
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  long i = 0;
+  for (; i + 8 <= n_a; i += 8) {
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x_a + i),
+				       _mm_loadu_ps(y_a + i)));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x_a + i + 4),
+				       _mm_loadu_ps(y_a + i + 4)));
+  }
+  acc0 = _mm_add_ps(acc0, acc1);
+  float buf[4];
+  _mm_storeu_ps(buf, acc0);
+  float sum = (buf[0] + buf[1]) + (buf[2] + buf[3]);
+  for (; i < n_a; i++) {
+    sum += x_a[i] * y_a[i];
+  }
+  return sum;
+}
+
+// function: mulf_sse2
+//
+// SSE2 version of mulf_scalar.
+//
+__attribute__((target("sse2")))
+static void mulf_sse2(float* z_a, const float* x_a, const float* y_a,
+		      long n_a) {
+
+  long i = 0;
+  for (; i + 4 <= n_a; i += 4) {
+    _mm_storeu_ps(z_a + i, _mm_mul_ps(_mm_loadu_ps(x_a + i),
+				      _mm_loadu_ps(y_a + i)));
+  }
+  for (; i < n_a; i++) {
+    z_a[i] = x_a[i] * y_a[i];
+  }
+}
+
+// function: dotf_avx2
+//
+// AVX2/FMA version of dotf_scalar.
+//
+__attribute__((target("avx2,fma")))
+static float dotf_avx2(const float* x_a, const float* y_a, long n_a) {
+
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  long i = 0;
+  for (; i + 16 <= n_a; i += 16) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x_a + i),
+			   _mm256_loadu_ps(y_a + i), acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x_a + i + 8),
+			   _mm256_loadu_ps(y_a + i + 8), acc1);
+  }
+  for (; i + 8 <= n_a; i += 8) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x_a + i),
+			   _mm256_loadu_ps(y_a + i), acc0);
+  }
+  acc0 = _mm256_add_ps(acc0, acc1);
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc0),
+			_mm256_extractf128_ps(acc0, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+  float sum = _mm_cvtss_f32(s);
+  for (; i < n_a; i++) {
+    sum += x_a[i] * y_a[i];
+  }
+  return sum;
+}
+
+// function: mulf_avx2
+//
+// AVX2 version of mulf_scalar.
+//
+__attribute__((target("avx2")))
+static void mulf_avx2(float* z_a, const float* x_a, const float* y_a,
+		      long n_a) {
+
+  long i = 0;
+  for (; i + 8 <= n_a; i += 8) {
+    _mm256_storeu_ps(z_a + i, _mm256_mul_ps(_mm256_loadu_ps(x_a + i),
+					    _mm256_loadu_ps(y_a + i)));
+  }
+  for (; i < n_a; i++) {
+    z_a[i] = x_a[i] * y_a[i];
+  }
+}
+
+// function: dotf_avx512
+//
+// AVX-512 version of dotf_scalar. the tail is handled with a masked load.
+//
+__attribute__((target("avx512f")))
+static float dotf_avx512(const float* x_a, const float* y_a, long n_a) {
+
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  long i = 0;
+  for (; i + 32 <= n_a; i += 32) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x_a + i),
+			   _mm512_loadu_ps(y_a + i), acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(x_a + i + 16),
+			   _mm512_loadu_ps(y_a + i + 16), acc1);
+  }
+  for (; i + 16 <= n_a; i += 16) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x_a + i),
+			   _mm512_loadu_ps(y_a + i), acc0);
+  }
+  if (i < n_a) {
+    __mmask16 m = (__mmask16)((1 << (n_a - i)) - 1);
+    acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, x_a + i),
+			   _mm512_maskz_loadu_ps(m, y_a + i), acc1);
+  }
+  return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+// function: mulf_avx512
+//
+// AVX-512 version of mulf_scalar.
+//
+__attribute__((target("avx512f")))
+static void mulf_avx512(float* z_a, const float* x_a, const float* y_a,
+			long n_a) {
+
+  long i = 0;
+  for (; i + 16 <= n_a; i += 16) {
+    _mm512_storeu_ps(z_a + i, _mm512_mul_ps(_mm512_loadu_ps(x_a + i),
+					    _mm512_loadu_ps(y_a + i)));
+  }
+  if (i < n_a) {
+    __mmask16 m = (__mmask16)((1 << (n_a - i)) - 1);
+    _mm512_mask_storeu_ps(z_a + i, m,
+			  _mm512_mul_ps(_mm512_maskz_loadu_ps(m, x_a + i),
+					_mm512_maskz_loadu_ps(m, y_a + i)));
+  }
+}
+
+// function: clip4_sse2
+//
+// arguments:
+//  __m128 v: four samples (input)
+//
+// return: the samples limited and rounded as in clip_scalar
+//
+// The rounding is done by hand: v minus its truncation is exact, so
+// comparing it with +/- 0.5 rounds ties away from zero. Not-a-number
+// maps to zero, which is what the scalar conversion yields on x86.
+//
+__attribute__((target("sse2")))
+static inline __m128i clip4_sse2(__m128 v_a) {
+
+  const __m128 lim = _mm_set1_ps(Mplpc::MAX_VALUE);
+  const __m128 nlim = _mm_set1_ps(-Mplpc::MAX_VALUE);
+  __m128 ord = _mm_cmpord_ps(v_a, v_a);
+  __m128 v = _mm_and_ps(_mm_min_ps(_mm_max_ps(v_a, nlim), lim), ord);
+  __m128i t = _mm_cvttps_epi32(v);
+  __m128 d = _mm_sub_ps(v, _mm_cvtepi32_ps(t));
+  t = _mm_sub_epi32(t, _mm_castps_si128(_mm_cmpge_ps(d, _mm_set1_ps(0.5f))));
+  t = _mm_add_epi32(t, _mm_castps_si128(_mm_cmple_ps(d,
+						      _mm_set1_ps(-0.5f))));
+  return t;
+}
+
+// function: clip_sse2
+//
+// SSE2 version of clip_scalar. the results are packed with signed
+// saturation, which never triggers since they are already limited.
+//
+__attribute__((target("sse2")))
+static void clip_sse2(short int* z_a, const double* x_a, long n_a) {
+
+  long i = 0;
+  for (; i + 8 <= n_a; i += 8) {
+    __m128 a = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(x_a + i)),
+			     _mm_cvtpd_ps(_mm_loadu_pd(x_a + i + 2)));
+    __m128 b = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(x_a + i + 4)),
+			     _mm_cvtpd_ps(_mm_loadu_pd(x_a + i + 6)));
+    _mm_storeu_si128((__m128i*)(z_a + i),
+		     _mm_packs_epi32(clip4_sse2(a), clip4_sse2(b)));
+  }
+  clip_scalar(z_a + i, x_a + i, n_a - i);
+}
+
+// function: clip8_avx2
+//
+// AVX2 version of clip4_sse2.
+//
+__attribute__((target("avx2,fma")))
+static inline __m256i clip8_avx2(__m256 v_a) {
+
+  const __m256 lim = _mm256_set1_ps(Mplpc::MAX_VALUE);
+  const __m256 nlim = _mm256_set1_ps(-Mplpc::MAX_VALUE);
+  __m256 ord = _mm256_cmp_ps(v_a, v_a, _CMP_ORD_Q);
+  __m256 v = _mm256_and_ps(_mm256_min_ps(_mm256_max_ps(v_a, nlim), lim),
+			   ord);
+  __m256i t = _mm256_cvttps_epi32(v);
+  __m256 d = _mm256_sub_ps(v, _mm256_cvtepi32_ps(t));
+  t = _mm256_sub_epi32(t, _mm256_castps_si256(
+    _mm256_cmp_ps(d, _mm256_set1_ps(0.5f), _CMP_GE_OQ)));
+  t = _mm256_add_epi32(t, _mm256_castps_si256(
+    _mm256_cmp_ps(d, _mm256_set1_ps(-0.5f), _CMP_LE_OQ)));
+  return t;
+}
+
+// function: clip_avx2
+//
+// AVX2 version of clip_sse2. the pack works within 128-bit halves, so
+// the 64-bit quarters are put back in order afterwards.
+//
+__attribute__((target("avx2,fma")))
+static void clip_avx2(short int* z_a, const double* x_a, long n_a) {
+
+  long i = 0;
+  for (; i + 16 <= n_a; i += 16) {
+    __m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(
+      _mm256_cvtpd_ps(_mm256_loadu_pd(x_a + i))),
+      _mm256_cvtpd_ps(_mm256_loadu_pd(x_a + i + 4)), 1);
+    __m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(
+      _mm256_cvtpd_ps(_mm256_loadu_pd(x_a + i + 8))),
+      _mm256_cvtpd_ps(_mm256_loadu_pd(x_a + i + 12)), 1);
+    __m256i p = _mm256_packs_epi32(clip8_avx2(a), clip8_avx2(b));
+    _mm256_storeu_si256((__m256i*)(z_a + i),
+			_mm256_permute4x64_epi64(p, 0xD8));
+  }
+  clip_scalar(z_a + i, x_a + i, n_a - i);
+}
+
+// function: clip_avx512
+//
+// AVX-512 version of clip_sse2, using mask registers for the rounding
+// and a saturating narrowing store.
+//
+__attribute__((target("avx512f")))
+static void clip_avx512(short int* z_a, const double* x_a, long n_a) {
+
+  const __m512 lim = _mm512_set1_ps(Mplpc::MAX_VALUE);
+  const __m512 nlim = _mm512_set1_ps(-Mplpc::MAX_VALUE);
+  const __m512 half = _mm512_set1_ps(0.5f);
+  const __m512 nhalf = _mm512_set1_ps(-0.5f);
+  const __m512i one = _mm512_set1_epi32(1);
+
+  long i = 0;
+  for (; i + 16 <= n_a; i += 16) {
+    __m512d lo = _mm512_castpd256_pd512(_mm256_castps_pd(
+      _mm512_cvtpd_ps(_mm512_loadu_pd(x_a + i))));
+    __m512 v = _mm512_castpd_ps(_mm512_insertf64x4(lo, _mm256_castps_pd(
+      _mm512_cvtpd_ps(_mm512_loadu_pd(x_a + i + 8))), 1));
+    __mmask16 ord = _mm512_cmp_ps_mask(v, v, _CMP_ORD_Q);
+    v = _mm512_maskz_mov_ps(ord, _mm512_min_ps(_mm512_max_ps(v, nlim), lim));
+    __m512i t = _mm512_cvttps_epi32(v);
+    __m512 d = _mm512_sub_ps(v, _mm512_cvtepi32_ps(t));
+    t = _mm512_mask_add_epi32(t, _mm512_cmp_ps_mask(d, half, _CMP_GE_OQ),
+			      t, one);
+    t = _mm512_mask_sub_epi32(t, _mm512_cmp_ps_mask(d, nhalf, _CMP_LE_OQ),
+			      t, one);
+    _mm256_storeu_si256((__m256i*)(z_a + i), _mm512_cvtsepi32_epi16(t));
+  }
+  clip_scalar(z_a + i, x_a + i, n_a - i);
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+//
+// kernel selection
+//
+//-----------------------------------------------------------------------------
+
+// method: select_kernels
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method binds the kernel pointers to the implementation requested
+// by simd_mode_d. In auto mode, the widest instruction set reported by
+// CPUID is used. Requesting an instruction set the processor does not
+// support is an error.
+//
+bool Mplpc::select_kernels() {
+
+  // declare local variables
+  //
+  bool has_sse2 = false;
+  bool has_avx2 = false;
+  bool has_avx512 = false;
+
+  // query the processor
+  //
+#ifdef MPLPC_X86
+  __builtin_cpu_init();
+  has_sse2 = __builtin_cpu_supports("sse2");
+  has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  has_avx512 = __builtin_cpu_supports("avx512f");
+#endif
+
+  // resolve the automatic mode to a specific instruction set
+  //
+  simd_isa_d = simd_mode_d;
+  if (simd_mode_d == SIMD_AUTO) {
+    if (has_avx512) {
+      simd_isa_d = SIMD_AVX512;
+    }
+    else if (has_avx2) {
+      simd_isa_d = SIMD_AVX2;
+    }
+    else if (has_sse2) {
+      simd_isa_d = SIMD_SSE2;
+    }
+    else {
+      simd_isa_d = SIMD_SCALAR;
+    }
+  }
+
+  // make sure the instruction set is supported
+  //
+  if (((simd_isa_d == SIMD_SSE2) && !has_sse2) ||
+      ((simd_isa_d == SIMD_AVX2) && !has_avx2) ||
+      ((simd_isa_d == SIMD_AVX512) && !has_avx512)) {
+    fprintf(stdout,
+	    "**> error in Mplpc::select_kernels(): [%s] is not supported "
+	    "by this processor\n", simd_mode_str_d);
+    return false;
+  }
+
+  // bind the kernels: the reference mode does not use them, but we
+  // bind the scalar versions so the pointers are always valid
+  //
+  kern_dot_d = dot_scalar;
+  kern_mul_d = mul_scalar;
+  kern_dot_f = dotf_scalar;
+  kern_mul_f = mulf_scalar;
+  kern_clip_d = clip_scalar;
+
+#ifdef MPLPC_X86
+  if (simd_isa_d == SIMD_SSE2) {
+    kern_dot_d = dot_sse2;
+    kern_mul_d = mul_sse2;
+    kern_dot_f = dotf_sse2;
+    kern_mul_f = mulf_sse2;
+    kern_clip_d = clip_sse2;
+  }
+  else if (simd_isa_d == SIMD_AVX2) {
+    kern_dot_d = dot_avx2;
+    kern_mul_d = mul_avx2;
+    kern_dot_f = dotf_avx2;
+    kern_mul_f = mulf_avx2;
+    kern_clip_d = clip_avx2;
+  }
+  else if (simd_isa_d == SIMD_AVX512) {
+    kern_dot_d = dot_avx512;
+    kern_mul_d = mul_avx512;
+    kern_dot_f = dotf_avx512;
+    kern_mul_f = mulf_avx512;
+    kern_clip_d = clip_avx512;
+  }
+#endif
+
+  // display debug information
+  //
+  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+    fprintf(stdout, "Mplpc::select_kernels(): [%s] -> [%ld]\n",
+	    simd_mode_str_d, (long)simd_isa_d);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
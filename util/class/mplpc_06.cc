@@ -0,0 +1,1115 @@
+// This file contains the methods that open input files and read EDF
+// files a few data records at a time so that recordings larger than
+// memory can be processed.
+//
+
+// system include files
+//
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+
+// io_uring is used when the kernel headers describe it: the ring is
+// driven with the system calls directly, so liburing isn't needed
+//
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define MPLPC_URING
+#endif
+#endif
+#endif
+
+// local include files
+//
+#include "Mplpc.h"
+
+//-----------------------------------------------------------------------------
+//
+// EDF layout: a fixed 256 byte header is followed by 256 bytes per
+// signal (grouped field by field) and then by the data records. each
+// data record holds samps[i] little-endian 16-bit samples for each
+// signal i in turn.
+//
+//-----------------------------------------------------------------------------
+
+// constants: sizes and offsets of the EDF header fields we use
+//
+static const long EDF_FIXED_BYTES = 256;
+static const long EDF_SIGNAL_BYTES = 256;
+static const long EDF_OFF_HDR_BYTES = 184;
+static const long EDF_OFF_NUM_RECS = 236;
+static const long EDF_OFF_REC_DUR = 244;
+static const long EDF_OFF_NUM_SIGS = 252;
+
+// constants: how much of a file the kernel is asked to read ahead when
+// it is opened
+//
+static const long READAHEAD_BYTES = 16 * 1024 * 1024;
+
+// constants: how much raw data is decoded at a time when a whole file
+// is read
+//
+static const long DECODE_BYTES = 4 * 1024 * 1024;
+
+// function: read_at
+//
+// arguments:
+//  int fd: an open file (input)
+//  void* buf: where to store the data (output)
+//  long nbytes: number of bytes to read (input)
+//  long off: offset in the file (input)
+//
+// return: the number of bytes read, which is less than nbytes only at
+//         the end of the file or on error
+//
+// pread() may return less than it is asked for, so this loops until
+// the whole range is in.
+//
+static long read_at(int fd_a, void* buf_a, long nbytes_a, long off_a) {
+
+  long total = 0;
+  while (total < nbytes_a) {
+    ssize_t n = pread(fd_a, (char*)buf_a + total, nbytes_a - total,
+		      off_a + total);
+    if (n < 0) {
+      if (errno == EINTR) {
+	continue;
+      }
+      break;
+    }
+    if (n == 0) {
+      break;
+    }
+    total += n;
+  }
+  return total;
+}
+
+// function: edf_field
+//
+// arguments:
+//  const char* buf: header buffer (input)
+//  long off: offset of the field (input)
+//  long len: length of the field (input)
+//
+// return: the field as a string with trailing blanks removed
+//
+static std::string edf_field(const char* buf_a, long off_a, long len_a) {
+  std::string str(buf_a + off_a, len_a);
+  size_t end = str.find_last_not_of(' ');
+  return (end == std::string::npos) ? std::string() : str.substr(0, end + 1);
+}
+
+//-----------------------------------------------------------------------------
+//
+// MplpcRing methods
+//
+//-----------------------------------------------------------------------------
+
+// method: default constructor
+//
+// the ring itself is only set up by the first wait(), so objects that
+// never read data records don't hold one.
+//
+MplpcRing::MplpcRing() {
+  tried_d = false;
+  ring_fd_d = -1;
+  sq_entries_d = 0;
+  sq_ptr_d = (void*)NULL;
+  sq_bytes_d = 0;
+  cq_ptr_d = (void*)NULL;
+  cq_bytes_d = 0;
+  sqes_d = (void*)NULL;
+  sqes_bytes_d = 0;
+}
+
+// method: destructor
+//
+MplpcRing::~MplpcRing() {
+  release();
+}
+
+// method: add
+//
+// arguments:
+//  int fd: an open file (input)
+//  void* buf: where to store the data (output)
+//  long nbytes: number of bytes to read (input)
+//  long off: offset in the file (input)
+//
+// return: none
+//
+// This method queues a read; nothing is read until wait() is called.
+// Long reads are split into CHUNK_BYTES pieces that are read in
+// parallel.
+//
+void MplpcRing::add(int fd_a, void* buf_a, long nbytes_a, long off_a) {
+
+  for (long beg = 0; beg < nbytes_a; beg += CHUNK_BYTES) {
+    Read rd;
+    rd.fd_d = fd_a;
+    rd.off_d = off_a + beg;
+    rd.done_d = 0;
+    rd.iov_d.iov_base = (char*)buf_a + beg;
+    rd.iov_d.iov_len = std::min(CHUNK_BYTES, nbytes_a - beg);
+    reads_d.push_back(rd);
+  }
+}
+
+// method: wait
+//
+// arguments: none
+//
+// return: a boolean indicating status, false if any read came up short
+//
+// This method issues the queued reads and waits for all of them. Reads
+// the ring doesn't complete - short reads, errors, or all of them when
+// there is no ring - are finished with pread().
+//
+bool MplpcRing::wait() {
+
+  // set up the ring the first time it is needed
+  //
+  if (!tried_d) {
+    tried_d = true;
+    if (!setup()) {
+      release();
+    }
+  }
+
+  // submit the reads a queue at a time
+  //
+  long num_reads = reads_d.size();
+  for (long beg = 0; (ring_fd_d >= 0) && (beg < num_reads);
+       beg += sq_entries_d) {
+    submit(beg, std::min((long)sq_entries_d, num_reads - beg));
+  }
+
+  // finish what is left
+  //
+  bool status = true;
+  for (long i = 0; i < num_reads; i++) {
+    Read& rd = reads_d[i];
+    long len = rd.iov_d.iov_len;
+    if (rd.done_d < len) {
+      rd.done_d += read_at(rd.fd_d, (char*)rd.iov_d.iov_base + rd.done_d,
+			   len - rd.done_d, rd.off_d + rd.done_d);
+    }
+    status &= (rd.done_d == len);
+  }
+  reads_d.clear();
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: setup
+//
+// arguments: none
+//
+// return: a boolean indicating status
+//
+// This method creates the ring and maps its queues. It fails quietly,
+// which leaves the reads to pread(), when the kernel has no io_uring or
+// it is not allowed, as under some container seccomp profiles.
+//
+bool MplpcRing::setup() {
+
+#ifdef MPLPC_URING
+
+  // create the ring
+  //
+  struct io_uring_params par;
+  memset(&par, 0, sizeof(par));
+  ring_fd_d = syscall(__NR_io_uring_setup, (unsigned)QUEUE_DEPTH, &par);
+  if (ring_fd_d < 0) {
+    return false;
+  }
+  sq_entries_d = par.sq_entries;
+
+  // map the submission and completion rings: newer kernels map them
+  // together
+  //
+  sq_bytes_d = par.sq_off.array + par.sq_entries * sizeof(unsigned);
+  cq_bytes_d = par.cq_off.cqes +
+    par.cq_entries * sizeof(struct io_uring_cqe);
+  bool single = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+  single = (par.features & IORING_FEAT_SINGLE_MMAP) != 0;
+#endif
+  if (single) {
+    sq_bytes_d = std::max(sq_bytes_d, cq_bytes_d);
+  }
+  sq_ptr_d = mmap(NULL, sq_bytes_d, PROT_READ | PROT_WRITE,
+		  MAP_SHARED | MAP_POPULATE, ring_fd_d, IORING_OFF_SQ_RING);
+  if (sq_ptr_d == MAP_FAILED) {
+    sq_ptr_d = (void*)NULL;
+    return false;
+  }
+  if (single) {
+    cq_ptr_d = sq_ptr_d;
+  }
+  else {
+    cq_ptr_d = mmap(NULL, cq_bytes_d, PROT_READ | PROT_WRITE,
+		    MAP_SHARED | MAP_POPULATE, ring_fd_d, IORING_OFF_CQ_RING);
+    if (cq_ptr_d == MAP_FAILED) {
+      cq_ptr_d = (void*)NULL;
+      return false;
+    }
+  }
+  sqes_bytes_d = par.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_d = mmap(NULL, sqes_bytes_d, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring_fd_d, IORING_OFF_SQES);
+  if (sqes_d == MAP_FAILED) {
+    sqes_d = (void*)NULL;
+    return false;
+  }
+
+  // locate the fields of the rings
+  //
+  char* sq = (char*)sq_ptr_d;
+  char* cq = (char*)cq_ptr_d;
+  sq_head_d = (unsigned*)(sq + par.sq_off.head);
+  sq_tail_d = (unsigned*)(sq + par.sq_off.tail);
+  sq_mask_d = (unsigned*)(sq + par.sq_off.ring_mask);
+  sq_array_d = (unsigned*)(sq + par.sq_off.array);
+  cq_head_d = (unsigned*)(cq + par.cq_off.head);
+  cq_tail_d = (unsigned*)(cq + par.cq_off.tail);
+  cq_mask_d = (unsigned*)(cq + par.cq_off.ring_mask);
+  cqes_d = cq + par.cq_off.cqes;
+
+  // exit gracefully
+  //
+  return true;
+
+#else
+  return false;
+#endif
+}
+
+// method: release
+//
+// arguments: none
+//
+// return: none
+//
+// This method unmaps the queues and closes the ring.
+//
+void MplpcRing::release() {
+
+#ifdef MPLPC_URING
+  if (sqes_d != (void*)NULL) {
+    munmap(sqes_d, sqes_bytes_d);
+  }
+  if ((cq_ptr_d != (void*)NULL) && (cq_ptr_d != sq_ptr_d)) {
+    munmap(cq_ptr_d, cq_bytes_d);
+  }
+  if (sq_ptr_d != (void*)NULL) {
+    munmap(sq_ptr_d, sq_bytes_d);
+  }
+#endif
+  if (ring_fd_d >= 0) {
+    close(ring_fd_d);
+  }
+  ring_fd_d = -1;
+  sq_ptr_d = (void*)NULL;
+  cq_ptr_d = (void*)NULL;
+  sqes_d = (void*)NULL;
+}
+
+// method: submit
+//
+// arguments:
+//  long beg: index of the first read (input)
+//  long num: number of reads, at most the size of the queue (input)
+//
+// return: none
+//
+// This method puts reads on the submission queue and waits until they
+// have all completed. The bytes each read got are added to its count;
+// a read that fails is left for wait() to retry with pread().
+//
+void MplpcRing::submit(long beg_a, long num_a) {
+
+#ifdef MPLPC_URING
+
+  // fill in the submission entries
+  //
+  struct io_uring_sqe* sqes = (struct io_uring_sqe*)sqes_d;
+  unsigned tail = *sq_tail_d;
+  for (long i = 0; i < num_a; i++) {
+    Read& rd = reads_d[beg_a + i];
+    unsigned idx = tail & *sq_mask_d;
+    struct io_uring_sqe* sqe = &sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = rd.fd_d;
+    sqe->off = rd.off_d;
+    sqe->addr = (unsigned long)&rd.iov_d;
+    sqe->len = 1;
+    sqe->user_data = beg_a + i;
+    sq_array_d[idx] = idx;
+    tail++;
+  }
+  __atomic_store_n(sq_tail_d, tail, __ATOMIC_RELEASE);
+
+  // submit them and collect the completions: the kernel may take the
+  // submissions in several calls
+  //
+  long num_done = 0;
+  while (num_done < num_a) {
+    unsigned pending = tail - __atomic_load_n(sq_head_d, __ATOMIC_ACQUIRE);
+    long ret = syscall(__NR_io_uring_enter, ring_fd_d, pending, 1,
+		       IORING_ENTER_GETEVENTS, NULL, 0);
+    if ((ret < 0) && (errno != EINTR) && (errno != EAGAIN) &&
+	(errno != EBUSY)) {
+
+      // nothing more can be waited for: reads that are still in flight
+      // would land in buffers that are about to be reused, so the ring
+      // is only given up when none are
+      //
+      if ((long)pending == num_a - num_done) {
+	break;
+      }
+    }
+
+    unsigned head = *cq_head_d;
+    unsigned ctail = __atomic_load_n(cq_tail_d, __ATOMIC_ACQUIRE);
+    struct io_uring_cqe* cqes = (struct io_uring_cqe*)cqes_d;
+    for (; head != ctail; head++) {
+      struct io_uring_cqe* cqe = &cqes[head & *cq_mask_d];
+      if (cqe->res > 0) {
+	reads_d[cqe->user_data].done_d = cqe->res;
+      }
+      num_done++;
+    }
+    __atomic_store_n(cq_head_d, head, __ATOMIC_RELEASE);
+  }
+
+  // a ring that failed isn't used again
+  //
+  if (num_done < num_a) {
+    release();
+  }
+
+#endif
+}
+
+// method: open_input
+//
+// arguments:
+//  MplpcInput& in: the opened file (output)
+//  char* iname: EDF or raw sample filename (input)
+//
+// return: a boolean indicating status, false if the file can't be
+//         opened
+//
+// This method opens a file for its analysis. Whether it is an EDF file
+// is decided by the Edf class, as everywhere else. When the file will
+// be read from its data records (stream_recs_d or direct_read_d set),
+// its header is parsed here, once, and kept with the descriptor, so
+// compute_00_edf_stream and read_edf_direct don't open the file or read
+// the header again. Otherwise Edf::read_edf parses the header, and it
+// isn't parsed here as well. The kernel is asked to start reading the
+// data in the background, so a driver that opens the next files early
+// has their reads in flight while it analyzes the current one.
+//
+// The input is set up even when the file can't be opened or its header
+// doesn't parse, so that the reader that handles it reports the error.
+//
+bool Mplpc::open_input(MplpcInput& in_a, char* iname_a) {
+
+  // open the file and parse the header of an EDF file
+  //
+  in_a.clear();
+  in_a.fname_d = iname_a;
+  in_a.is_edf_d = edf_d.is_edf(iname_a);
+  in_a.fd_d = open(iname_a, O_RDONLY);
+  if (in_a.fd_d < 0) {
+    return false;
+  }
+  if (in_a.is_edf_d && ((stream_recs_d > 0) || (direct_read_d > 0))) {
+    in_a.has_hdr_d = Mplpc::read_edf_header(in_a.hdr_d, in_a.fd_d);
+  }
+
+  // start reading the data
+  //
+  long beg = in_a.has_hdr_d ? in_a.hdr_d.hdr_bytes_d : 0;
+  posix_fadvise(in_a.fd_d, beg, 0, POSIX_FADV_SEQUENTIAL);
+  posix_fadvise(in_a.fd_d, beg, READAHEAD_BYTES, POSIX_FADV_WILLNEED);
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: read_edf_header
+//
+// arguments:
+//  MplpcEdfHeader& hdr: the parsed header (output)
+//  int fd: an open file (input)
+//
+// return: a boolean indicating status
+//
+// This method parses the EDF header. Labels are uppercased to match the
+// way channel selection strings are parsed. A file that is too short or
+// doesn't start with the EDF version field can't be read from its data
+// records, which is not reported as an error here: the readers leave
+// such files to the Edf class.
+//
+bool Mplpc::read_edf_header(MplpcEdfHeader& hdr_a, int fd_a) {
+
+  // read the fixed part of the header
+  //
+  char fixed[EDF_FIXED_BYTES];
+  if ((read_at(fd_a, fixed, EDF_FIXED_BYTES, 0) != EDF_FIXED_BYTES) ||
+      (edf_field(fixed, 0, 8) != "0")) {
+    return false;
+  }
+  hdr_a.hdr_bytes_d = atol(edf_field(fixed, EDF_OFF_HDR_BYTES, 8).c_str());
+  hdr_a.num_recs_d = atol(edf_field(fixed, EDF_OFF_NUM_RECS, 8).c_str());
+  hdr_a.rec_dur_d = atof(edf_field(fixed, EDF_OFF_REC_DUR, 8).c_str());
+  hdr_a.num_sigs_d = atol(edf_field(fixed, EDF_OFF_NUM_SIGS, 4).c_str());
+
+  long ns = hdr_a.num_sigs_d;
+  if ((ns <= 0) ||
+      (hdr_a.hdr_bytes_d != EDF_FIXED_BYTES + ns * EDF_SIGNAL_BYTES)) {
+    fprintf(stdout, "   Mplpc::read_edf_header(): invalid header\n");
+    return false;
+  }
+
+  // read the signal part of the header
+  //
+  std::vector<char> sigs(ns * EDF_SIGNAL_BYTES);
+  if (read_at(fd_a, sigs.data(), sigs.size(), EDF_FIXED_BYTES) !=
+      (long)sigs.size()) {
+    fprintf(stdout, "   Mplpc::read_edf_header(): error reading header\n");
+    return false;
+  }
+
+  // parse the per-signal fields: each field is stored for all signals
+  // before the next field starts
+  //
+  const char* buf = sigs.data();
+  long off_pmin = ns * (16 + 80 + 8);
+  long off_pmax = off_pmin + ns * 8;
+  long off_dmin = off_pmax + ns * 8;
+  long off_dmax = off_dmin + ns * 8;
+  long off_samps = off_dmax + ns * 8 + ns * 80;
+
+  hdr_a.labels_d.resize(ns);
+  hdr_a.samps_d.resize(ns);
+  hdr_a.offs_d.resize(ns);
+  hdr_a.scale_d.resize(ns);
+  hdr_a.offset_d.resize(ns);
+  hdr_a.rec_samps_d = 0;
+
+  for (long i = 0; i < ns; i++) {
+
+    // uppercase the label
+    //
+    std::string label = edf_field(buf, i * 16, 16);
+    for (long j = 0; j < (long)label.size(); j++) {
+      label[j] = toupper(label[j]);
+    }
+    hdr_a.labels_d[i] = label;
+
+    // compute the conversion from digital to physical units:
+    //  phys = (dig - dmin) * (pmax - pmin) / (dmax - dmin) + pmin
+    //
+    double pmin = atof(edf_field(buf, off_pmin + i * 8, 8).c_str());
+    double pmax = atof(edf_field(buf, off_pmax + i * 8, 8).c_str());
+    double dmin = atof(edf_field(buf, off_dmin + i * 8, 8).c_str());
+    double dmax = atof(edf_field(buf, off_dmax + i * 8, 8).c_str());
+    hdr_a.scale_d[i] = (dmax != dmin) ? (pmax - pmin) / (dmax - dmin) : 1.0;
+    hdr_a.offset_d[i] = pmin - dmin * hdr_a.scale_d[i];
+
+    // locate the signal within a data record
+    //
+    hdr_a.samps_d[i] = atol(edf_field(buf, off_samps + i * 8, 8).c_str());
+    hdr_a.offs_d[i] = hdr_a.rec_samps_d;
+    hdr_a.rec_samps_d += hdr_a.samps_d[i];
+  }
+
+  // some writers leave the number of records as -1: work it out from
+  // the size of the file
+  //
+  struct stat st;
+  if (fstat(fd_a, &st) != 0) {
+    fprintf(stdout, "   Mplpc::read_edf_header(): invalid header\n");
+    return false;
+  }
+  hdr_a.file_bytes_d = st.st_size;
+  if (hdr_a.num_recs_d < 0) {
+    if (hdr_a.rec_samps_d <= 0) {
+      fprintf(stdout, "   Mplpc::read_edf_header(): invalid header\n");
+      return false;
+    }
+    long data_bytes = hdr_a.file_bytes_d - hdr_a.hdr_bytes_d;
+    hdr_a.num_recs_d = data_bytes / (hdr_a.rec_samps_d * sizeof(short int));
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: read_edf_records
+//
+// arguments:
+//  VVectorDouble& sig: one vector per signal (output)
+//  MplpcEdfHeader& hdr: the parsed header (input)
+//  int fd: an open EDF file (input)
+//  long rec: index of the first data record (input)
+//  long num_recs: number of data records to read (input)
+//  const std::vector<char>& need: the signals to convert (input)
+//
+// return: a boolean indicating status
+//
+// This method reads num_recs data records and converts the signals that
+// are needed to physical units. The others are skipped and left empty.
+// The output vectors are resized to the number of samples read, so they
+// can be reused from one block to the next without reallocation. The
+// records are read as a batch of requests (see MplpcRing), and the
+// kernel is asked to read the following records in the background while
+// these are analyzed.
+//
+bool Mplpc::read_edf_records(VVectorDouble& sig_a, MplpcEdfHeader& hdr_a,
+			     int fd_a, long rec_a, long num_recs_a,
+			     const std::vector<char>& need_a) {
+
+  // read the raw records and start on the next ones
+  //
+  long rec_bytes = hdr_a.rec_samps_d * sizeof(short int);
+  long off = hdr_a.hdr_bytes_d + rec_a * rec_bytes;
+  std::vector<short int> buf(num_recs_a * hdr_a.rec_samps_d);
+  ring_d.add(fd_a, buf.data(), num_recs_a * rec_bytes, off);
+  if (!ring_d.wait()) {
+    fprintf(stdout, "   Mplpc::read_edf_records(): error reading data\n");
+    return false;
+  }
+  posix_fadvise(fd_a, off + num_recs_a * rec_bytes, num_recs_a * rec_bytes,
+		POSIX_FADV_WILLNEED);
+
+  // demultiplex and scale each signal that is needed
+  //
+  sig_a.resize(hdr_a.num_sigs_d);
+  for (long i = 0; i < hdr_a.num_sigs_d; i++) {
+    if (!need_a[i]) {
+      sig_a[i].clear();
+      continue;
+    }
+    long spr = hdr_a.samps_d[i];
+    double scale = hdr_a.scale_d[i];
+    double offset = hdr_a.offset_d[i];
+    sig_a[i].resize(num_recs_a * spr);
+
+    for (long r = 0; r < num_recs_a; r++) {
+      const short int* src = buf.data() + r * hdr_a.rec_samps_d +
+	hdr_a.offs_d[i];
+      double* dst = sig_a[i].data() + r * spr;
+      for (long j = 0; j < spr; j++) {
+	dst[j] = src[j] * scale + offset;
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: find_label
+//
+// arguments:
+//  MplpcEdfHeader& hdr: the parsed header (input)
+//  std::vector<char>& sel: the signals that can be used (input)
+//  const char* name: the name to look for (input)
+//  bool partial: if true, the name only has to appear in the label (input)
+//
+// return: the index of the first usable signal that matches, or -1
+//
+long Mplpc::find_label(MplpcEdfHeader& hdr_a, std::vector<char>& sel_a,
+		       const char* name_a, bool partial_a) {
+
+  // uppercase the name
+  //
+  std::string name(name_a);
+  for (long j = 0; j < (long)name.size(); j++) {
+    name[j] = toupper(name[j]);
+  }
+
+  // search the labels
+  //
+  for (long i = 0; i < hdr_a.num_sigs_d; i++) {
+    if (!sel_a[i]) {
+      continue;
+    }
+    if ((!partial_a && (hdr_a.labels_d[i] == name)) ||
+	(partial_a && (hdr_a.labels_d[i].find(name) != std::string::npos))) {
+      return i;
+    }
+  }
+
+  // exit ungracefully
+  //
+  return (long)-1;
+}
+
+// method: resolve_channels
+//
+// arguments:
+//  std::vector<long>& chan_a: first signal of each output channel (output)
+//  std::vector<long>& chan_b: signal subtracted from it, or -1 (output)
+//  long& num_sel: number of signals the selection keeps (output)
+//  MplpcEdfHeader& hdr: the parsed header (input)
+//
+// return: a boolean indicating status
+//
+// This method applies the channel selection and the montage to the
+// labels in the header, producing for each output channel the signals
+// it is built from. num_sel is the number of channels Edf::select()
+// would keep. A montage line has the form:
+//
+//  0, FP1-F7: EEG FP1-REF -- EEG F7-REF
+//
+// If no montage is given, the selected signals are used as is.
+//
+bool Mplpc::resolve_channels(std::vector<long>& chan_a,
+			     std::vector<long>& chan_b, long& num_sel_a,
+			     MplpcEdfHeader& hdr_a) {
+
+  // declare local variables
+  //
+  long ns = hdr_a.num_sigs_d;
+  bool partial = (strcmp(match_mode_str_d, MATMODE_NAME_01) == 0);
+  bool remove = (strcmp(select_mode_str_d, SELMODE_NAME_01) == 0);
+  std::vector<char> sel(ns, (char)true);
+
+  // apply the channel selection: an empty selection keeps everything
+  //
+  if ((cselect_d[0] != (char)NULL) &&
+      (strcmp(cselect_d, Edf::NULL_NAME) != 0)) {
+
+    char tmp_str[Edf::MAX_LSTR_LENGTH];
+    char* labels[Edf::MAX_LSTR_LENGTH];
+    char delim[] = ",";
+    long nl = 0;
+    strcpy(tmp_str, cselect_d);
+    Mplpc::parse_param(nl, labels, tmp_str, delim);
+
+    std::vector<char> all(ns, (char)true);
+    std::vector<char> found(ns, (char)false);
+    for (long i = 0; i < nl; i++) {
+      for (long j = 0; j < ns; j++) {
+	if ((!partial && (hdr_a.labels_d[j] == labels[i])) ||
+	    (partial &&
+	     (hdr_a.labels_d[j].find(labels[i]) != std::string::npos))) {
+	  found[j] = true;
+	}
+      }
+      delete [] labels[i];
+    }
+    for (long j = 0; j < ns; j++) {
+      sel[j] = remove ? !found[j] : found[j];
+    }
+  }
+
+  // case 1: no montage - use the selected signals
+  //
+  num_sel_a = std::count(sel.begin(), sel.end(), (char)true);
+  chan_a.clear();
+  chan_b.clear();
+  if ((montage_d[0] == (char*)NULL) ||
+      (strcmp(montage_d[0], Edf::NULL_NAME) == 0)) {
+    for (long j = 0; j < ns; j++) {
+      if (sel[j]) {
+	chan_a.push_back(j);
+	chan_b.push_back((long)-1);
+      }
+    }
+    return (chan_a.size() > 0);
+  }
+
+  // case 2: resolve each montage line
+  //
+  for (long i = 0; i < num_montage_d; i++) {
+
+    // skip the channel number and name
+    //
+    std::string expr(montage_d[i]);
+    size_t pos = expr.find(':');
+    if (pos == std::string::npos) {
+      pos = expr.find(',');
+    }
+    if (pos != std::string::npos) {
+      expr = expr.substr(pos + 1);
+    }
+
+    // split the expression into its terms
+    //
+    std::string term_a = expr;
+    std::string term_b;
+    pos = expr.find("--");
+    if (pos != std::string::npos) {
+      term_a = expr.substr(0, pos);
+      term_b = expr.substr(pos + 2);
+    }
+    term_a.erase(0, term_a.find_first_not_of(' '));
+    term_a.erase(term_a.find_last_not_of(' ') + 1);
+    term_b.erase(0, term_b.find_first_not_of(' '));
+    term_b.erase(term_b.find_last_not_of(' ') + 1);
+
+    // look up the terms
+    //
+    long ia = Mplpc::find_label(hdr_a, sel, term_a.c_str(), partial);
+    long ib = (long)-1;
+    if (term_b.size() > 0) {
+      ib = Mplpc::find_label(hdr_a, sel, term_b.c_str(), partial);
+    }
+    if ((ia < 0) || ((term_b.size() > 0) && (ib < 0))) {
+      if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+	fprintf(stdout,
+		"   Mplpc::resolve_channels(): can't resolve [%s]\n",
+		montage_d[i]);
+      }
+      return false;
+    }
+    chan_a.push_back(ia);
+    chan_b.push_back(ib);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: resolve_direct
+//
+// arguments:
+//  std::vector<long>& chan_a: first signal of each output channel (output)
+//  std::vector<long>& chan_b: signal subtracted from it, or -1 (output)
+//  std::vector<char>& need: the signals the channels use (output)
+//  long& num_sel: number of signals the selection keeps (output)
+//  MplpcEdfHeader& hdr: the parsed header (input)
+//
+// return: a boolean indicating status
+//
+// This method resolves the channels of a file that is to be read
+// directly from its data records: this fails when the montage can't be
+// resolved, the signals it uses have different sample frequencies or
+// the file is shorter than its header says, in which case the Edf class
+// reads the file.
+//
+bool Mplpc::resolve_direct(std::vector<long>& chan_a,
+			   std::vector<long>& chan_b, std::vector<char>& need_a,
+			   long& num_sel_a, MplpcEdfHeader& hdr_a) {
+
+  // make sure every data record is in the file
+  //
+  long data_bytes = hdr_a.num_recs_d * hdr_a.rec_samps_d * sizeof(short int);
+  if (hdr_a.hdr_bytes_d + data_bytes > hdr_a.file_bytes_d) {
+    return false;
+  }
+
+  // resolve the montage
+  //
+  if (!Mplpc::resolve_channels(chan_a, chan_b, num_sel_a, hdr_a)) {
+    return false;
+  }
+
+  // make sure all the signals have the same sample frequency
+  //
+  need_a.assign(hdr_a.num_sigs_d, (char)false);
+  long spr = hdr_a.samps_d[chan_a[0]];
+  for (long i = 0; i < (long)chan_a.size(); i++) {
+    if ((hdr_a.samps_d[chan_a[i]] != spr) ||
+	((chan_b[i] >= 0) && (hdr_a.samps_d[chan_b[i]] != spr))) {
+      return false;
+    }
+    need_a[chan_a[i]] = true;
+    if (chan_b[i] >= 0) {
+      need_a[chan_b[i]] = true;
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: read_edf_direct
+//
+// arguments:
+//  MplpcInput& in: an EDF file from open_input, decoded (input/output)
+//  std::vector<long>& chan_a: first signal of each output channel (input)
+//  std::vector<long>& chan_b: signal subtracted from it, or -1 (input)
+//  std::vector<char>& need: the signals the channels use (input)
+//  long num_sel: number of signals the selection keeps (input)
+//
+// return: a boolean indicating status
+//
+// This method reads a whole EDF file from its data records, a few
+// records at a time, and builds the montage channels as it goes. Only
+// the signals the montage uses are converted, so a file with many
+// auxiliary signals costs little more to read than the montage itself,
+// and only the montage channels are held in memory. The channels are
+// computed exactly as in compute_00_edf_stream().
+//
+// The Edf object isn't loaded, so the sample frequency is worked out
+// from the header, as the number of samples per record over the record
+// duration. run_mplpc -verify compares this path against the Edf class.
+//
+bool Mplpc::read_edf_direct(MplpcInput& in_a, std::vector<long>& chan_a,
+			    std::vector<long>& chan_b,
+			    std::vector<char>& need_a, long num_sel_a) {
+
+  // declare local variables
+  //
+  MplpcEdfHeader& hdr = in_a.hdr_d;
+  long num_chans = chan_a.size();
+  long spr = hdr.samps_d[chan_a[0]];
+  long rec_bytes = hdr.rec_samps_d * sizeof(short int);
+  long block_recs = std::max(DECODE_BYTES / std::max(rec_bytes, 1L), 1L);
+  VVectorDouble sig_t;
+
+  // allocate the channels
+  //
+  in_a.sig_d.assign(num_chans, VectorDouble(hdr.num_recs_d * spr));
+
+  // read a block of records at a time and apply the montage to it
+  //
+  long long prof_t = MplpcTrace::now();
+  for (long r = 0; r < hdr.num_recs_d; r += block_recs) {
+    long nr = std::min(block_recs, hdr.num_recs_d - r);
+    if (!Mplpc::read_edf_records(sig_t, hdr, in_a.fd_d, r, nr, need_a)) {
+      return false;
+    }
+    if (profile_d) {
+      in_a.prof_d.lap(MplpcProfile::READ, prof_t);
+    }
+    for (long i = 0; i < num_chans; i++) {
+      const double* sa = sig_t[chan_a[i]].data();
+      double* dst = in_a.sig_d[i].data() + r * spr;
+      long n = nr * spr;
+      if (chan_b[i] >= 0) {
+	const double* sb = sig_t[chan_b[i]].data();
+	for (long j = 0; j < n; j++) {
+	  dst[j] = sa[j] - sb[j];
+	}
+      }
+      else {
+	std::copy(sa, sa + n, dst);
+      }
+    }
+    if (profile_d) {
+      in_a.prof_d.lap(MplpcProfile::MONTAGE, prof_t);
+    }
+  }
+
+  // pick up the sample frequency and number of channels
+  //
+  in_a.sample_freq_d = spr / hdr.rec_dur_d;
+  in_a.num_chan_file_d = hdr.num_sigs_d;
+  in_a.num_chan_proc_d = num_sel_a;
+  in_a.decoded_d = true;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: compute_00_edf_stream
+//
+// arguments:
+//  VMplpcPulses& sig: pulses for each channel (output)
+//  MplpcInput& in: an EDF file from open_input (input)
+//
+// return: a boolean indicating status
+//
+// This method is the streaming version of compute_00_edf: it reads
+// stream_recs_d data records at a time, applies the channel selection
+// and montage to just those records, and feeds each montage channel to
+// its own block-by-block analysis. Peak memory depends on the block
+// size rather than on the length of the recording.
+//
+// This reader is only used when stream_recs_d is set: it applies the
+// channel selection and montage itself (see resolve_channels) instead
+// of Edf::select and Edf::apply_montage. run_mplpc -verify, and the
+// make check target of run_mplpc, compare it with the Edf class.
+//
+// When the signal is debiased, a prescan computes the mean of each
+// montage channel first. Files whose montage can't be resolved here,
+// or whose channels have different sample frequencies, are handed to
+// compute_00_edf.
+//
+bool Mplpc::compute_00_edf_stream(VMplpcPulses& sig_a, MplpcInput& in_a) {
+
+  // declare local variables
+  //
+  MplpcEdfHeader& hdr = in_a.hdr_d;
+  int fd = in_a.fd_d;
+  char* iname = (char*)in_a.fname_d.c_str();
+  std::vector<long> chan_a;
+  std::vector<long> chan_b;
+  std::vector<char> need;
+  long num_sel = 0;
+  bool status = true;
+
+  // display a debug message
+  //
+  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+    fprintf(stdout,
+	    "   Mplpc::compute_00_edf_stream(): begin edf data processing\n");
+  }
+
+  // the file was opened and its header parsed by open_input
+  //
+  long long prof_t = MplpcTrace::now();
+  if (fd < 0) {
+    fprintf(stdout,
+	    "   Mplpc::compute_00_edf_stream(): error opening file (%s)\n",
+	    iname);
+    return false;
+  }
+  if (!in_a.has_hdr_d) {
+    fprintf(stdout,
+	    "   Mplpc::compute_00_edf_stream(): error reading header (%s)\n",
+	    iname);
+    return false;
+  }
+
+  // resolve the montage and make sure all the channels we need have
+  // the same sample frequency
+  //
+  if (!Mplpc::resolve_direct(chan_a, chan_b, need, num_sel, hdr)) {
+    if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+      fprintf(stdout,
+	      "   Mplpc::compute_00_edf_stream(): reading the whole file\n");
+    }
+    return Mplpc::read_edf_input(in_a) && Mplpc::compute_00_edf(sig_a, in_a);
+  }
+  long num_chans = chan_a.size();
+
+  // pick up the sample frequency and number of channels
+  //
+  if (profile_d) {
+    prof_d.lap(MplpcProfile::SELECT, prof_t);
+  }
+  sample_freq_d = hdr.samps_d[chan_a[0]] / hdr.rec_dur_d;
+  num_chan_file_d = hdr.num_sigs_d;
+  num_chan_proc_d = num_sel;
+
+  // define a function that reads a block and applies the montage
+  //
+  VVectorDouble sig_t;
+  VVectorDouble sig_f(num_chans);
+  auto read_block = [&](long rec, long num_recs) {
+    MPLPC_TRACE_SCOPE("read");
+    prof_t = MplpcTrace::now();
+    if (!Mplpc::read_edf_records(sig_t, hdr, fd, rec, num_recs, need)) {
+      return false;
+    }
+    if (profile_d) {
+      prof_d.lap(MplpcProfile::READ, prof_t);
+    }
+    for (long i = 0; i < num_chans; i++) {
+      sig_f[i] = sig_t[chan_a[i]];
+      if (chan_b[i] >= 0) {
+	VectorDouble& sb = sig_t[chan_b[i]];
+	for (long j = 0; j < (long)sig_f[i].size(); j++) {
+	  sig_f[i][j] -= sb[j];
+	}
+      }
+    }
+    if (profile_d) {
+      prof_d.lap(MplpcProfile::MONTAGE, prof_t);
+    }
+    return true;
+  };
+
+  // step 1: prescan the file to compute the mean of each channel. the
+  // sum is accumulated in the same order as compute_mean() so the
+  // result is the same.
+  //
+  std::vector<double> bias(num_chans, 0.0);
+  if (debias_mode_d == Mplpc::DBS_SIGNAL) {
+    std::vector<double> sum(num_chans, 0.0);
+    long count = 0;
+    for (long r = 0; status && (r < hdr.num_recs_d); r += stream_recs_d) {
+      long nr = std::min(stream_recs_d, hdr.num_recs_d - r);
+      if (!(status = read_block(r, nr))) {
+	break;
+      }
+      for (long i = 0; i < num_chans; i++) {
+	for (long j = 0; j < (long)sig_f[i].size(); j++) {
+	  sum[i] += sig_f[i][j];
+	}
+      }
+      count += sig_f[0].size();
+      if (profile_d) {
+	prof_d.lap(MplpcProfile::PREEMPH, prof_t);
+      }
+    }
+    for (long i = 0; i < num_chans; i++) {
+      bias[i] = (count > 0) ? sum[i] / (double)count : 0.0;
+    }
+    posix_fadvise(fd, hdr.hdr_bytes_d, READAHEAD_BYTES, POSIX_FADV_WILLNEED);
+  }
+
+  // step 2: analyze the file one block at a time
+  //
+  std::vector<MplpcState> states(num_chans);
+  sig_a.resize(num_chans);
+  for (long i = 0; status && (i < num_chans); i++) {
+    status = Mplpc::compute_mplpc_open(states[i], sig_a[i], bias[i]);
+  }
+
+  for (long r = 0; status && (r < hdr.num_recs_d); r += stream_recs_d) {
+    long nr = std::min(stream_recs_d, hdr.num_recs_d - r);
+    if (!(status = read_block(r, nr))) {
+      break;
+    }
+    if ((num_threads_d > 1) && (num_chans < num_threads_d)) {
+
+      // too few channels to keep the threads busy: split the frames
+      // of each channel among them
+      //
+      for (long i = 0; status && (i < num_chans); i++) {
+	status = Mplpc::compute_mplpc_block(states[i], sig_a[i], sig_f[i],
+					    Mplpc::ALL_WORKERS);
+      }
+    }
+    else {
+      status = Mplpc::run_workers(num_chans, [&](long i, long w) {
+	return Mplpc::compute_mplpc_block(states[i], sig_a[i], sig_f[i], w);
+      });
+    }
+  }
+
+  for (long i = 0; status && (i < num_chans); i++) {
+    status = Mplpc::compute_mplpc_close(states[i], sig_a[i]);
+  }
+
+  // display a debug message
+  //
+  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+    fprintf(stdout,
+	    "   Mplpc::compute_00_edf_stream(): end edf data processing\n");
+  }
+
+  // exit gracefully
+  //
+  return status;
+}
+
+//
+// end of file
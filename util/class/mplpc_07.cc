@@ -0,0 +1,302 @@
+// This file contains the tracing and profiling facilities used to
+// measure the analysis (see MplpcTrace and MplpcProfile in Mplpc.h).
+//
+
+// system include files
+//
+#include <chrono>
+#include <mutex>
+
+// local include files
+//
+#include "Mplpc.h"
+
+//-----------------------------------------------------------------------------
+//
+// per-thread span buffers: each thread appends to its own buffer without
+// locking. the buffers are registered in a global list the first time a
+// thread records a span, and are never freed, so spans recorded by
+// worker threads that have since exited can still be written.
+//
+//-----------------------------------------------------------------------------
+
+// a recorded span
+//
+class MplpcSpan {
+public:
+  const char* name_d;                   // span name
+  long long beg_d;                      // start time (ns)
+  long long end_d;                      // end time (ns)
+};
+
+// the spans of one thread
+//
+class MplpcSpanBuffer {
+public:
+  long tid_d;                           // thread index in the trace
+  std::vector<MplpcSpan> spans_d;       // recorded spans
+};
+
+static std::mutex trace_mutex;
+static std::vector<MplpcSpanBuffer*> trace_buffers;
+static thread_local MplpcSpanBuffer* trace_local = (MplpcSpanBuffer*)NULL;
+static const std::chrono::steady_clock::time_point trace_epoch =
+  std::chrono::steady_clock::now();
+
+// method: now
+//
+// arguments: none
+//
+// return: the time in nanoseconds since the program started
+//
+long long MplpcTrace::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+    (std::chrono::steady_clock::now() - trace_epoch).count();
+}
+
+// method: record
+//
+// arguments:
+//  const char* name: span name, which must outlive the trace (input)
+//  long long beg: start time from now() (input)
+//  long long end: end time from now() (input)
+//
+// return: none
+//
+// This method appends a span to the calling thread's buffer.
+//
+void MplpcTrace::record(const char* name_a, long long beg_a,
+			long long end_a) {
+
+  // register a buffer for this thread the first time through
+  //
+  if (trace_local == (MplpcSpanBuffer*)NULL) {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    trace_local = new MplpcSpanBuffer;
+    trace_local->tid_d = trace_buffers.size();
+    trace_local->spans_d.reserve(4096);
+    trace_buffers.push_back(trace_local);
+  }
+
+  // record the span
+  //
+  MplpcSpan span;
+  span.name_d = name_a;
+  span.beg_d = beg_a;
+  span.end_d = end_a;
+  trace_local->spans_d.push_back(span);
+}
+
+// method: clear
+//
+// arguments: none
+//
+// return: none
+//
+// This method discards all recorded spans. No thread may be recording
+// while it runs.
+//
+void MplpcTrace::clear() {
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  for (long i = 0; i < (long)trace_buffers.size(); i++) {
+    trace_buffers[i]->spans_d.clear();
+  }
+}
+
+// method: write
+//
+// arguments:
+//  const char* fname: output filename (input)
+//
+// return: a boolean indicating status
+//
+// This method writes all recorded spans as a Chrome trace-event JSON
+// file: one complete ("X") event per span, with times in microseconds
+// and one track per thread. No thread may be recording while it runs.
+//
+bool MplpcTrace::write(const char* fname_a) {
+
+  // open the file
+  //
+  FILE* fp = fopen(fname_a, "w");
+  if (fp == (FILE*)NULL) {
+    fprintf(stdout, "**> error in MplpcTrace::write(): error opening [%s]\n",
+	    fname_a);
+    return false;
+  }
+
+  // write the events
+  //
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  const char* sep = "\n";
+  fprintf(fp, "{\"traceEvents\": [");
+  for (long i = 0; i < (long)trace_buffers.size(); i++) {
+    MplpcSpanBuffer* buf = trace_buffers[i];
+    for (long j = 0; j < (long)buf->spans_d.size(); j++) {
+      MplpcSpan& span = buf->spans_d[j];
+      fprintf(fp, "%s {\"name\": \"%s\", \"cat\": \"mplpc\", \"ph\": \"X\", "
+	      "\"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %ld}",
+	      sep, span.name_d, span.beg_d / 1000.0,
+	      (span.end_d - span.beg_d) / 1000.0, buf->tid_d);
+      sep = ",\n";
+    }
+  }
+  fprintf(fp, "\n],\n \"displayTimeUnit\": \"ms\"}\n");
+
+  // close the file
+  //
+  if (fclose(fp) != 0) {
+    fprintf(stdout, "**> error in MplpcTrace::write(): error writing [%s]\n",
+	    fname_a);
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// stage profiles
+//
+//-----------------------------------------------------------------------------
+
+// define the stage names: these are used in the report and as keys in
+// the json output
+//
+const char* MplpcProfile::STAGE_NAMES[MplpcProfile::NUM_STAGES] = {
+  "read", "select", "montage", "preemphasis", "window", "autocor", "lpc",
+  "impres", "search", "write"};
+
+// method: get_channel_secs
+//
+// arguments: none
+//
+// return: the time spent analyzing channels
+//
+// This method sums the stages that run per channel (preemphasis through
+// the pulse search), i.e. everything but I/O.
+//
+double MplpcProfile::get_channel_secs() const {
+
+  double sum = 0.0;
+  for (long i = PREEMPH; i <= SEARCH; i++) {
+    sum += secs_d[i];
+  }
+  return sum;
+}
+
+// method: print
+//
+// arguments:
+//  FILE* fp: output stream (input)
+//  const char* title: a title for the table (input)
+//
+// return: a boolean indicating status
+//
+// This method prints the profile as a table: the time spent in each
+// stage, its share of the total, and the rate at which it processes
+// samples (over all channels).
+//
+bool MplpcProfile::print(FILE* fp_a, const char* title_a) const {
+
+  // compute the total stage time
+  //
+  double total = 0.0;
+  for (long i = 0; i < NUM_STAGES; i++) {
+    total += secs_d[i];
+  }
+
+  // print a summary
+  //
+  fprintf(fp_a, "profile: %s\n", title_a);
+  fprintf(fp_a, "  wall time = %.3f secs, channels = %ld, samples = %ld, "
+	  "frames = %ld\n", wall_d, nchans_d, nsamps_d, nframes_d);
+  fprintf(fp_a, "  %-12s %12s %8s %16s\n", "stage", "secs", "share",
+	  "Msamples/sec");
+
+  // print the stages
+  //
+  for (long i = 0; i < NUM_STAGES; i++) {
+    fprintf(fp_a, "  %-12s %12.4f %7.1f%%", STAGE_NAMES[i], secs_d[i],
+	    (total > 0) ? 100.0 * secs_d[i] / total : 0.0);
+    if (secs_d[i] > 0) {
+      fprintf(fp_a, " %16.3f\n", nsamps_d / secs_d[i] * 1.0e-6);
+    }
+    else {
+      fprintf(fp_a, " %16s\n", "-");
+    }
+  }
+  fprintf(fp_a, "  %-12s %12.4f\n", "total", total);
+
+  // print the channel throughput
+  //
+  double chan_secs = get_channel_secs();
+  fprintf(fp_a, "  frames/sec per channel = %.1f\n",
+	  (chan_secs > 0) ? nframes_d / chan_secs : 0.0);
+  if (wall_d > 0) {
+    fprintf(fp_a, "  overall = %.3f Msamples/sec\n",
+	    nsamps_d / wall_d * 1.0e-6);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: write_json
+//
+// arguments:
+//  FILE* fp: output stream (input)
+//  const char* name: name of the profile, e.g. the filename (input)
+//  const char* indent: prefix for each line (input)
+//
+// return: a boolean indicating status
+//
+// This method writes the profile as a json object. No newline follows
+// the closing brace, so the caller can add a separator.
+//
+bool MplpcProfile::write_json(FILE* fp_a, const char* name_a,
+			      const char* indent_a) const {
+
+  // write the name, escaping the characters json requires
+  //
+  fprintf(fp_a, "%s{\"name\": \"", indent_a);
+  for (const char* p = name_a; *p != (char)NULL; p++) {
+    if ((*p == '"') || (*p == '\\')) {
+      fputc('\\', fp_a);
+    }
+    fputc(*p, fp_a);
+  }
+  fprintf(fp_a, "\",\n");
+
+  // write the totals
+  //
+  double chan_secs = get_channel_secs();
+  fprintf(fp_a, "%s \"wall_secs\": %.6f, \"channels\": %ld, "
+	  "\"samples\": %ld, \"frames\": %ld,\n",
+	  indent_a, wall_d, nchans_d, nsamps_d, nframes_d);
+  fprintf(fp_a, "%s \"samples_per_sec\": %.1f, "
+	  "\"frames_per_sec_per_channel\": %.1f,\n", indent_a,
+	  (wall_d > 0) ? nsamps_d / wall_d : 0.0,
+	  (chan_secs > 0) ? nframes_d / chan_secs : 0.0);
+
+  // write the stages
+  //
+  fprintf(fp_a, "%s \"stages\": {", indent_a);
+  for (long i = 0; i < NUM_STAGES; i++) {
+    fprintf(fp_a, "%s\n%s  \"%s\": {\"secs\": %.6f, "
+	    "\"samples_per_sec\": %.1f}", (i > 0) ? "," : "", indent_a,
+	    STAGE_NAMES[i], secs_d[i],
+	    (secs_d[i] > 0) ? nsamps_d / secs_d[i] : 0.0);
+  }
+  fprintf(fp_a, "}}");
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
@@ -0,0 +1,365 @@
+// This file contains the methods that verify a fast engine against the
+// reference implementation of the analysis (see MplpcVerify in Mplpc.h).
+//
+
+// system include files
+//
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+// local include files
+//
+#include "Mplpc.h"
+
+//-----------------------------------------------------------------------------
+//
+// helper functions
+//
+//-----------------------------------------------------------------------------
+
+// function: float_ulps
+//
+// arguments:
+//  float a: first value (input)
+//  float b: second value (input)
+//
+// return: the number of floats between a and b
+//
+// The bit patterns of floats are in sign-magnitude order, so they are
+// mapped onto a two's complement scale first, on which adjacent floats
+// differ by one. 0.0 and -0.0 are the same point on this scale.
+//
+static long float_ulps(float a_a, float b_a) {
+
+  int32_t ia;
+  int32_t ib;
+  memcpy(&ia, &a_a, sizeof(ia));
+  memcpy(&ib, &b_a, sizeof(ib));
+  long long ka = (ia < 0) ? (long long)INT32_MIN - ia : (long long)ia;
+  long long kb = (ib < 0) ? (long long)INT32_MIN - ib : (long long)ib;
+  return (long)((ka > kb) ? ka - kb : kb - ka);
+}
+
+// function: relative_error
+//
+// arguments:
+//  double ref: reference value (input)
+//  double val: value to check (input)
+//
+// return: the difference of the values relative to the larger one
+//
+static double relative_error(double ref_a, double val_a) {
+
+  if (ref_a == val_a) {
+    return 0.0;
+  }
+  double scale = std::max(fabs(ref_a), fabs(val_a));
+  return fabs(ref_a - val_a) / scale;
+}
+
+//-----------------------------------------------------------------------------
+//
+// MplpcVerify methods
+//
+//-----------------------------------------------------------------------------
+
+// method: compare
+//
+// arguments:
+//  const VMplpcPulses& ref: pulses from the reference engine (input)
+//  const VMplpcPulses& fast: pulses from the fast engine (input)
+//
+// return: a boolean indicating status
+//
+// This method compares every channel. A channel that only one engine
+// produced is compared with an empty one, so all its frames count as
+// mismatches.
+//
+bool MplpcVerify::compare(const VMplpcPulses& ref_a,
+			  const VMplpcPulses& fast_a) {
+
+  MplpcPulses empty;
+  long num_chans = std::max(ref_a.size(), fast_a.size());
+  for (long i = 0; i < num_chans; i++) {
+    compare((i < (long)ref_a.size()) ? ref_a[i] : empty,
+	    (i < (long)fast_a.size()) ? fast_a[i] : empty, i);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: compare
+//
+// arguments:
+//  const MplpcPulses& ref: pulses of one channel, reference engine (input)
+//  const MplpcPulses& fast: pulses of one channel, fast engine (input)
+//  long chan: channel index, for reporting (input)
+//
+// return: a boolean indicating status
+//
+// This method walks the frames of both engines in step. The pulses of a
+// frame are contiguous and frames come in increasing order, so a frame
+// is the run of pulses that share a frame index.
+//
+bool MplpcVerify::compare(const MplpcPulses& ref_a, const MplpcPulses& fast_a,
+			  long chan_a) {
+
+  // declare local variables
+  //
+  long na = ref_a.size();
+  long nb = fast_a.size();
+  long ia = 0;
+  long ib = 0;
+  nchans_d++;
+
+  // loop over the frames
+  //
+  while ((ia < na) || (ib < nb)) {
+
+    // find the next frame and its pulses in both engines
+    //
+    long frame = (ia < na) ? ref_a.frame_d[ia] : fast_a.frame_d[ib];
+    if ((ib < nb) && (fast_a.frame_d[ib] < frame)) {
+      frame = fast_a.frame_d[ib];
+    }
+    long ea = ia;
+    while ((ea < na) && (ref_a.frame_d[ea] == frame)) {
+      ea++;
+    }
+    long eb = ib;
+    while ((eb < nb) && (fast_a.frame_d[eb] == frame)) {
+      eb++;
+    }
+
+    // compare the pulses: the gain errors of pulses at the same
+    // location are collected even when the frame doesn't match
+    //
+    bool match = ((ea - ia) == (eb - ib));
+    long n = std::min(ea - ia, eb - ib);
+    for (long k = 0; k < n; k++) {
+      if (ref_a.loc_d[ia + k] != fast_a.loc_d[ib + k]) {
+	match = false;
+	continue;
+      }
+      double ga = ref_a.gain_d[ia + k];
+      double gb = fast_a.gain_d[ib + k];
+      long ulps = float_ulps((float)ga, (float)gb);
+      double rel = relative_error(ga, gb);
+      max_ulps_d = std::max(max_ulps_d, ulps);
+      max_rel_d = std::max(max_rel_d, rel);
+      if ((ulps > ulps_d) && (rel > rtol_d)) {
+	match = false;
+      }
+    }
+    nframes_d++;
+    npulses_d += ea - ia;
+
+    // keep the first frame that doesn't match
+    //
+    if (!match) {
+      nbad_d++;
+      if (bad_chan_d < 0) {
+	bad_chan_d = chan_a;
+	bad_frame_d = frame;
+	bad_ref_d.clear(ref_a.nsamps_d);
+	for (long k = ia; k < ea; k++) {
+	  bad_ref_d.add(ref_a.loc_d[k], ref_a.gain_d[k], frame);
+	}
+	bad_fast_d.clear(fast_a.nsamps_d);
+	for (long k = ib; k < eb; k++) {
+	  bad_fast_d.add(fast_a.loc_d[k], fast_a.gain_d[k], frame);
+	}
+      }
+    }
+
+    // move on to the next frame
+    //
+    ia = ea;
+    ib = eb;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: print
+//
+// arguments:
+//  FILE* fp: output stream (input)
+//  const char* title: a title for the report, e.g. the filename (input)
+//
+// return: a boolean indicating status
+//
+// This method prints a summary of the comparison and, if a frame didn't
+// match, the pulses of the first such frame from both engines. Pulses
+// that differ are marked with an asterisk.
+//
+bool MplpcVerify::print(FILE* fp_a, const char* title_a) const {
+
+  // print a summary
+  //
+  fprintf(fp_a, "verify: %s: %s\n", title_a, passed() ? "PASSED" : "FAILED");
+  fprintf(fp_a, "  engine = %s\n", engine_d.c_str());
+  fprintf(fp_a, "  channels = %ld, frames = %ld, pulses = %ld, "
+	  "mismatched frames = %ld\n", nchans_d, nframes_d, npulses_d, nbad_d);
+  fprintf(fp_a, "  max gain error = %ld ulps, %.3e relative "
+	  "(tolerance = %ld ulps or %.3e relative)\n",
+	  max_ulps_d, max_rel_d, ulps_d, rtol_d);
+
+  // print the first mismatch
+  //
+  if (bad_chan_d >= 0) {
+    fprintf(fp_a, "  first mismatch: channel %ld, frame %ld "
+	    "(%ld reference pulses, %ld fast pulses)\n", bad_chan_d,
+	    bad_frame_d, bad_ref_d.size(), bad_fast_d.size());
+    fprintf(fp_a, "    %5s %10s %14s %10s %14s %12s %10s\n", "pulse",
+	    "ref loc", "ref gain", "fast loc", "fast gain", "ulps", "rel");
+
+    long n = std::max(bad_ref_d.size(), bad_fast_d.size());
+    for (long k = 0; k < n; k++) {
+      fprintf(fp_a, "    %5ld", k);
+      if (k < bad_ref_d.size()) {
+	fprintf(fp_a, " %10ld %14.6e", bad_ref_d.loc_d[k],
+		bad_ref_d.gain_d[k]);
+      }
+      else {
+	fprintf(fp_a, " %10s %14s", "-", "-");
+      }
+      if (k < bad_fast_d.size()) {
+	fprintf(fp_a, " %10ld %14.6e", bad_fast_d.loc_d[k],
+		bad_fast_d.gain_d[k]);
+      }
+      else {
+	fprintf(fp_a, " %10s %14s", "-", "-");
+      }
+      if ((k < bad_ref_d.size()) && (k < bad_fast_d.size()) &&
+	  (bad_ref_d.loc_d[k] == bad_fast_d.loc_d[k])) {
+	long ulps = float_ulps((float)bad_ref_d.gain_d[k],
+			       (float)bad_fast_d.gain_d[k]);
+	double rel = relative_error(bad_ref_d.gain_d[k],
+				    bad_fast_d.gain_d[k]);
+	fprintf(fp_a, " %12ld %10.3e%s\n", ulps, rel,
+		((ulps > ulps_d) && (rel > rtol_d)) ? " *" : "");
+      }
+      else {
+	fprintf(fp_a, " %12s %10s *\n", "-", "-");
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// Mplpc methods
+//
+//-----------------------------------------------------------------------------
+
+// method: verify
+//
+// arguments:
+//  MplpcVerify& result: the comparison, with its tolerances set (output)
+//  char* iname: EDF or raw sample filename (input)
+//
+// return: a boolean indicating status
+//
+// This method analyzes a file twice: first with the reference engine -
+// scalar code in mixed precision, the full pulse search, one thread, one
+// channel at a time and whole-file EDF reads - and then with the engine
+// the parameters select. It compares the two sets of pulses into result.
+// The reference reads EDF files through the Edf class, so a streamed
+// or direct analysis also checks the readers in mplpc_06 against it.
+// Nothing is written. The status only reflects whether both analyses
+// ran; use result.passed() to see if they agree.
+//
+bool Mplpc::verify(MplpcVerify& result_a, char* iname_a) {
+
+  // declare local variables
+  //
+  bool status = true;
+  VMplpcPulses ref;
+  VMplpcPulses fast;
+  static const char* simd_names[] = {
+    SIMD_MODE_NAME_00, SIMD_MODE_NAME_01, SIMD_MODE_NAME_02,
+    SIMD_MODE_NAME_03, SIMD_MODE_NAME_04, SIMD_MODE_NAME_05};
+
+  result_a.clear();
+
+  // save the configured engine
+  //
+  SIMD_MODE simd_mode = simd_mode_d;
+  PRECISION precision = precision_d;
+  SEARCH_MODE search_mode = search_mode_d;
+  long num_threads = num_threads_d;
+  long num_lanes = num_lanes_d;
+  long stream_recs = stream_recs_d;
+  long direct_read = direct_read_d;
+  bool profile = profile_d;
+
+  // run the reference engine
+  //
+  simd_mode_d = Mplpc::SIMD_NONE;
+  precision_d = Mplpc::PREC_MIXED;
+  search_mode_d = Mplpc::SRCH_FULL;
+  num_threads_d = 1;
+  num_lanes_d = 0;
+  stream_recs_d = 0;
+  direct_read_d = 0;
+  profile_d = false;
+  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+    fprintf(stdout, "Mplpc::verify(): reference analysis of %s\n", iname_a);
+  }
+  status = select_kernels() && compute_file(ref, iname_a);
+
+  // restore the configured engine and run it
+  //
+  simd_mode_d = simd_mode;
+  precision_d = precision;
+  search_mode_d = search_mode;
+  num_threads_d = num_threads;
+  num_lanes_d = num_lanes;
+  stream_recs_d = stream_recs;
+  direct_read_d = direct_read;
+  profile_d = profile;
+  if (!select_kernels()) {
+    return false;
+  }
+  if (!status) {
+    fprintf(stdout, "**> error in Mplpc::verify(): reference analysis "
+	    "of [%s] failed\n", iname_a);
+    return false;
+  }
+  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+    fprintf(stdout, "Mplpc::verify(): fast analysis of %s\n", iname_a);
+  }
+  if (!compute_file(fast, iname_a)) {
+    fprintf(stdout, "**> error in Mplpc::verify(): analysis of [%s] "
+	    "failed\n", iname_a);
+    return false;
+  }
+
+  // describe the engine and compare the results
+  //
+  char buf[Edf::MAX_LSTR_LENGTH];
+  sprintf(buf, "simd = %s (%s), precision = %s, search = %s, "
+	  "threads = %ld, channel_lanes = %ld, stream_records = %ld, "
+	  "direct_read = %ld",
+	  simd_mode_str_d, simd_names[simd_isa_d], precision_str_d,
+	  search_mode_str_d, num_threads_d, num_lanes_d, stream_recs_d,
+	  direct_read_d);
+  result_a.engine_d = buf;
+
+  // exit gracefully
+  //
+  return result_a.compare(ref, fast);
+}
+
+//
+// end of file
@@ -0,0 +1,747 @@
+// This file contains the channel-interleaved engine, which analyzes a
+// group of channels in lockstep, one channel per simd lane.
+//
+
+// system include files
+//
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// local include files
+//
+#include "Mplpc.h"
+
+//-----------------------------------------------------------------------------
+//
+// channel-interleaved analysis: every channel of a montage shares the
+// frame duration, the window duration, the impulse response duration
+// and the lp order, so each frame runs the same control flow in every
+// channel. the engine stores a group of L channels sample by sample
+// (L = 4, 8 or 16), so that row n holds sample n of every channel, and
+// runs preemphasis, windowing, autocorrelation, levinson, the impulse
+// response and the crosscorrelations of the pulse search on whole rows
+// using gcc vector types. only the pulses themselves, whose locations
+// depend on the data, are handled one lane at a time.
+//
+// the rows are not stored for the whole channel: a window of rows
+// slides along the group as the frames are analyzed, so each worker
+// needs the same memory for a minute of data as for a day.
+//
+// each lane does exactly the arithmetic of the scalar path (simd mode
+// none) in the same order, so the pulses of every channel are the same
+// as the reference. the vector types are lowered to the instruction set
+// of the function they are used in: the engine is compiled once per
+// instruction set, with contraction into fused multiply-adds turned off
+// to keep the roundings of the reference.
+//
+//-----------------------------------------------------------------------------
+
+// define the number of rows preemphasized at a time, and the number of
+// independent sums (lags) the kernels keep in flight to hide the
+// latency of the additions
+//
+static const long LANE_BLOCK = 256;
+static const long LANE_UNROLL = 4;
+
+// define the number of rows the sliding window advances by at a time
+// (besides the history and lookahead a frame needs): at 16 lanes in
+// double precision this is 2 MB per worker
+//
+static const long LANE_WINDOW = 16384;
+
+// MplpcLaneArgs: the parameters and data of the analysis of one group of
+// channels.
+//
+template <class P>
+class MplpcLaneArgs {
+public:
+  typedef typename P::sample_t sample_t;
+
+  long nsamps_d;                        // samples per channel
+  long n_fdur_d;                        // frame duration in samples
+  long n_wdur_d;                        // window duration in samples
+  long n_impres_d;                      // impulse response duration
+  long lp_order_d;                      // lp order
+  long num_pulses_d;                    // pulses per frame
+  bool incr_d;                          // incremental pulse search
+  bool dbg_d;                           // print each pulse
+  float preemphasis_d;                  // preemphasis coefficient
+  const sample_t* win_d;                // window function (n_wdur)
+  sample_t* mem_d;                      // interleaved storage
+  const double* isig_d[Mplpc::MAX_LANES]; // input of each lane
+  double bias_d[Mplpc::MAX_LANES];      // value debiasing removes from it
+  MplpcPulses* osig_d[Mplpc::MAX_LANES]; // output of each lane, or NULL
+  MplpcProfile* prof_d;                 // profile, or NULL
+
+  // method: get_rows
+  //
+  // returns the number of rows in the sliding window of the signal: the
+  // windowing of a frame reaches back at most 2 * n_wdur samples, and
+  // the pulse search reads n_fdur + n_impres samples from its start
+  //
+  long get_rows() const {
+    long rows = LANE_WINDOW + 2 * n_wdur_d + n_fdur_d + n_impres_d;
+    return (rows < nsamps_d) ? rows : nsamps_d;
+  }
+
+  // method: get_size
+  //
+  // returns the number of rows of interleaved storage the analysis uses
+  //
+  long get_size() const {
+    return get_rows() + n_wdur_d + 4 * (lp_order_d + 1) +
+      3 * n_impres_d + 2 * n_fdur_d;
+  }
+};
+
+// function: lanes_fill
+//
+// arguments:
+//  MplpcLaneArgs<P>& args: the group of channels (input/output)
+//  typename P::accum_t* pre: the last debiased sample of each lane
+//                            (input/output)
+//  long base: the sample held in the first row of the window (input)
+//  long n_beg: first sample to fill in (input)
+//  long n_end: one past the last sample to fill in (input)
+//
+// return: none
+//
+// This function debiases and preemphasizes samples n_beg to n_end of
+// each channel into its lane of the window: a block of rows at a time,
+// so the rows stay in cache while every lane is filled in.
+//
+template <class P, long L>
+static inline __attribute__((always_inline))
+void lanes_fill(MplpcLaneArgs<P>& args_a, typename P::accum_t* pre_a,
+		long base_a, long n_beg_a, long n_end_a) {
+
+  typedef typename P::accum_t accum_t;
+  typename P::sample_t* lane = args_a.mem_d;
+  for (long n_beg = n_beg_a; n_beg < n_end_a; n_beg += LANE_BLOCK) {
+    long n_end = (n_end_a - n_beg > LANE_BLOCK) ? n_beg + LANE_BLOCK : n_end_a;
+    for (long l = 0; l < L; l++) {
+      const double* isig = args_a.isig_d[l];
+      accum_t cur = 0.0;
+      for (long n = n_beg; n < n_end; n++) {
+	cur = isig[n] - args_a.bias_d[l];
+	lane[(n - base_a) * L + l] = cur + args_a.preemphasis_d * pre_a[l];
+	pre_a[l] = cur;
+      }
+    }
+  }
+}
+
+// function: lanes_analyze
+//
+// arguments:
+//  MplpcLaneArgs<P>& args: the group of channels (input/output)
+//
+// return: a boolean indicating status
+//
+// This function is the analysis of a group of L channels. It is only
+// ever inlined into one of the per instruction set versions below.
+//
+template <class P, long L>
+static inline __attribute__((always_inline))
+bool lanes_analyze(MplpcLaneArgs<P>& args_a) {
+
+  // define the vector types: a row of samples, a row of accumulators
+  // and a row of doubles, plus unaligned versions of a row for
+  // addressing the storage
+  //
+  typedef typename P::sample_t sample_t;
+  typedef typename P::accum_t accum_t;
+  typedef sample_t vsamp __attribute__((vector_size(L * sizeof(sample_t))));
+  typedef accum_t vacc __attribute__((vector_size(L * sizeof(accum_t))));
+  typedef double vdbl __attribute__((vector_size(L * sizeof(double))));
+  typedef sample_t vrow __attribute__((vector_size(L * sizeof(sample_t)),
+				       aligned(sizeof(sample_t)), may_alias));
+  typedef decltype(vsamp() > vsamp()) vmsamp;
+  typedef decltype(vacc() > vacc()) vmacc;
+
+  // declare local variables
+  //
+  long nsamps = args_a.nsamps_d;
+  long n_fdur = args_a.n_fdur_d;
+  long n_wdur = args_a.n_wdur_d;
+  long n_impres = args_a.n_impres_d;
+  long lp_order = args_a.lp_order_d;
+  long num_frames = nsamps / n_fdur;
+  const sample_t* win = args_a.win_d;
+  MplpcProfile* prof = args_a.prof_d;
+  long long prof_t = prof ? MplpcTrace::now() : 0;
+
+  // carve up the storage: the window of the signal comes first
+  //
+  long num_rows = args_a.get_rows();
+  vrow* sig = (vrow*)args_a.mem_d;
+  vrow* wbuf = sig + num_rows;
+  vrow* autocor = wbuf + n_wdur;
+  vrow* rc = autocor + lp_order + 1;
+  vrow* pc = rc + lp_order + 1;
+  vrow* filt = pc + lp_order + 1;
+  vrow* impres = filt + lp_order + 1;
+  vrow* hacor = impres + n_impres;
+  vrow* ccor = hacor + n_impres;
+  vrow* tmp = ccor + n_fdur;
+
+  // the window holds samples base to filled of each channel
+  //
+  long base = 0;
+  long filled = 0;
+  accum_t pre[L];
+  for (long l = 0; l < L; l++) {
+    pre[l] = 0.0;
+  }
+
+  // loop over the frames
+  //
+  vsamp zero = {};
+  vacc azero = {};
+  accum_t N_1 = 1.0 / (accum_t)n_wdur;
+  for (long i = 0; i < num_frames; i++) {
+
+    long off = i * n_fdur;
+    MPLPC_TRACE_START(trace_t);
+
+    // slide the window when the frame's lookahead runs past its end,
+    // keeping the history the windowing reads, and fill it in as far
+    // as it reaches
+    //
+    long need = (off + n_fdur + n_impres < nsamps) ?
+      off + n_fdur + n_impres : nsamps;
+    if (need > base + num_rows) {
+      long keep = (off > 2 * n_wdur) ? off - 2 * n_wdur : 0;
+      memmove(sig, sig + (keep - base), (filled - keep) * sizeof(vrow));
+      base = keep;
+    }
+    if (filled < need) {
+      long end = (base + num_rows < nsamps) ? base + num_rows : nsamps;
+      lanes_fill<P, L>(args_a, pre, base, filled, end);
+      filled = end;
+      if (prof) {
+	prof->lap(MplpcProfile::PREEMPH, prof_t);
+      }
+    }
+    vrow* fsig = sig + (off - base);
+
+    // window the data: see window_frame for the layout of the history
+    //
+    long n_offset = n_wdur - n_fdur;
+    long step = n_fdur - 1;
+    for (long j = 0; j < n_fdur; j++) {
+      wbuf[n_offset + j] = fsig[j] * win[n_offset + j];
+    }
+    long j_end = n_offset;
+    for (long t = 1; (step > 0) && (j_end > 0) && (t <= i); t++) {
+      long j_beg = j_end - step;
+      if (j_beg < 0) {
+	j_beg = 0;
+      }
+      for (long j = j_beg; j < j_end; j++) {
+	wbuf[j] = fsig[j - n_offset - t] * win[j];
+      }
+      j_end = j_beg;
+    }
+    for (long j = 0; j < j_end; j++) {
+      wbuf[j] = zero;
+    }
+    MPLPC_TRACE_LAP(trace_t, "window");
+    if (prof) {
+      prof->lap(MplpcProfile::WINDOW, prof_t);
+    }
+
+    // compute the autocorrelation: LANE_UNROLL lags at a time, which
+    // share the samples where their sums overlap
+    //
+    long k = 0;
+    for (; k + LANE_UNROLL - 1 <= lp_order; k += LANE_UNROLL) {
+      vacc sum[LANE_UNROLL];
+      for (long u = 0; u < LANE_UNROLL; u++) {
+	sum[u] = azero;
+      }
+      long j_end = n_wdur - k - LANE_UNROLL + 1;
+      long j = 0;
+      for (; j < j_end; j++) {
+	for (long u = 0; u < LANE_UNROLL; u++) {
+	  sum[u] = __builtin_convertvector
+	    (__builtin_convertvector(sum[u], vsamp) +
+	     wbuf[j] * wbuf[j + k + u], vacc);
+	}
+      }
+      for (long u = 0; u < LANE_UNROLL; u++) {
+	for (long jj = j; jj < n_wdur - k - u; jj++) {
+	  sum[u] = __builtin_convertvector
+	    (__builtin_convertvector(sum[u], vsamp) +
+	     wbuf[jj] * wbuf[jj + k + u], vacc);
+	}
+	autocor[k + u] = __builtin_convertvector(sum[u] * N_1, vsamp);
+      }
+    }
+    for (; k <= lp_order; k++) {
+      vacc sum = azero;
+      for (long j = 0; j < n_wdur - k; j++) {
+	sum = __builtin_convertvector(__builtin_convertvector(sum, vsamp) +
+				      wbuf[j] * wbuf[j + k], vacc);
+      }
+      autocor[k] = __builtin_convertvector(sum * N_1, vsamp);
+    }
+    MPLPC_TRACE_LAP(trace_t, "autocor");
+    if (prof) {
+      prof->lap(MplpcProfile::AUTOCOR, prof_t);
+    }
+
+    // compute the lpc model with the levinson recursion
+    //
+    vacc err_egy = __builtin_convertvector((vsamp)autocor[0], vacc);
+    pc[0] = zero + (sample_t)1.0;
+    for (long k = 1; k <= lp_order; k++) {
+      vacc acc = azero;
+      for (long j = 1; j <= k; j++) {
+	acc = __builtin_convertvector(__builtin_convertvector(acc, vsamp) -
+				      pc[k - j] * autocor[j], vacc);
+      }
+      pc[k] = __builtin_convertvector(acc / err_egy, vsamp);
+      rc[k - 1] = pc[k];
+
+      for (long m = 1; m <= k / 2; m++) {
+	vacc pci = __builtin_convertvector(pc[m] + pc[k] * pc[k - m], vacc);
+	vacc pcki = __builtin_convertvector(pc[k - m] + pc[k] * pc[m], vacc);
+	pc[m] = __builtin_convertvector(pci, vsamp);
+	pc[k - m] = __builtin_convertvector(pcki, vsamp);
+      }
+
+      vsamp pc2 = pc[k] * pc[k];
+      err_egy = __builtin_convertvector
+	(__builtin_convertvector(err_egy, vdbl) *
+	 (1.0 - __builtin_convertvector(pc2, vdbl)), vacc);
+    }
+    MPLPC_TRACE_LAP(trace_t, "lpc");
+    if (prof) {
+      prof->lap(MplpcProfile::LPC, prof_t);
+    }
+
+    // compute the impulse response and its energy
+    //
+    for (long j = 0; j <= lp_order; j++) {
+      filt[j] = zero;
+    }
+    impres[0] = pc[0];
+    filt[0] = impres[0];
+    for (long n = 1; n < n_impres; n++) {
+      for (long j = lp_order; j > 0; j--) {
+	filt[j] = filt[j - 1];
+      }
+      vacc sum = azero;
+      for (long j = 1; j <= lp_order; j++) {
+	sum = __builtin_convertvector(__builtin_convertvector(sum, vsamp) +
+				      pc[j] * filt[j], vacc);
+      }
+      impres[n] = __builtin_convertvector(sum, vsamp);
+      filt[0] = impres[n];
+    }
+    vacc impres_egy = azero;
+    for (long j = 0; j < n_impres; j++) {
+      impres_egy = __builtin_convertvector
+	(__builtin_convertvector(impres_egy, vsamp) + impres[j] * impres[j],
+	 vacc);
+    }
+    MPLPC_TRACE_LAP(trace_t, "impres");
+    if (prof) {
+      prof->lap(MplpcProfile::IMPRES, prof_t);
+    }
+
+    // copy the frame and the lookahead into the search buffer
+    //
+    long sig_tmp_size = n_fdur + n_impres;
+    long sig_tmp_len = sig_tmp_size;
+    if (sig_tmp_len > nsamps - off) {
+      sig_tmp_len = n_fdur;
+    }
+    for (long j = 0; j < sig_tmp_len; j++) {
+      tmp[j] = fsig[j];
+    }
+    for (long j = sig_tmp_len; j < sig_tmp_size; j++) {
+      tmp[j] = zero;
+    }
+    MPLPC_TRACE_LAP(trace_t, "copy");
+
+    // the incremental search starts from the crosscorrelation of the
+    // signal with the impulse response, and the autocorrelation of the
+    // impulse response
+    //
+    if (args_a.incr_d) {
+      long k = 0;
+      for (; k + LANE_UNROLL <= n_fdur; k += LANE_UNROLL) {
+	vsamp sum[LANE_UNROLL];
+	for (long u = 0; u < LANE_UNROLL; u++) {
+	  sum[u] = zero;
+	}
+	for (long j = 0; j < n_impres; j++) {
+	  for (long u = 0; u < LANE_UNROLL; u++) {
+	    sum[u] += tmp[k + u + j] * impres[j];
+	  }
+	}
+	for (long u = 0; u < LANE_UNROLL; u++) {
+	  ccor[k + u] = sum[u];
+	}
+      }
+      for (; k < n_fdur; k++) {
+	vsamp sum = zero;
+	for (long j = 0; j < n_impres; j++) {
+	  sum += tmp[k + j] * impres[j];
+	}
+	ccor[k] = sum;
+      }
+      for (long k = 0; k < n_impres; k++) {
+	vsamp sum = zero;
+	for (long j = 0; j < n_impres - k; j++) {
+	  sum += impres[k + j] * impres[j];
+	}
+	hacor[k] = sum;
+      }
+    }
+
+    // find the pulses
+    //
+    for (long p = 0; p < args_a.num_pulses_d; p++) {
+
+      // find the peak of the crosscorrelation in every lane
+      //
+      long max_loc[L];
+      vacc max_val = azero;
+      if (args_a.incr_d) {
+	vsamp max_cc = zero;
+	vmsamp loc = {};
+	for (long k = 0; k < n_fdur; k++) {
+	  vsamp cc = ccor[k];
+	  vmsamp gt = ((cc < zero) ? -cc : cc) >
+	    ((max_cc < zero) ? -max_cc : max_cc);
+	  max_cc = gt ? cc : max_cc;
+	  loc = gt ? (vmsamp){} + (int)k : loc;
+	}
+	max_val = __builtin_convertvector(max_cc, vacc);
+	for (long l = 0; l < L; l++) {
+	  max_loc[l] = loc[l];
+	}
+      }
+      else {
+
+	// the crosscorrelations are computed LANE_UNROLL lags at a time
+	// and then scanned in order
+	//
+	vmacc loc = {};
+	vacc sum[LANE_UNROLL];
+	for (long k = 0; k < n_fdur; k += LANE_UNROLL) {
+	  long num = (n_fdur - k < LANE_UNROLL) ? n_fdur - k : LANE_UNROLL;
+	  if (num == LANE_UNROLL) {
+	    for (long u = 0; u < LANE_UNROLL; u++) {
+	      sum[u] = azero;
+	    }
+	    for (long j = 0; j < n_impres; j++) {
+	      vsamp h = impres[j];
+	      for (long u = 0; u < LANE_UNROLL; u++) {
+		sum[u] = __builtin_convertvector
+		  (__builtin_convertvector(sum[u], vsamp) +
+		   tmp[k + u + j] * h, vacc);
+	      }
+	    }
+	  }
+	  else {
+	    for (long u = 0; u < num; u++) {
+	      sum[u] = azero;
+	      for (long j = 0; j < n_impres; j++) {
+		sum[u] = __builtin_convertvector
+		  (__builtin_convertvector(sum[u], vsamp) +
+		   tmp[k + u + j] * impres[j], vacc);
+	      }
+	    }
+	  }
+	  for (long u = 0; u < num; u++) {
+	    vmacc gt = ((sum[u] < azero) ? -sum[u] : sum[u]) >
+	      ((max_val < azero) ? -max_val : max_val);
+	    max_val = gt ? sum[u] : max_val;
+	    loc = gt ? (vmacc){} + (int)(k + u) : loc;
+	  }
+	}
+	for (long l = 0; l < L; l++) {
+	  max_loc[l] = loc[l];
+	}
+      }
+      vacc gain = max_val / impres_egy;
+
+      // subtract the effect of each lane's pulse and output it
+      //
+      for (long l = 0; l < L; l++) {
+	long m = max_loc[l];
+	sample_t g = gain[l];
+	if (args_a.incr_d) {
+	  long k_beg = m - n_impres + 1;
+	  long k_end = m + n_impres;
+	  if (k_beg < 0) {
+	    k_beg = 0;
+	  }
+	  if (k_end > n_fdur) {
+	    k_end = n_fdur;
+	  }
+	  for (long k = k_beg; k < k_end; k++) {
+	    ccor[k][l] -= g * hacor[labs(k - m)][l];
+	  }
+	}
+	else {
+	  for (long k = 0; k < n_impres; k++) {
+	    tmp[m + k][l] -= g * impres[k][l];
+	  }
+	}
+
+	if (args_a.osig_d[l] != (MplpcPulses*)NULL) {
+	  if (args_a.dbg_d) {
+	    fprintf(stdout, "frame no: %ld, pulse no. %ld, loc/amp = (%ld, %f)\n",
+		    i, p, off + m, (double)max_val[l]);
+	  }
+	  args_a.osig_d[l]->add(off + m, gain[l], i);
+	}
+      }
+    }
+    MPLPC_TRACE_LAP(trace_t, "search");
+    if (prof) {
+      prof->lap(MplpcProfile::SEARCH, prof_t);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// function: lanes_generic, lanes_avx2, lanes_avx512
+//
+// arguments:
+//  MplpcLaneArgs<P>& args: the group of channels (input/output)
+//
+// return: a boolean indicating status
+//
+// These are the analysis of a group of L channels compiled for the
+// baseline instruction set and, on x86, for AVX2 and AVX-512. None of
+// them may contract a multiply and an add into an fma, which the
+// per-channel engine doesn't do, or the results would differ.
+//
+template <class P, long L>
+__attribute__((optimize("fp-contract=off")))
+static bool lanes_generic(MplpcLaneArgs<P>& args_a) {
+  return lanes_analyze<P, L>(args_a);
+}
+
+#ifdef MPLPC_X86
+
+template <class P, long L>
+__attribute__((target("avx2"), optimize("fp-contract=off")))
+static bool lanes_avx2(MplpcLaneArgs<P>& args_a) {
+  return lanes_analyze<P, L>(args_a);
+}
+
+template <class P, long L>
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static bool lanes_avx512(MplpcLaneArgs<P>& args_a) {
+  return lanes_analyze<P, L>(args_a);
+}
+
+#endif
+
+// function: find_lanes
+//
+// arguments:
+//  long num_lanes: channels per group (input)
+//  long isa: instruction set: 0 = baseline, 1 = AVX2, 2 = AVX-512 (input)
+//
+// return: the analysis for the group size and instruction set
+//
+template <class P>
+static bool (*find_lanes(long num_lanes_a, long isa_a))(MplpcLaneArgs<P>&) {
+
+  typedef bool (*ENGINE)(MplpcLaneArgs<P>&);
+  static const ENGINE engines[3][3] = {
+    {lanes_generic<P, 4>, lanes_generic<P, 8>, lanes_generic<P, 16>},
+#ifdef MPLPC_X86
+    {lanes_avx2<P, 4>, lanes_avx2<P, 8>, lanes_avx2<P, 16>},
+    {lanes_avx512<P, 4>, lanes_avx512<P, 8>, lanes_avx512<P, 16>},
+#else
+    {lanes_generic<P, 4>, lanes_generic<P, 8>, lanes_generic<P, 16>},
+    {lanes_generic<P, 4>, lanes_generic<P, 8>, lanes_generic<P, 16>},
+#endif
+  };
+  long size = (num_lanes_a <= 4) ? 0 : ((num_lanes_a <= 8) ? 1 : 2);
+  return engines[isa_a][size];
+}
+
+//-----------------------------------------------------------------------------
+//
+// Mplpc methods
+//
+//-----------------------------------------------------------------------------
+
+// method: compute_lanes
+//
+// arguments:
+//  VMplpcPulses& osig: pulses for each channel (output)
+//  const VVectorDouble& isig: signal data (input)
+//
+// return: a boolean indicating status
+//
+// This method processes a multichannel signal num_lanes_d channels at a
+// time. Consecutive channels of the same length form a group; the last
+// group of a run may be partly filled. Groups are independent, so they
+// are handed out to the worker threads like channels are. Like the
+// single channel analysis, this leaves the input as it is.
+//
+bool Mplpc::compute_lanes(VMplpcPulses& osig_a,
+			  const VVectorDouble& isig_a) {
+
+  // declare local variables
+  //
+  long num_chans = isig_a.size();
+
+  // make sure the right analysis parameters are set
+  //
+  if (!Mplpc::check_analysis()) {
+    return false;
+  }
+
+  // form the groups
+  //
+  std::vector<long> group;
+  for (long i = 0; i < num_chans; ) {
+    long j = i + 1;
+    while ((j < num_chans) && (j - i < num_lanes_d) &&
+	   (isig_a[j].size() == isig_a[i].size())) {
+      j++;
+    }
+    group.push_back(i);
+    i = j;
+  }
+  group.push_back(num_chans);
+
+  if (debug_level_d >= Dbgl::LEVEL_DETAILED) {
+    fprintf(stdout, "   Mplpc::compute_lanes(): %ld channels in %ld groups of up to %ld\n",
+	    num_chans, (long)group.size() - 1, num_lanes_d);
+  }
+
+  // analyze each group: each task writes to its own slots
+  //
+  osig_a.resize(num_chans);
+  return Mplpc::run_workers(group.size() - 1, [&](long g, long w) {
+    MplpcWork* work = Mplpc::get_work(w);
+    if (work == (MplpcWork*)NULL) {
+      return false;
+    }
+    long chan = group[g];
+    long num = group[g + 1] - group[g];
+    bool status;
+    if (precision_d == Mplpc::PREC_FLOAT) {
+      status = Mplpc::compute_lane_group<MplpcFloat>(osig_a, isig_a, chan,
+						     num, *work);
+    }
+    else if (precision_d == Mplpc::PREC_DOUBLE) {
+      status = Mplpc::compute_lane_group<MplpcDouble>(osig_a, isig_a, chan,
+						      num, *work);
+    }
+    else {
+      status = Mplpc::compute_lane_group<MplpcMixed>(osig_a, isig_a, chan,
+						     num, *work);
+    }
+    return status && Mplpc::channels_done(chan, num);
+  });
+}
+
+// method: compute_lane_group
+//
+// arguments:
+//  VMplpcPulses& osig: pulses for each channel (output)
+//  const VVectorDouble& isig: signal data (input)
+//  long chan: first channel of the group (input)
+//  long num_chans: number of channels in the group (input)
+//  MplpcWork& work: workspace (scratch)
+//
+// return: a boolean indicating status
+//
+// This method analyzes one group of channels of the same length in the
+// precision of the policy P. Lanes beyond the end of the group repeat
+// its first channel and their pulses are discarded.
+//
+template <class P>
+bool Mplpc::compute_lane_group(VMplpcPulses& osig_a,
+			       const VVectorDouble& isig_a,
+			       long chan_a, long num_chans_a,
+			       MplpcWork& work_a) {
+
+  // declare local variables
+  //
+  typedef typename P::sample_t sample_t;
+  MplpcLaneArgs<P> args;
+  long num_lanes = (num_lanes_d <= 4) ? 4 : ((num_lanes_d <= 8) ? 8 : 16);
+  long nsamps = isig_a[chan_a].size();
+  MPLPC_TRACE_SCOPE("lanes");
+
+  // set up the lanes: the channels are debiased as they are
+  // preemphasized
+  //
+  for (long l = 0; l < num_lanes; l++) {
+    if (l < num_chans_a) {
+      args.bias_d[l] = 0.0;
+      if (debias_mode_d == Mplpc::DBS_SIGNAL) {
+	args.bias_d[l] = Mplpc::compute_mean(isig_a[chan_a + l]);
+      }
+      args.isig_d[l] = isig_a[chan_a + l].data();
+      args.osig_d[l] = &osig_a[chan_a + l];
+      args.osig_d[l]->clear(nsamps);
+    }
+    else {
+      args.isig_d[l] = args.isig_d[0];
+      args.bias_d[l] = args.bias_d[0];
+      args.osig_d[l] = (MplpcPulses*)NULL;
+    }
+  }
+
+  // gather the analysis parameters
+  //
+  args.nsamps_d = nsamps;
+  args.n_fdur_d = round(frame_duration_d * sample_freq_d);
+  args.n_wdur_d = round(window_duration_d * sample_freq_d);
+  args.n_impres_d = round(impres_dur_d * sample_freq_d);
+  args.lp_order_d = lp_order_d;
+  args.num_pulses_d = num_pulses_d;
+  args.incr_d = (search_mode_d == Mplpc::SRCH_INCR);
+  args.dbg_d = (debug_level_d > Dbgl::LEVEL_BRIEF);
+  args.preemphasis_d = preemphasis_d;
+  args.win_d = get_window<sample_t>();
+  args.mem_d = work_a.get_lanes<sample_t>(args.get_size() * num_lanes);
+  args.prof_d = profile_d ? &work_a.prof_d : (MplpcProfile*)NULL;
+
+  long num_frames = nsamps / args.n_fdur_d;
+  for (long l = 0; l < num_chans_a; l++) {
+    args.osig_d[l]->reserve(num_frames * num_pulses_d);
+  }
+  if (args.prof_d != (MplpcProfile*)NULL) {
+    args.prof_d->nsamps_d += nsamps * num_chans_a;
+    args.prof_d->nchans_d += num_chans_a;
+    args.prof_d->nframes_d += num_frames * num_chans_a;
+  }
+
+  // run the analysis compiled for the selected instruction set
+  //
+  long isa = 0;
+  if (simd_isa_d == Mplpc::SIMD_AVX512) {
+    isa = 2;
+  }
+  else if (simd_isa_d == Mplpc::SIMD_AVX2) {
+    isa = 1;
+  }
+
+  // exit gracefully
+  //
+  return find_lanes<P>(num_lanes, isa)(args);
+}
+
+//
+// end of file
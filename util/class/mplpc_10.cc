@@ -0,0 +1,443 @@
+// This file contains the methods that write feature files: a buffered
+// writer with an optional i/o thread (see MplpcWriter in Mplpc.h) and
+// the conversion of pulses to 16-bit samples.
+//
+
+// system include files
+//
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+// local include files
+//
+#include "Mplpc.h"
+
+// constants: the number of samples converted to 16 bits at a time
+//
+static const long WRITE_BLOCK = 8192;
+
+//-----------------------------------------------------------------------------
+//
+// MplpcWriter methods
+//
+//-----------------------------------------------------------------------------
+
+// method: default constructor
+//
+MplpcWriter::MplpcWriter() {
+  fd_d = -1;
+  direct_d = false;
+  buf_d = (char*)NULL;
+  len_d = 0;
+  stop_d = false;
+  io_status_d = true;
+}
+
+// method: destructor
+//
+// a file that is still open is closed; errors can only be seen by
+// calling close() first.
+//
+MplpcWriter::~MplpcWriter() {
+  close();
+  for (long i = 0; i < (long)blocks_d.size(); i++) {
+    free(blocks_d[i]);
+  }
+}
+
+// method: open
+//
+// arguments:
+//  const char* fname: output filename (input)
+//  bool direct: bypass the page cache (input)
+//  long num_queued: number of blocks the i/o thread may have waiting,
+//                   or zero to write from the calling thread (input)
+//
+// return: a boolean indicating status
+//
+// This method creates (or truncates) a file. Direct i/o is a request:
+// when the file system refuses O_DIRECT, the file is opened normally.
+//
+bool MplpcWriter::open(const char* fname_a, bool direct_a,
+		       long num_queued_a) {
+
+  // close a previous file and set up the blocks
+  //
+  if (!close()) {
+    return false;
+  }
+  if (!alloc_blocks(num_queued_a + 1)) {
+    return false;
+  }
+  buf_d = blocks_d[0];
+  free_d.assign(blocks_d.begin() + 1, blocks_d.begin() + num_queued_a + 1);
+  queue_d.clear();
+  fname_d = fname_a;
+  len_d = 0;
+  stop_d = false;
+  io_status_d = true;
+
+  // open the file
+  //
+  int flags = O_WRONLY | O_CREAT | O_TRUNC;
+  direct_d = false;
+#ifdef O_DIRECT
+  if (direct_a) {
+    fd_d = ::open(fname_a, flags | O_DIRECT, 0666);
+    direct_d = (fd_d >= 0);
+  }
+#endif
+  if (fd_d < 0) {
+    fd_d = ::open(fname_a, flags, 0666);
+  }
+  if (fd_d < 0) {
+    fprintf(stdout, "**> error in MplpcWriter::open(): "
+	    "error opening output file [%s]\n", fname_a);
+    return false;
+  }
+
+  // start the i/o thread
+  //
+  if (num_queued_a > 0) {
+    io_d = std::thread(&MplpcWriter::run_io, this);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: reserve
+//
+// arguments:
+//  long& num: number of samples wanted (input), and the number that
+//             fit (output)
+//
+// return: where to store the samples, or NULL on error
+//
+// A full block is handed off first, so at least one sample fits.
+//
+short int* MplpcWriter::reserve(long& num_a) {
+
+  if ((len_d == BLOCK_BYTES) && !submit_block()) {
+    num_a = 0;
+    return (short int*)NULL;
+  }
+  num_a = std::min(num_a, (BLOCK_BYTES - len_d) / (long)sizeof(short int));
+  return (short int*)(buf_d + len_d);
+}
+
+// method: commit
+//
+// arguments:
+//  long num: number of samples stored in the reserved space (input)
+//
+// return: a boolean indicating status
+//
+bool MplpcWriter::commit(long num_a) {
+
+  len_d += num_a * (long)sizeof(short int);
+  if (len_d == BLOCK_BYTES) {
+    return submit_block();
+  }
+  return true;
+}
+
+// method: close
+//
+// arguments: none
+//
+// return: a boolean indicating status
+//
+// This method waits for the queued blocks to be written, writes what is
+// left in the block being filled and closes the file. The last block is
+// usually not a multiple of the alignment, so direct i/o is turned off
+// for it. Errors that are only reported when a file is closed, as on
+// network file systems, are caught here.
+//
+bool MplpcWriter::close() {
+
+  if (fd_d < 0) {
+    return true;
+  }
+
+  // drain the queue and stop the i/o thread
+  //
+  if (io_d.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_d);
+      stop_d = true;
+    }
+    cond_d.notify_all();
+    io_d.join();
+  }
+  bool status = io_status_d;
+
+  // write the last block
+  //
+  if (status && (len_d > 0)) {
+#ifdef O_DIRECT
+    if (direct_d && ((len_d % ALIGN_BYTES) != 0)) {
+      fcntl(fd_d, F_SETFL, fcntl(fd_d, F_GETFL) & ~O_DIRECT);
+      direct_d = false;
+    }
+#endif
+    status = write_block(buf_d, len_d);
+  }
+
+  // close the file
+  //
+  if ((::close(fd_d) != 0) && status) {
+    fprintf(stdout, "**> error in MplpcWriter::close(): "
+	    "error closing [%s]\n", fname_d.c_str());
+    status = false;
+  }
+  fd_d = -1;
+  len_d = 0;
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: alloc_blocks
+//
+// arguments:
+//  long num: number of blocks needed (input)
+//
+// return: a boolean indicating status
+//
+// Blocks are kept when a file is closed, so a writer that is reused
+// only allocates them once.
+//
+bool MplpcWriter::alloc_blocks(long num_a) {
+
+  while ((long)blocks_d.size() < num_a) {
+    void* ptr;
+    if (posix_memalign(&ptr, ALIGN_BYTES, BLOCK_BYTES) != 0) {
+      fprintf(stdout, "**> error in MplpcWriter::alloc_blocks(): "
+	      "error allocating memory\n");
+      return false;
+    }
+    blocks_d.push_back((char*)ptr);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: submit_block
+//
+// arguments: none
+//
+// return: a boolean indicating status
+//
+// This method hands off the block being filled: it is either written at
+// once or queued for the i/o thread, in which case filling continues in
+// a free block. When there is none, it waits for one.
+//
+bool MplpcWriter::submit_block() {
+
+  // write the block from this thread
+  //
+  if (!io_d.joinable()) {
+    if (io_status_d && !write_block(buf_d, len_d)) {
+      io_status_d = false;
+    }
+    len_d = 0;
+    return io_status_d;
+  }
+
+  // queue the block and take a free one
+  //
+  std::unique_lock<std::mutex> lock(mutex_d);
+  cond_d.wait(lock, [&]() { return !free_d.empty(); });
+  queue_d.push_back(std::make_pair(buf_d, len_d));
+  buf_d = free_d.back();
+  free_d.pop_back();
+  len_d = 0;
+  cond_d.notify_all();
+
+  // exit gracefully
+  //
+  return io_status_d;
+}
+
+// method: write_block
+//
+// arguments:
+//  const char* buf: data (input)
+//  long nbytes: number of bytes (input)
+//
+// return: a boolean indicating status
+//
+// write() may take less than it is given, so this loops until the
+// whole block is out.
+//
+bool MplpcWriter::write_block(const char* buf_a, long nbytes_a) {
+
+  while (nbytes_a > 0) {
+    ssize_t n = ::write(fd_d, buf_a, nbytes_a);
+    if (n < 0) {
+      if (errno == EINTR) {
+	continue;
+      }
+      fprintf(stdout, "**> error in MplpcWriter::write_block(): "
+	      "error writing [%s]\n", fname_d.c_str());
+      return false;
+    }
+    buf_a += n;
+    nbytes_a -= n;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: run_io
+//
+// arguments: none
+//
+// return: none
+//
+// This is the body of the i/o thread: it writes the queued blocks in
+// order and returns them to the free list until close() stops it and
+// the queue is empty. After an error the remaining blocks are returned
+// without being written, so the producer never waits forever.
+//
+void MplpcWriter::run_io() {
+
+  MPLPC_TRACE_SCOPE("writer");
+  std::unique_lock<std::mutex> lock(mutex_d);
+  while (true) {
+    cond_d.wait(lock, [&]() { return stop_d || !queue_d.empty(); });
+    if (queue_d.empty()) {
+      break;
+    }
+    std::pair<char*, long> blk = queue_d.front();
+    queue_d.pop_front();
+    bool status = io_status_d;
+
+    // write without holding the lock
+    //
+    lock.unlock();
+    if (status) {
+      MPLPC_TRACE_SCOPE("write block");
+      status = write_block(blk.first, blk.second);
+    }
+    lock.lock();
+
+    io_status_d = io_status_d && status;
+    free_d.push_back(blk.first);
+    cond_d.notify_all();
+  }
+}
+
+//-----------------------------------------------------------------------------
+//
+// Mplpc methods
+//
+//-----------------------------------------------------------------------------
+
+// method: write_channel
+//
+// arguments:
+//  MplpcWriter& out: an open writer (input/output)
+//  const MplpcPulses& pulses: pulses of one channel (input)
+//
+// return: a boolean indicating status
+//
+// This method appends one channel to a file as 16-bit samples. Rather
+// than expanding the whole channel, the pulses are added into a short
+// block of samples, exactly as expand_pulses() does, which is then
+// converted with the clip kernel straight into the writer.
+//
+// The pulses of a frame are contiguous, frames come in increasing order
+// and a frame's pulses lie within its own samples, but within a frame
+// they are in the order they were found. A frame that reaches past the
+// end of a block is therefore visited again for the next block.
+//
+bool Mplpc::write_channel(MplpcWriter& out_a, const MplpcPulses& pulses_a) {
+
+  // declare local variables
+  //
+  VectorDouble blk(WRITE_BLOCK);
+  long num_pulses = pulses_a.size();
+  long p = 0;
+
+  // iterate each block of samples
+  //
+  for (long beg = 0; beg < pulses_a.nsamps_d; beg += WRITE_BLOCK) {
+    long end = std::min(beg + WRITE_BLOCK, pulses_a.nsamps_d);
+    std::fill(blk.begin(), blk.begin() + (end - beg), (double)0.0);
+
+    // add in the pulses frame by frame: p moves past a frame only when
+    // none of its pulses lie beyond this block
+    //
+    for (long q = p; q < num_pulses; ) {
+      long frame = pulses_a.frame_d[q];
+      bool later = false;
+      for (; (q < num_pulses) && (pulses_a.frame_d[q] == frame); q++) {
+	long loc = pulses_a.loc_d[q];
+	if (loc >= end) {
+	  later = true;
+	}
+	else if (loc >= beg) {
+	  blk[loc - beg] += pulses_a.gain_d[q];
+	}
+      }
+      if (later) {
+	break;
+      }
+      p = q;
+    }
+
+    // convert the block into the writer
+    //
+    for (long k = beg; k < end; ) {
+      long num = end - k;
+      short int* dst = out_a.reserve(num);
+      if (dst == (short int*)NULL) {
+	return false;
+      }
+      kern_clip(dst, blk.data() + (k - beg), num);
+      if (!out_a.commit(num)) {
+	return false;
+      }
+      k += num;
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: channels_done
+//
+// arguments:
+//  long chan: first channel whose pulses are final (input)
+//  long num_chans: number of channels (input)
+//
+// return: a boolean indicating status
+//
+// The analysis engines call this as soon as a channel is finished. It
+// may be called from several worker threads at once.
+//
+bool Mplpc::channels_done(long chan_a, long num_chans_a) {
+
+  if (!chans_done_d) {
+    return true;
+  }
+  return chans_done_d(chan_a, num_chans_a);
+}
+
+//
+// end of file
@@ -0,0 +1,824 @@
+
+// system include files
+//
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// local include files
+//
+#include <Cmdl.h>
+#include <Edf.h>
+
+// define the help and usage messages
+//
+#define USAGE_MSG "$VFC/util/cpp/gen_edf/gen_edf.usage"
+#define HELP_MSG "$VFC/util/cpp/gen_edf/gen_edf.help"
+
+//-----------------------------------------------------------------------------
+//
+// signal model: each channel is the sum of the selected components,
+// scaled in microvolts. every channel has its own random number stream,
+// seeded from the seed, the file index and the channel index, so a file
+// is reproducible and doesn't depend on the record duration.
+//
+//-----------------------------------------------------------------------------
+
+// define the components of the signal model
+//
+static const long MODEL_SINE = 1 << 0;
+static const long MODEL_AR = 1 << 1;
+static const long MODEL_SPIKE = 1 << 2;
+static const long MODEL_FLAT = 1 << 3;
+
+// define the parameters of the components
+//
+static const long NUM_SINES = 3;                // sinewaves per channel
+static const double SINE_FMIN = 1.0;            // lowest frequency (Hz)
+static const double SINE_FMAX = 30.0;           // highest frequency (Hz)
+static const double SINE_AMIN = 5.0;            // smallest amplitude (uV)
+static const double SINE_AMAX = 40.0;           // largest amplitude (uV)
+static const double AR_ALPHA_FREQ = 10.0;       // resonance (Hz)
+static const double AR_ALPHA_RADIUS = 0.98;     // pole radius
+static const double AR_ALPHA_RMS = 15.0;        // resonant noise (uV rms)
+static const double AR_DRIFT_COEF = 0.995;      // low frequency pole
+static const double AR_DRIFT_RMS = 20.0;        // drift (uV rms)
+static const double SPIKE_RATE = 0.2;           // spikes per second
+static const double SPIKE_DUR = 0.08;           // spike duration (secs)
+static const double SPIKE_AMIN = 80.0;          // smallest spike (uV)
+static const double SPIKE_AMAX = 250.0;         // largest spike (uV)
+static const double FLAT_RATE = 1.0 / 600.0;    // flatlines per second
+static const double FLAT_DMIN = 2.0;            // shortest flatline (secs)
+static const double FLAT_DMAX = 20.0;           // longest flatline (secs)
+
+// define the digital and physical ranges: 0.1 uV per bit
+//
+static const long DIG_MIN = -32768;
+static const long DIG_MAX = 32767;
+static const double PHYS_RES = 0.1;
+
+// define the channel labels: the 10-20 electrodes, then numbered ones
+//
+static const char* LABELS[] = {
+  "FP1", "FP2", "F3", "F4", "C3", "C4", "P3", "P4", "O1", "O2", "F7", "F8",
+  "T3", "T4", "T5", "T6", "A1", "A2", "FZ", "CZ", "PZ"};
+static const long NUM_LABELS = sizeof(LABELS) / sizeof(LABELS[0]);
+
+// Rng: a small, fast random number generator (splitmix64)
+//
+class Rng {
+public:
+  uint64_t state_d;
+  bool have_gauss_d;
+  double gauss_d;
+
+  Rng(uint64_t seed_a = 0) {
+    state_d = seed_a;
+    have_gauss_d = false;
+    gauss_d = 0.0;
+  }
+
+  // method: next
+  //
+  uint64_t next() {
+    uint64_t z = (state_d += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  // method: uniform
+  //
+  // returns a value in [0, 1)
+  //
+  double uniform() {
+    return (next() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  // method: uniform
+  //
+  // returns a value in [lo, hi)
+  //
+  double uniform(double lo_a, double hi_a) {
+    return lo_a + (hi_a - lo_a) * uniform();
+  }
+
+  // method: gauss
+  //
+  // returns a standard normal value (Box-Muller): each draw makes two,
+  // so every other call is free
+  //
+  double gauss() {
+    if (have_gauss_d) {
+      have_gauss_d = false;
+      return gauss_d;
+    }
+    double r = sqrt(-2.0 * log(1.0 - uniform()));
+    double theta = 2.0 * M_PI * uniform();
+    gauss_d = r * sin(theta);
+    have_gauss_d = true;
+    return r * cos(theta);
+  }
+
+  // method: exponential
+  //
+  // returns the time to the next event of a Poisson process
+  //
+  double exponential(double rate_a) {
+    return -log(1.0 - uniform()) / rate_a;
+  }
+};
+
+// Channel: the generator state of one channel
+//
+class Channel {
+public:
+  Rng rng_d;
+
+  // sinewaves
+  //
+  double freq_d[NUM_SINES];
+  double amp_d[NUM_SINES];
+  double phase_d[NUM_SINES];
+
+  // autoregressive noise: a resonance plus a low frequency drift
+  //
+  double a1_d;
+  double a2_d;
+  double alpha_gain_d;
+  double drift_gain_d;
+  double x1_d;
+  double x2_d;
+  double drift_d;
+
+  // spikes and flatlines: samples until the next one starts, and the
+  // position in the current one
+  //
+  long spike_next_d;
+  long spike_pos_d;
+  double spike_amp_d;
+  long flat_next_d;
+  long flat_left_d;
+};
+
+// function: init_channel
+//
+// arguments:
+//  Channel& chan: the channel state (output)
+//  uint64_t seed: seed of the channel's random number stream (input)
+//  double fs: sample frequency (input)
+//
+// return: none
+//
+// This function draws the parameters of a channel. The noise gains are
+// set so each autoregressive process has the requested rms value.
+//
+static void init_channel(Channel& chan, uint64_t seed, double fs) {
+
+  chan.rng_d = Rng(seed);
+  chan.rng_d.next();
+
+  // draw the sinewaves: keep them below the nyquist frequency
+  //
+  double fmax = std::min(SINE_FMAX, 0.45 * fs);
+  for (long i = 0; i < NUM_SINES; i++) {
+    chan.freq_d[i] = chan.rng_d.uniform(SINE_FMIN, fmax);
+    chan.amp_d[i] = chan.rng_d.uniform(SINE_AMIN, SINE_AMAX);
+    chan.phase_d[i] = chan.rng_d.uniform(0.0, 2.0 * M_PI);
+  }
+
+  // set up the resonance:
+  //  x[n] = a1 x[n-1] + a2 x[n-2] + g e[n], whose variance is
+  //  g^2 (1 - a2) / ((1 + a2) ((1 - a2)^2 - a1^2))
+  //
+  double r = AR_ALPHA_RADIUS;
+  double theta = 2.0 * M_PI * std::min(AR_ALPHA_FREQ, 0.45 * fs) / fs;
+  chan.a1_d = 2.0 * r * cos(theta);
+  chan.a2_d = -r * r;
+  double var = (1.0 - chan.a2_d) /
+    ((1.0 + chan.a2_d) * ((1.0 - chan.a2_d) * (1.0 - chan.a2_d) -
+			  chan.a1_d * chan.a1_d));
+  chan.alpha_gain_d = AR_ALPHA_RMS / sqrt(var);
+  chan.drift_gain_d = AR_DRIFT_RMS *
+    sqrt(1.0 - AR_DRIFT_COEF * AR_DRIFT_COEF);
+  chan.x1_d = 0.0;
+  chan.x2_d = 0.0;
+  chan.drift_d = 0.0;
+
+  // schedule the first spike and flatline
+  //
+  chan.spike_next_d = (long)(chan.rng_d.exponential(SPIKE_RATE) * fs);
+  chan.spike_pos_d = -1;
+  chan.spike_amp_d = 0.0;
+  chan.flat_next_d = (long)(chan.rng_d.exponential(FLAT_RATE) * fs);
+  chan.flat_left_d = 0;
+}
+
+// function: generate
+//
+// arguments:
+//  short int* buf: digital samples (output)
+//  Channel& chan: the channel state (input/output)
+//  long model: the components to include (input)
+//  long n0: index of the first sample (input)
+//  long n: number of samples (input)
+//  double fs: sample frequency (input)
+//
+// return: none
+//
+// This function generates the next n samples of a channel.
+//
+static void generate(short int* buf, Channel& chan, long model, long n0,
+		     long n, double fs) {
+
+  long spike_len = (long)(SPIKE_DUR * fs) + 1;
+
+  // the sinewaves are generated by rotating a phasor, which is started
+  // from the exact phase at the beginning of each call so rounding
+  // errors can't build up over a long recording
+  //
+  double re[NUM_SINES];
+  double im[NUM_SINES];
+  double rot_re[NUM_SINES];
+  double rot_im[NUM_SINES];
+  for (long i = 0; i < NUM_SINES; i++) {
+    double w = 2.0 * M_PI * chan.freq_d[i] / fs;
+    double phase = fmod(w * n0, 2.0 * M_PI) + chan.phase_d[i];
+    re[i] = chan.amp_d[i] * cos(phase);
+    im[i] = chan.amp_d[i] * sin(phase);
+    rot_re[i] = cos(w);
+    rot_im[i] = sin(w);
+  }
+
+  for (long k = 0; k < n; k++) {
+    double x = 0.0;
+
+    // sinewaves
+    //
+    if (model & MODEL_SINE) {
+      for (long i = 0; i < NUM_SINES; i++) {
+	x += im[i];
+	double tmp = re[i] * rot_re[i] - im[i] * rot_im[i];
+	im[i] = re[i] * rot_im[i] + im[i] * rot_re[i];
+	re[i] = tmp;
+      }
+    }
+
+    // autoregressive noise
+    //
+    if (model & MODEL_AR) {
+      double x0 = chan.a1_d * chan.x1_d + chan.a2_d * chan.x2_d +
+	chan.alpha_gain_d * chan.rng_d.gauss();
+      chan.x2_d = chan.x1_d;
+      chan.x1_d = x0;
+      chan.drift_d = AR_DRIFT_COEF * chan.drift_d +
+	chan.drift_gain_d * chan.rng_d.gauss();
+      x += x0 + chan.drift_d;
+    }
+
+    // spikes: a sharp biphasic transient with a decaying envelope
+    //
+    if (model & MODEL_SPIKE) {
+      if ((chan.spike_pos_d < 0) && (chan.spike_next_d-- <= 0)) {
+	chan.spike_pos_d = 0;
+	chan.spike_amp_d = chan.rng_d.uniform(SPIKE_AMIN, SPIKE_AMAX);
+	if (chan.rng_d.uniform() < 0.5) {
+	  chan.spike_amp_d = -chan.spike_amp_d;
+	}
+      }
+      if (chan.spike_pos_d >= 0) {
+	double u = (double)chan.spike_pos_d / spike_len;
+	x += chan.spike_amp_d * exp(-4.0 * u) * sin(2.0 * M_PI * u);
+	if (++chan.spike_pos_d >= spike_len) {
+	  chan.spike_pos_d = -1;
+	  chan.spike_next_d =
+	    (long)(chan.rng_d.exponential(SPIKE_RATE) * fs);
+	}
+      }
+    }
+
+    // flatlines: the electrode is disconnected, so everything else is
+    // replaced by zeros
+    //
+    if (model & MODEL_FLAT) {
+      if ((chan.flat_left_d <= 0) && (chan.flat_next_d-- <= 0)) {
+	chan.flat_left_d = (long)(chan.rng_d.uniform(FLAT_DMIN, FLAT_DMAX)
+				  * fs);
+	chan.flat_next_d = (long)(chan.rng_d.exponential(FLAT_RATE) * fs);
+      }
+      if (chan.flat_left_d > 0) {
+	chan.flat_left_d--;
+	x = 0.0;
+      }
+    }
+
+    // convert to digital units
+    //
+    double d = round(x / PHYS_RES);
+    if (d > DIG_MAX) {
+      d = DIG_MAX;
+    }
+    else if (d < DIG_MIN) {
+      d = DIG_MIN;
+    }
+    buf[k] = (short int)d;
+  }
+}
+
+//-----------------------------------------------------------------------------
+//
+// EDF output
+//
+//-----------------------------------------------------------------------------
+
+// function: put_field
+//
+// arguments:
+//  std::string& hdr: the header (output)
+//  const char* str: the value (input)
+//  long len: the width of the field (input)
+//
+// return: none
+//
+// This function appends a header field, padded with blanks and
+// truncated to the width of the field.
+//
+static void put_field(std::string& hdr, const char* str, long len) {
+  std::string fld(str);
+  fld.resize(len, ' ');
+  hdr += fld;
+}
+
+// function: put_field
+//
+// a version of put_field for numbers: the shortest %g format that fits
+//
+static void put_field(std::string& hdr, double val, long len) {
+  char buf[32];
+  for (long prec = 8; prec > 0; prec--) {
+    snprintf(buf, sizeof(buf), "%.*g", (int)prec, val);
+    if ((long)strlen(buf) <= len) {
+      break;
+    }
+  }
+  put_field(hdr, buf, len);
+}
+
+// function: write_edf
+//
+// arguments:
+//  const char* fname: output filename (input)
+//  long num_chans: number of channels (input)
+//  double fs: sample frequency (input)
+//  double rec_dur: duration of a data record in secs (input)
+//  long num_recs: number of data records (input)
+//  long model: the components of the signal model (input)
+//  const char* model_str: the model as given, for the header (input)
+//  uint64_t seed: seed of the file (input)
+//
+// return: a boolean indicating status
+//
+// This function writes an EDF file one data record at a time, so any
+// duration can be generated in a few kilobytes of memory.
+//
+static bool write_edf(const char* fname, long num_chans, double fs,
+		      double rec_dur, long num_recs, long model,
+		      const char* model_str, uint64_t seed) {
+
+  // build the header
+  //
+  long rec_samps = (long)round(fs * rec_dur);
+  std::string hdr;
+  char buf[Edf::MAX_LSTR_LENGTH];
+
+  put_field(hdr, "0", 8);
+  snprintf(buf, sizeof(buf), "X X X gen_edf_seed_%lu", (unsigned long)seed);
+  put_field(hdr, buf, 80);
+  snprintf(buf, sizeof(buf), "Startdate 01-JAN-2000 X X synthetic_%s",
+	   model_str);
+  put_field(hdr, buf, 80);
+  put_field(hdr, "01.01.00", 8);
+  put_field(hdr, "00.00.00", 8);
+  put_field(hdr, (double)(256 + 256 * num_chans), 8);
+  put_field(hdr, "", 44);
+  put_field(hdr, (double)num_recs, 8);
+  put_field(hdr, rec_dur, 8);
+  put_field(hdr, (double)num_chans, 4);
+
+  // add the signal fields: each field is written for all the channels
+  // before the next one
+  //
+  for (long i = 0; i < num_chans; i++) {
+    if (i < NUM_LABELS) {
+      snprintf(buf, sizeof(buf), "EEG %s-REF", LABELS[i]);
+    }
+    else {
+      snprintf(buf, sizeof(buf), "EEG X%ld-REF", i + 1);
+    }
+    put_field(hdr, buf, 16);
+  }
+  for (long i = 0; i < num_chans; i++) {
+    put_field(hdr, "synthetic", 80);
+  }
+  for (long i = 0; i < num_chans; i++) {
+    put_field(hdr, "uV", 8);
+  }
+  for (long i = 0; i < num_chans; i++) {
+    put_field(hdr, DIG_MIN * PHYS_RES, 8);
+  }
+  for (long i = 0; i < num_chans; i++) {
+    put_field(hdr, DIG_MAX * PHYS_RES, 8);
+  }
+  for (long i = 0; i < num_chans; i++) {
+    put_field(hdr, (double)DIG_MIN, 8);
+  }
+  for (long i = 0; i < num_chans; i++) {
+    put_field(hdr, (double)DIG_MAX, 8);
+  }
+  for (long i = 0; i < num_chans; i++) {
+    put_field(hdr, "", 80);
+  }
+  for (long i = 0; i < num_chans; i++) {
+    put_field(hdr, (double)rec_samps, 8);
+  }
+  for (long i = 0; i < num_chans; i++) {
+    put_field(hdr, "", 32);
+  }
+
+  // open the file and write the header
+  //
+  FILE* fp = fopen(fname, "wb");
+  if (fp == (FILE*)NULL) {
+    fprintf(stdout, " **> gen_edf: error opening file (%s)\n", fname);
+    return false;
+  }
+  if (fwrite(hdr.data(), 1, hdr.size(), fp) != hdr.size()) {
+    fprintf(stdout, " **> gen_edf: error writing header (%s)\n", fname);
+    fclose(fp);
+    return false;
+  }
+
+  // set up the channels
+  //
+  std::vector<Channel> chans(num_chans);
+  for (long i = 0; i < num_chans; i++) {
+    init_channel(chans[i], seed * 0x100000001b3ULL + i, fs);
+  }
+
+  // write the data records: EDF samples are little-endian 16-bit
+  // integers, stored byte by byte so the file is the same on any host
+  //
+  std::vector<short int> rec(num_chans * rec_samps);
+  std::vector<unsigned char> raw(2 * rec.size());
+  for (long r = 0; r < num_recs; r++) {
+    for (long i = 0; i < num_chans; i++) {
+      generate(rec.data() + i * rec_samps, chans[i], model, r * rec_samps,
+	       rec_samps, fs);
+    }
+    for (long j = 0; j < (long)rec.size(); j++) {
+      uint16_t v = (uint16_t)rec[j];
+      raw[2 * j] = (unsigned char)(v & 0xff);
+      raw[2 * j + 1] = (unsigned char)(v >> 8);
+    }
+    if (fwrite(raw.data(), 1, raw.size(), fp) != raw.size()) {
+      fprintf(stdout, " **> gen_edf: error writing data (%s)\n", fname);
+      fclose(fp);
+      return false;
+    }
+  }
+
+  // close the file
+  //
+  if (fclose(fp) != 0) {
+    fprintf(stdout, " **> gen_edf: error closing file (%s)\n", fname);
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// function: check_edf
+//
+// arguments:
+//  Edf& edf: the Edf object that reads the file (input)
+//  const char* fname: the file written by write_edf (input)
+//  long num_chans: number of channels (input)
+//  double fs: sample frequency (input)
+//  double rec_dur: duration of a data record in secs (input)
+//  long num_recs: number of data records (input)
+//  long model: the components of the signal model (input)
+//  uint64_t seed: seed of the file (input)
+//
+// return: a boolean indicating status
+//
+// This function reads a file back with Edf::read_edf and compares it
+// with the samples the signal model generates again from the same
+// seed. A sample matches when it is within half a digital step of the
+// value written, so this checks the header, the byte order and the
+// layout of the records.
+//
+static bool check_edf(Edf& edf, const char* fname, long num_chans,
+		      double fs, double rec_dur, long num_recs, long model,
+		      uint64_t seed) {
+
+  // read the file
+  //
+  VVectorDouble sig;
+  if (!edf.read_edf(sig, (char*)fname, true, true)) {
+    fprintf(stdout, "  **> gen_edf: error reading back (%s)\n", fname);
+    return false;
+  }
+
+  // check the sample frequency and the size of the signal
+  //
+  long rec_samps = (long)round(fs * rec_dur);
+  if ((fabs(edf.get_sample_frequency() - fs) > 1.0e-3 * fs) ||
+      ((long)sig.size() != num_chans)) {
+    fprintf(stdout, "  **> gen_edf: read back %ld channels at %g Hz "
+	    "(%s)\n", (long)sig.size(), (double)edf.get_sample_frequency(),
+	    fname);
+    return false;
+  }
+  for (long i = 0; i < num_chans; i++) {
+    if ((long)sig[i].size() != num_recs * rec_samps) {
+      fprintf(stdout, "  **> gen_edf: read back %ld samples of channel "
+	      "%ld (%s)\n", (long)sig[i].size(), i, fname);
+      return false;
+    }
+  }
+
+  // generate the samples again and compare
+  //
+  std::vector<short int> buf(rec_samps);
+  for (long i = 0; i < num_chans; i++) {
+    Channel chan;
+    init_channel(chan, seed * 0x100000001b3ULL + i, fs);
+    for (long r = 0; r < num_recs; r++) {
+      generate(buf.data(), chan, model, r * rec_samps, rec_samps, fs);
+      const double* val = sig[i].data() + r * rec_samps;
+      for (long k = 0; k < rec_samps; k++) {
+	if (fabs(val[k] - buf[k] * PHYS_RES) > 0.5 * PHYS_RES) {
+	  fprintf(stdout, "  **> gen_edf: channel %ld, sample %ld reads "
+		  "back as %g, not %g (%s)\n", i, r * rec_samps + k,
+		  val[k], buf[k] * PHYS_RES, fname);
+	  return false;
+	}
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// command line parsing
+//
+//-----------------------------------------------------------------------------
+
+// function: parse_duration
+//
+// arguments:
+//  double& secs: the duration in seconds (output)
+//  const char* str: a number with an optional s, m, h or d suffix (input)
+//
+// return: a boolean indicating status
+//
+static bool parse_duration(double& secs, const char* str) {
+
+  char* rest;
+  secs = strtod(str, &rest);
+  if ((rest == str) || (secs <= 0)) {
+    return false;
+  }
+  if ((strcmp(rest, "") == 0) || (strcmp(rest, "s") == 0)) {
+    return true;
+  }
+  else if (strcmp(rest, "m") == 0) {
+    secs *= 60.0;
+  }
+  else if (strcmp(rest, "h") == 0) {
+    secs *= 3600.0;
+  }
+  else if (strcmp(rest, "d") == 0) {
+    secs *= 86400.0;
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+// function: parse_model
+//
+// arguments:
+//  long& model: the selected components (output)
+//  const char* str: comma-separated list of sine, ar, spike, flat (input)
+//
+// return: a boolean indicating status
+//
+static bool parse_model(long& model, const char* str) {
+
+  model = 0;
+  std::string spec(str);
+  size_t beg = 0;
+  while (beg <= spec.size()) {
+    size_t end = spec.find(',', beg);
+    if (end == std::string::npos) {
+      end = spec.size();
+    }
+    std::string item = spec.substr(beg, end - beg);
+    if (item == "sine") {
+      model |= MODEL_SINE;
+    }
+    else if (item == "ar") {
+      model |= MODEL_AR;
+    }
+    else if (item == "spike") {
+      model |= MODEL_SPIKE;
+    }
+    else if (item == "flat") {
+      model |= MODEL_FLAT;
+    }
+    else {
+      return false;
+    }
+    beg = end + 1;
+  }
+  return (model != 0);
+}
+
+// main: driver program
+//
+// This is a driver program that writes synthetic EDF files for
+// benchmarking. Each output file gets its own seed (the base seed plus
+// its position on the command line), so a corpus is reproducible.
+//
+int main(int argc, const char** argv) {
+
+  // declare local variables
+  //
+  long status = 0;
+
+  // create a Dbgl object for local debugging
+  // (the level of this object is set by the cmdl object during parsing)
+  //
+  Dbgl dbgl;
+  Vrbl vrbl;
+
+  // create an Edf object: it is used to read back the files we write
+  //
+  Edf edf;
+
+  // initialize a Command Line object
+  //
+  Cmdl cmdl;
+  cmdl.set_usage(USAGE_MSG);
+  cmdl.set_help(HELP_MSG);
+
+  // add options
+  //
+  char chans_str[Cmdl::MAX_OPTVAL_SIZE];
+  strcpy(chans_str, "22");
+  cmdl.add_option("-channels", chans_str);
+
+  char rate_str[Cmdl::MAX_OPTVAL_SIZE];
+  strcpy(rate_str, "250");
+  cmdl.add_option("-rate", rate_str);
+
+  char dur_str[Cmdl::MAX_OPTVAL_SIZE];
+  strcpy(dur_str, "1m");
+  cmdl.add_option("-duration", dur_str);
+
+  char rec_str[Cmdl::MAX_OPTVAL_SIZE];
+  strcpy(rec_str, "1");
+  cmdl.add_option("-record", rec_str);
+
+  char model_str[Cmdl::MAX_OPTVAL_SIZE];
+  strcpy(model_str, "sine,ar,spike,flat");
+  cmdl.add_option("-model", model_str);
+
+  char seed_str[Cmdl::MAX_OPTVAL_SIZE];
+  strcpy(seed_str, "1");
+  cmdl.add_option("-seed", seed_str);
+
+  char check_str[Cmdl::MAX_OPTVAL_SIZE];
+  strcpy(check_str, "yes");
+  cmdl.add_option("-check", check_str);
+
+  // branch on the status of parsing, checking for usage and help messages
+  //
+  if ((argc == 1) || (cmdl.parse(argc, argv) == false)) {
+    cmdl.display_usage(stdout);
+    return (status);
+  }
+  else if (cmdl.get_help_status() == true) {
+    cmdl.display_help(stdout);
+    return (status);
+  }
+
+  // check the options
+  //
+  long num_chans = atol(chans_str);
+  double fs = atof(rate_str);
+  double secs;
+  double rec_dur;
+  long model;
+  uint64_t seed = strtoull(seed_str, NULL, 10);
+
+  if ((num_chans <= 0) || (num_chans > 9999)) {
+    fprintf(stdout, "**> gen_edf: invalid number of channels (%s)\n",
+	    chans_str);
+    exit(1);
+  }
+  if (fs <= 0) {
+    fprintf(stdout, "**> gen_edf: invalid sample rate (%s)\n", rate_str);
+    exit(1);
+  }
+  if (!parse_duration(secs, dur_str)) {
+    fprintf(stdout, "**> gen_edf: invalid duration (%s)\n", dur_str);
+    exit(1);
+  }
+  if (!parse_duration(rec_dur, rec_str) ||
+      (fabs(fs * rec_dur - round(fs * rec_dur)) > 1.0e-6)) {
+    fprintf(stdout, "**> gen_edf: the record duration (%s) must hold a "
+	    "whole number of samples\n", rec_str);
+    exit(1);
+  }
+  if (!parse_model(model, model_str)) {
+    fprintf(stdout, "**> gen_edf: invalid model (%s)\n", model_str);
+    exit(1);
+  }
+  if ((strcmp(check_str, "yes") != 0) && (strcmp(check_str, "no") != 0)) {
+    fprintf(stdout, "**> gen_edf: invalid check (%s)\n", check_str);
+    exit(1);
+  }
+  bool check = (strcmp(check_str, "yes") == 0);
+  long num_recs = (long)ceil(secs / rec_dur - 1.0e-9);
+
+  // display an informational message
+  //
+  fprintf(stdout, "generating %ld channels at %g Hz, %ld records of %g "
+	  "secs, model = %s\n", num_chans, fs, num_recs, rec_dur, model_str);
+
+  // write the files
+  //
+  long num_files_att = 0;
+  long num_files_proc = 0;
+
+  for (int i = cmdl.get_first_arg_pos(); i < argc; i++) {
+
+    // display a status message
+    //
+    num_files_att++;
+    fprintf(stdout, "  %6ld: %s\n", num_files_att, argv[i]);
+
+    // write the file and make sure the library reads it back
+    //
+    std::chrono::steady_clock::time_point t0 =
+      std::chrono::steady_clock::now();
+    if (!write_edf(argv[i], num_chans, fs, rec_dur, num_recs, model,
+		   model_str, seed + num_files_att - 1)) {
+      continue;
+    }
+    double elapsed = std::chrono::duration<double>
+      (std::chrono::steady_clock::now() - t0).count();
+
+    if (!edf.is_edf((char*)argv[i])) {
+      fprintf(stdout, "  **> gen_edf: not a valid edf file (%s)\n",
+	      argv[i]);
+      continue;
+    }
+    if (check && !check_edf(edf, argv[i], num_chans, fs, rec_dur,
+			    num_recs, model, seed + num_files_att - 1)) {
+      continue;
+    }
+
+    double mbytes = (256.0 * (num_chans + 1) +
+		     2.0 * num_chans * num_recs * round(fs * rec_dur)) / 1.0e6;
+    fprintf(stdout, "          %.1f MB in %.2f secs\n", mbytes, elapsed);
+    num_files_proc++;
+  }
+
+  // display the results
+  //
+  fprintf(stdout, "generated %ld out of %ld files successfully\n",
+	  num_files_proc, num_files_att);
+  if (num_files_proc < num_files_att) {
+    status = 1;
+  }
+
+  // exit gracefully
+  //
+  exit(status);
+}
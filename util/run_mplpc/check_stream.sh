@@ -0,0 +1,107 @@
+#!/bin/sh
+#
+# file: check_stream.sh
+#
+# This script checks that the readers that work from the EDF data
+# records - streaming (stream_records > 0) and direct whole-file reads
+# (direct_read = 1) - give exactly the pulses of a whole-file read
+# through the Edf class, for a montage and for a channel selection.
+#
+# It writes synthetic recordings with gen_edf and runs run_mplpc -verify
+# 0 on them. The reference engine reads each file whole through the
+# Edf class; the engine configured here differs from it only in how the
+# file is read, so every pulse must match exactly. The exit status is 1
+# if any file differs.
+#
+# usage: check_stream.sh [work directory]
+#
+
+# define the tools and the work directory
+#
+RUN_MPLPC=./run_mplpc
+GEN_EDF=../gen_edf/gen_edf
+WORK=${1:-check_work}
+
+# generate the recordings: the record lengths and durations are chosen
+# so that no block size divides the number of records
+#
+mkdir -p $WORK || exit 1
+$GEN_EDF -channels 24 -duration 95 -seed 1 $WORK/a.edf $WORK/b.edf \
+	 > /dev/null || exit 1
+$GEN_EDF -channels 8 -rate 256 -record 2 -duration 62 -seed 3 \
+	 $WORK/c.edf > /dev/null || exit 1
+
+# write a parameter file: the shipped defaults, a way of reading the
+# file and a channel configuration
+#
+write_params() {
+  cat > $1 <<EOF
+version = 1.0
+select_mode = select
+match_mode = exact
+sample_frequency = 250
+frame_duration = 0.1
+window_duration = 0.2
+window_type = hamming
+window_norm = energy
+window_alignment = right
+debias_mode = signal
+preemphasis = 0.95
+lp_order = 12
+impulse_response_duration = 0.05
+num_pulses = 4
+feat_type = mplpc
+pulse_search = full
+simd_mode = none
+precision = mixed
+num_threads = 1
+channel_lanes = 0
+$2
+$3
+output_format = raw
+output_directory = $WORK/out
+output_replace = null
+output_extension = mplpc
+EOF
+}
+
+# define the channel configurations
+#
+MONTAGE="channel_selection = null
+montage = 0, FP1-F7: EEG FP1-REF -- EEG F7-REF
+montage = 1, F7-T3: EEG F7-REF -- EEG T3-REF
+montage = 2, C3-CZ: EEG C3-REF -- EEG CZ-REF
+montage = 3, O1: EEG O1-REF"
+SELECT="channel_selection = EEG FP1-REF,EEG C3-REF,EEG O2-REF
+montage = null"
+
+# check each way of reading against each configuration
+#
+status=0
+for read in "stream_records = 1" "stream_records = 7" \
+	    "stream_records = 1000" "direct_read = 1"; do
+  for chans in montage select; do
+    if [ $chans = montage ]; then
+      write_params $WORK/params.txt "$read" "$MONTAGE"
+    else
+      write_params $WORK/params.txt "$read" "$SELECT"
+    fi
+    echo "check_stream: $read, $chans"
+    if ! $RUN_MPLPC -p $WORK/params.txt -verify 0 $WORK/a.edf \
+	 $WORK/b.edf $WORK/c.edf > $WORK/verify.log; then
+      cat $WORK/verify.log
+      echo "check_stream: FAILED ($read, $chans)"
+      status=1
+    fi
+  done
+done
+
+# exit gracefully
+#
+if [ $status -eq 0 ]; then
+  echo "check_stream: PASSED"
+fi
+exit $status
+
+#
+# end of file
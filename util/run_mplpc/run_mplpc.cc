@@ -1,4 +1,16 @@
 
+// system include files
+//
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 // local include files
 //
 #include <Cmdl.h>
@@ -9,6 +21,232 @@
 #define USAGE_MSG "$VFC/util/cpp/run_mplpc/run_mplpc.usage"
 #define HELP_MSG "$VFC/util/cpp/run_mplpc/run_mplpc.help"
 
+// function: init_mplpc
+//
+// arguments:
+//  Mplpc& mplpc: the object to initialize (output)
+//  char* pfile: parameter file (input)
+//  char* out_dir: output directory override, or empty (input)
+//  char* repl_dir: replace directory override, or empty (input)
+//  char* num_threads: channel thread override, or empty (input)
+//  bool profile: turn on stage profiling (input)
+//
+// return: a boolean indicating status
+//
+// This function loads the parameter file and applies the command line
+// overrides. Batch mode uses it to give every job its own object.
+//
+static bool init_mplpc(Mplpc& mplpc, char* pfile, char* out_dir,
+		       char* repl_dir, char* num_threads, bool profile) {
+
+  // load the parameter file
+  //
+  if (!mplpc.load_parameters(pfile)) {
+    fprintf(stdout, "**> error parsing the parameter file (%s)\n", pfile);
+    return false;
+  }
+
+  // allow the output directory to be overridden
+  //
+  if(out_dir[0] != (char)NULL){
+    mplpc.set_output_directory(out_dir);
+  }
+
+  // allow the replace directory to be overridden:
+  //  check for "-r" argument
+  //
+  if(repl_dir[0] != (char)NULL){
+    mplpc.set_repl_directory(repl_dir);
+  }
+
+  // allow the number of channel worker threads to be overridden
+  //
+  if(num_threads[0] != (char)NULL){
+    mplpc.set_num_threads(atol(num_threads));
+  }
+
+  // turn on profiling
+  //
+  mplpc.set_profile(profile);
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// function: write_profile
+//
+// arguments:
+//  const char* fname: json output filename (input)
+//  std::vector<std::string>& names: processed filenames (input)
+//  std::vector<MplpcProfile>& profs: their profiles (input)
+//  MplpcProfile& total: the aggregate profile (input)
+//
+// return: a boolean indicating status
+//
+// This function writes the per-file and aggregate profiles as json.
+//
+static bool write_profile(const char* fname,
+			  std::vector<std::string>& names,
+			  std::vector<MplpcProfile>& profs,
+			  MplpcProfile& total) {
+
+  // open the file
+  //
+  FILE* fp = fopen(fname, "w");
+  if (fp == (FILE*)NULL) {
+    fprintf(stdout, " **> run_mplpc: error opening profile (%s)\n", fname);
+    return false;
+  }
+
+  // write the profiles
+  //
+  fprintf(fp, "{\"files\": [\n");
+  for (long i = 0; i < (long)profs.size(); i++) {
+    profs[i].write_json(fp, names[i].c_str(), "  ");
+    fprintf(fp, "%s\n", (i + 1 < (long)profs.size()) ? "," : "");
+  }
+  fprintf(fp, "],\n\"total\":\n");
+  total.write_json(fp, "total", "  ");
+  fprintf(fp, "\n}\n");
+
+  // close the file
+  //
+  if (fclose(fp) != 0) {
+    fprintf(stdout, " **> run_mplpc: error writing profile (%s)\n", fname);
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// function: parse_tolerance
+//
+// arguments:
+//  MplpcVerify& verify: holds the tolerances (output)
+//  const char* str: the tolerance specification (input)
+//
+// return: a boolean indicating status
+//
+// This function parses the argument of -verify: a comma-separated list
+// of a number of ulps, written with an "ulp" suffix (e.g. 4ulp), and/or
+// a relative tolerance (e.g. 1e-6). A gain passes if it is within
+// either. "0" requires the gains to match exactly.
+//
+static bool parse_tolerance(MplpcVerify& verify, const char* str) {
+
+  verify.ulps_d = 0;
+  verify.rtol_d = 0.0;
+
+  std::string spec(str);
+  size_t beg = 0;
+  while (beg <= spec.size()) {
+    size_t end = spec.find(',', beg);
+    if (end == std::string::npos) {
+      end = spec.size();
+    }
+    std::string item = spec.substr(beg, end - beg);
+    char* rest;
+    double val = strtod(item.c_str(), &rest);
+    if ((rest == item.c_str()) || (val < 0)) {
+      return false;
+    }
+    if (strcmp(rest, "ulp") == 0) {
+      verify.ulps_d = (long)val;
+    }
+    else if (*rest == (char)NULL) {
+      verify.rtol_d = val;
+    }
+    else {
+      return false;
+    }
+    beg = end + 1;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// function: get_file_size
+//
+// arguments:
+//  const std::string& fname: filename (input)
+//
+// return: the size of the file in bytes, or 0 if it can't be found
+//
+// This function is used to estimate how long a file takes to process:
+// for EDF files the size is proportional to the number of samples.
+//
+static long get_file_size(const std::string& fname) {
+  struct stat st;
+  if (stat(fname.c_str(), &st) != 0) {
+    return (long)0;
+  }
+  return (long)st.st_size;
+}
+
+// class: PipeQueue
+//
+// A bounded queue between two stages of the file pipeline: push() waits
+// while the queue is full, so a fast stage can only get depth files
+// ahead of a slow one, and pop() waits while it is empty. Once close()
+// is called, pop() returns what is left and then false.
+//
+template <class T>
+class PipeQueue {
+public:
+
+  PipeQueue(long depth) {
+    depth_d = depth;
+    closed_d = false;
+  }
+
+  void push(T& item) {
+    std::unique_lock<std::mutex> lock(mutex_d);
+    cond_d.wait(lock, [&]() { return (long)items_d.size() < depth_d; });
+    items_d.push_back(std::move(item));
+    cond_d.notify_all();
+  }
+
+  bool pop(T& item) {
+    std::unique_lock<std::mutex> lock(mutex_d);
+    cond_d.wait(lock, [&]() { return closed_d || !items_d.empty(); });
+    if (items_d.empty()) {
+      return false;
+    }
+    item = std::move(items_d.front());
+    items_d.pop_front();
+    cond_d.notify_all();
+    return true;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_d);
+    closed_d = true;
+    cond_d.notify_all();
+  }
+
+private:
+  long depth_d;
+  bool closed_d;
+  std::deque<T> items_d;
+  std::mutex mutex_d;
+  std::condition_variable cond_d;
+};
+
+// a file on its way through the pipeline
+//
+struct PipeFile {
+  std::string fname;                    // input filename
+  MplpcInput in;                        // the file, read ahead
+  VMplpcPulses sig;                     // its pulses
+  MplpcProfile prof;                    // its profile
+  bool status;                          // the analysis succeeded
+};
+
 // main: driver program
 //
 // This is a driver program that reads EDF files and generates
@@ -54,6 +292,30 @@ int main(int argc, const char** argv) {
   repl_dir[0] = (char)NULL;
   cmdl.add_option("-rdir", repl_dir);
 
+  char num_threads[Cmdl::MAX_OPTVAL_SIZE];
+  num_threads[0] = (char)NULL;
+  cmdl.add_option("-threads", num_threads);
+
+  char num_jobs_str[Cmdl::MAX_OPTVAL_SIZE];
+  num_jobs_str[0] = (char)NULL;
+  cmdl.add_option("-jobs", num_jobs_str);
+
+  char trace_fname[Cmdl::MAX_OPTVAL_SIZE];
+  trace_fname[0] = (char)NULL;
+  cmdl.add_option("-trace", trace_fname);
+
+  char prof_fname[Cmdl::MAX_OPTVAL_SIZE];
+  prof_fname[0] = (char)NULL;
+  cmdl.add_option("-profile", prof_fname);
+
+  char verify_str[Cmdl::MAX_OPTVAL_SIZE];
+  verify_str[0] = (char)NULL;
+  cmdl.add_option("-verify", verify_str);
+
+  char depth_str[Cmdl::MAX_OPTVAL_SIZE];
+  depth_str[0] = (char)NULL;
+  cmdl.add_option("-pipeline", depth_str);
+
   // branch on the status of parsing, checking for usage and help messages
   //
   if ((argc == 1) || (cmdl.parse(argc, argv) == false)) {
@@ -65,27 +327,23 @@ int main(int argc, const char** argv) {
     return (status);
   }     
   
-  // load the parameter file
+  // parse the verification tolerances: verification replaces the
+  // analysis, so nothing is profiled or written
   //
-  if (!mplpc.load_parameters((char*)pfile)) {
-    fprintf(stdout, "**> error parsing the parameter file (%s)\n",
-	    (char*)pfile);
+  bool verify = (verify_str[0] != (char)NULL);
+  MplpcVerify tol;
+  if (verify && !parse_tolerance(tol, verify_str)) {
+    fprintf(stdout, "**> run_mplpc: invalid tolerance (%s)\n", verify_str);
     exit(1);
   }
-  mplpc.print_parameters(stdout);
-  
-  // allow the output directory to be overridden
-  //
-  if(out_dir[0] != (char)NULL){
-    mplpc.set_output_directory(out_dir);
-  }
 
-  // allow the replace directory to be overridden:
-  //  check for "-r" argument
+  // load the parameter file and apply the command line overrides
   //
-  if(repl_dir[0] != (char)NULL){
-    mplpc.set_repl_directory(repl_dir);
+  bool profile = (prof_fname[0] != (char)NULL) && !verify;
+  if (!init_mplpc(mplpc, pfile, out_dir, repl_dir, num_threads, profile)) {
+    exit(1);
   }
+  mplpc.print_parameters(stdout);
 
   // initialize all the helper function so that they are initialized atleast once
   // and not inlined in the executable..
@@ -106,32 +364,17 @@ int main(int argc, const char** argv) {
   //
   fprintf(stdout, "beginning argument processing...\n");
 
-  // main processing loop: loop over all input filenames
+  // collect the input filenames: edf files are used as is, anything
+  // else is treated as a file list
   //
-  long num_files_att = 0;
-  long num_files_proc = 0;
-  char osig_fname[Edf::MAX_LSTR_LENGTH];
+  std::vector<std::string> fnames;
 
   for (int i=cmdl.get_first_arg_pos(); i<argc; i++) {
 
-    // if it is an edf file, process it
+    // if it is an edf file, queue it
     //
     if (edf.is_edf((char*)argv[i])) {
-
-      // display a status message
-      //
-      num_files_att++;
-      fprintf(stdout, "  %6ld: %s\n", num_files_att, (char*)argv[i]);
-
-      // execute mplpc
-      //
-      if (mplpc.compute(osig_fname, (char*)argv[i])) {
-	fprintf(stdout, "          %s\n", osig_fname);
-	num_files_proc++;
-      }
-      else {
-	fprintf(stdout, "  **> run_mplpc: error generating mplpc signal\n");
-      }
+      fnames.push_back(std::string(argv[i]));
     }
 
     // else: treat it as a file list
@@ -155,33 +398,287 @@ int main(int argc, const char** argv) {
       //
       char edf_fname[Edf::MAX_LSTR_LENGTH];
       while (fscanf(fp, "%s", edf_fname) == 1) {
+	fnames.push_back(std::string(edf_fname));
+      }
 
-	// display a status message
-	//
-	num_files_att++;
-	fprintf(stdout, "  %6ld: %s\n", num_files_att, edf_fname);
+      // close the list
+      //
+      fclose(fp);
+    }
+  }
+
+  // main processing loop: loop over all input filenames
+  //
+  long num_files_att = 0;
+  long num_files_proc = 0;
+  long num_files_fail = 0;
+  long num_files = fnames.size();
+  long num_jobs = atol(num_jobs_str);
+  if (num_jobs > num_files) {
+    num_jobs = num_files;
+  }
+  long depth = atol(depth_str);
+
+  // the profiles of the files processed successfully
+  //
+  std::vector<std::string> prof_names;
+  std::vector<MplpcProfile> profs;
+  long long prof_beg = MplpcTrace::now();
+
+  // case 1: process the files one at a time, in order, with the reading
+  // of the next files and the writing of the previous ones overlapping
+  // the analysis. a reader and a writer thread, each with its own
+  // object, are connected to the analysis by queues of depth files, so
+  // at most 2 * depth + 3 files are in memory at once.
+  //
+  if ((num_jobs <= 1) && (depth > 0) && !verify) {
+
+    fprintf(stdout, "processing %ld files with a pipeline of depth %ld...\n",
+	    num_files, depth);
+
+    PipeQueue<PipeFile> read_q(depth);
+    PipeQueue<PipeFile> write_q(depth);
+
+    // the reader and the writer get their own objects. as in batch
+    // mode, they are initialized here, before the threads start.
+    //
+    Mplpc read_mplpc;
+    Mplpc write_mplpc;
+    if (!init_mplpc(read_mplpc, pfile, out_dir, repl_dir, num_threads,
+		    profile) ||
+	!init_mplpc(write_mplpc, pfile, out_dir, repl_dir, num_threads,
+		    profile)) {
+      fprintf(stdout, " **> run_mplpc: error initializing the pipeline\n");
+      exit(1);
+    }
+
+    // stage 1: read and decode the files in order
+    //
+    std::thread reader([&]() {
+      for (long i = 0; i < num_files; i++) {
+	PipeFile file;
+	file.fname = fnames[i];
+	read_mplpc.read_file(file.in, (char*)file.fname.c_str());
+	read_q.push(file);
+      }
+      read_q.close();
+    });
 
-	// compute features
-	//
-	if (mplpc.compute(osig_fname, edf_fname)) {
+    // stage 3: write the files in order and report on them
+    //
+    std::thread writer([&]() {
+      char osig_fname[Edf::MAX_LSTR_LENGTH];
+      PipeFile file;
+      while (write_q.pop(file)) {
+	num_files_att++;
+	fprintf(stdout, "  %6ld: %s\n", num_files_att, file.fname.c_str());
+	if (file.status &&
+	    write_mplpc.write_file(osig_fname, (char*)file.fname.c_str(),
+				   file.sig)) {
 	  fprintf(stdout, "          %s\n", osig_fname);
 	  num_files_proc++;
+	  if (profile) {
+	    file.prof.add(write_mplpc.get_profile());
+	    fprintf(stdout, "          %.3f secs, %.3f Msamples/sec\n",
+		    file.prof.wall_d,
+		    file.prof.nsamps_d / file.prof.wall_d * 1.0e-6);
+	    prof_names.push_back(file.fname);
+	    profs.push_back(file.prof);
+	  }
 	}
 	else {
 	  fprintf(stdout, "  **> run_mplpc: error generating mplpc signal\n");
 	}
+	file.sig.clear();
       }
+    });
 
-      // close the list
+    // stage 2: analyze the files in this thread. as in compute(),
+    // nothing is written for a file whose analysis fails.
+    //
+    PipeFile file;
+    while (read_q.pop(file)) {
+      file.status = mplpc.compute_input(file.sig, file.in);
+      file.in.clear();
+      file.prof = mplpc.get_profile();
+      write_q.push(file);
+    }
+    write_q.close();
+    reader.join();
+    writer.join();
+  }
+
+  // case 2: process the files one at a time, in order
+  //
+  else if (num_jobs <= 1) {
+
+    char osig_fname[Edf::MAX_LSTR_LENGTH];
+
+    for (long i = 0; i < num_files; i++) {
+
+      // display a status message
       //
-      fclose(fp);
+      num_files_att++;
+      fprintf(stdout, "  %6ld: %s\n", num_files_att, fnames[i].c_str());
+
+      // compare the reference and the configured engines
+      //
+      if (verify) {
+	MplpcVerify result = tol;
+	if (mplpc.verify(result, (char*)fnames[i].c_str())) {
+	  result.print(stdout, fnames[i].c_str());
+	  num_files_proc++;
+	  num_files_fail += result.passed() ? 0 : 1;
+	}
+	else {
+	  fprintf(stdout, "  **> run_mplpc: error verifying file\n");
+	}
+      }
+
+      // execute mplpc
+      //
+      else if (mplpc.compute(osig_fname, (char*)fnames[i].c_str())) {
+	fprintf(stdout, "          %s\n", osig_fname);
+	num_files_proc++;
+	if (profile) {
+	  const MplpcProfile& prof = mplpc.get_profile();
+	  fprintf(stdout, "          %.3f secs, %.3f Msamples/sec\n",
+		  prof.wall_d, prof.nsamps_d / prof.wall_d * 1.0e-6);
+	  prof_names.push_back(fnames[i]);
+	  profs.push_back(prof);
+	}
+      }
+      else {
+	fprintf(stdout, "  **> run_mplpc: error generating mplpc signal\n");
+      }
+    }
+  }
+
+  // case 3: batch mode - run num_jobs files concurrently, each with its
+  // own Mplpc object. the files are scheduled longest first (using the
+  // file size as an estimate of the work) so a long recording doesn't
+  // start last and dominate the total run time.
+  //
+  else {
+
+    // sort the files by decreasing size
+    //
+    std::vector<std::pair<long, long> > order(num_files);
+    for (long i = 0; i < num_files; i++) {
+      order[i] = std::make_pair(-get_file_size(fnames[i]), i);
     }
-  }    
+    std::sort(order.begin(), order.end());
+
+    fprintf(stdout, "processing %ld files with %ld jobs...\n",
+	    num_files, num_jobs);
+
+    // each job gets its own analysis (and hence Edf) state. the objects
+    // are initialized here, one at a time, because loading a parameter
+    // file goes through Edf code that isn't known to be thread-safe.
+    //
+    std::vector<Mplpc> job_mplpcs(num_jobs);
+    for (long j = 0; j < num_jobs; j++) {
+      if (!init_mplpc(job_mplpcs[j], pfile, out_dir, repl_dir, num_threads,
+		      profile)) {
+	fprintf(stdout, " **> run_mplpc: error initializing job %ld\n", j);
+	exit(1);
+      }
+    }
+
+    // launch the jobs: each one pulls the next file off the schedule
+    //
+    std::atomic<long> next_file(0);
+    std::mutex io_mutex;
+    std::vector<std::thread> jobs;
+
+    for (long j = 0; j < num_jobs; j++) {
+      jobs.push_back(std::thread([&, j]() {
+
+	Mplpc& job_mplpc = job_mplpcs[j];
+	char job_fname[Edf::MAX_LSTR_LENGTH];
+
+	long k;
+	while ((k = next_file++) < num_files) {
+	  const char* fname = fnames[order[k].second].c_str();
+	  MplpcVerify result = tol;
+	  bool job_status = verify ? job_mplpc.verify(result, (char*)fname) :
+	    job_mplpc.compute(job_fname, (char*)fname);
+
+	  // display a status message
+	  //
+	  std::lock_guard<std::mutex> lock(io_mutex);
+	  num_files_att++;
+	  fprintf(stdout, "  %6ld: %s\n", num_files_att, fname);
+	  if (job_status && verify) {
+	    result.print(stdout, fname);
+	    num_files_proc++;
+	    num_files_fail += result.passed() ? 0 : 1;
+	  }
+	  else if (job_status) {
+	    fprintf(stdout, "          %s\n", job_fname);
+	    num_files_proc++;
+	    if (profile) {
+	      const MplpcProfile& prof = job_mplpc.get_profile();
+	      fprintf(stdout, "          %.3f secs, %.3f Msamples/sec\n",
+		      prof.wall_d, prof.nsamps_d / prof.wall_d * 1.0e-6);
+	      prof_names.push_back(std::string(fname));
+	      profs.push_back(prof);
+	    }
+	  }
+	  else {
+	    fprintf(stdout,
+		    "  **> run_mplpc: error generating mplpc signal\n");
+	  }
+	}
+      }));
+    }
+    for (long j = 0; j < num_jobs; j++) {
+      jobs[j].join();
+    }
+  }
 
   // display the results
   //
   fprintf(stdout, "processed %ld out of %ld files successfully\n",
 	  num_files_proc, num_files_att);
+
+  // a verification run fails if any file didn't verify, so it can gate
+  // the rollout of an engine
+  //
+  if (verify) {
+    fprintf(stdout, "verified %ld files: %ld passed, %ld failed\n",
+	    num_files_proc, num_files_proc - num_files_fail, num_files_fail);
+    if ((num_files_fail > 0) || (num_files_proc < num_files_att)) {
+      status = 1;
+    }
+  }
+
+  // report the profile: the aggregate wall time is the time taken by
+  // the whole run, which is less than the sum over files in batch mode
+  //
+  if (profile) {
+    MplpcProfile total;
+    for (long i = 0; i < (long)profs.size(); i++) {
+      total.add(profs[i]);
+    }
+    total.wall_d = (MplpcTrace::now() - prof_beg) * 1.0e-9;
+    total.print(stdout, "all files");
+    if (write_profile(prof_fname, prof_names, profs, total)) {
+      fprintf(stdout, "wrote profile to %s\n", prof_fname);
+    }
+  }
+
+  // write the trace: all the workers have finished by now
+  //
+  if (trace_fname[0] != (char)NULL) {
+    if (!MplpcTrace::enabled()) {
+      fprintf(stdout,
+	      "  **> run_mplpc: not built with tracing (make TRACE=1)\n");
+    }
+    if (MplpcTrace::write(trace_fname)) {
+      fprintf(stdout, "wrote trace to %s\n", trace_fname);
+    }
+  }
   
   // exit gracefully
   //
@@ -0,0 +1,556 @@
+#!/usr/bin/env python3
+#
+# file: scale_mplpc.py
+#
+# This script is an end-to-end scaling benchmark for run_mplpc. It
+# generates synthetic recordings with gen_edf and times run_mplpc over a
+# sweep of thread count, channel count, recording duration, num_pulses
+# and lp_order, and over the engine settings: stream_records, simd_mode
+# and pulse_search (the first value of each is used for the other
+# sweeps). For each point it records the wall time, cpu time, peak
+# resident memory, page faults, context switches and samples/second, and
+# the I/O and analysis times from run_mplpc -profile. It then computes
+# strong- and weak-scaling efficiencies and writes everything to a csv
+# and a json file that can be compared between versions (--compare).
+#
+# usage: scale_mplpc.py -p params.txt [options]
+#
+
+# import system modules
+#
+import argparse
+import csv
+import datetime
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import time
+
+#------------------------------------------------------------------------------
+#
+# global variables
+#
+#------------------------------------------------------------------------------
+
+# define the directory of this script: the tools are found relative to it
+#
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+# define the presets: each is a set of defaults for the sweep options
+#
+#  the quick preset runs the shipped defaults (whole-file reads, no
+#  simd, full search). the full preset streams a minute of records at a
+#  time: read whole, the 24h points would need many GB per 64 channels
+#
+PRESETS = {
+    "quick": {"threads": "1,2,4", "channels": "4,8,16",
+              "durations": "1m,10m", "pulses": "4,8", "orders": "12,16",
+              "reads": "0,60", "simd": "none,auto",
+              "search": "full,incremental", "repeat": 3},
+    "full": {"threads": "1,2,4,8,16,32", "channels": "8,16,32,64",
+             "durations": "1m,1h,24h", "pulses": "4,8,16",
+             "orders": "8,12,16,24", "reads": "60,0", "simd": "none,auto",
+             "search": "full,incremental", "repeat": 3}
+}
+
+# define the columns of the csv file
+#
+CSV_FIELDS = ["sweeps", "threads", "channels", "duration_secs", "rate",
+              "num_pulses", "lp_order", "stream_records", "simd_mode",
+              "pulse_search", "samples", "wall_secs",
+              "wall_secs_min", "wall_secs_max", "cpu_secs", "cpu_util",
+              "peak_rss_mb", "samples_per_sec", "minor_faults",
+              "major_faults", "vol_ctx_switches", "invol_ctx_switches",
+              "read_secs", "write_secs", "analysis_secs", "efficiency"]
+
+# define the threshold below which a point is reported as not scaling
+#
+MIN_EFFICIENCY = 0.7
+
+# define the largest recording gen_edf reads back to check it, in bytes
+# of samples held as doubles: longer recordings are only written
+#
+MAX_CHECK_BYTES = 1.0e9
+
+#------------------------------------------------------------------------------
+#
+# functions
+#
+#------------------------------------------------------------------------------
+
+# function: parse_list
+#
+# splits a comma-separated list and converts each item
+#
+def parse_list(str_a, conv_a=int):
+    return [conv_a(x) for x in str_a.split(",") if x != ""]
+
+# function: parse_duration
+#
+# converts a duration such as 90, 90s, 10m, 1h or 1d to seconds
+#
+def parse_duration(str_a):
+    scale = {"s": 1, "m": 60, "h": 3600, "d": 86400}
+    if str_a[-1] in scale:
+        return int(float(str_a[:-1]) * scale[str_a[-1]])
+    return int(float(str_a))
+
+# function: get_edf
+#
+# returns the name of a synthetic recording, generating it first if it
+# isn't in the work directory
+#
+def get_edf(args_a, chans_a, secs_a):
+
+    edf_dir = os.path.join(args_a.workdir, "edf")
+    os.makedirs(edf_dir, exist_ok=True)
+    fname = os.path.join(edf_dir, "c%d_r%g_d%d_s%d.edf" %
+                         (chans_a, args_a.rate, secs_a, args_a.seed))
+    if os.path.exists(fname):
+        return fname
+
+    print("generating %s..." % fname, flush=True)
+    cmd = [args_a.gen_edf, "-channels", str(chans_a), "-rate",
+           str(args_a.rate), "-duration", str(secs_a), "-seed",
+           str(args_a.seed)]
+    if 8.0 * chans_a * args_a.rate * secs_a > MAX_CHECK_BYTES:
+        cmd += ["-check", "no"]
+    cmd.append(fname + ".tmp")
+    if subprocess.run(cmd, stdout=subprocess.DEVNULL).returncode != 0:
+        sys.exit("**> scale_mplpc: error running %s" % " ".join(cmd))
+    os.rename(fname + ".tmp", fname)
+    return fname
+
+# function: write_params
+#
+# writes a parameter file: the base file with some values replaced (or
+# added, if the base file doesn't set them)
+#
+def write_params(fname_a, base_a, values_a):
+
+    lines = []
+    seen = set()
+    for line in base_a:
+        name = line.split("=", 1)[0].strip()
+        if (not line.startswith("#")) and ("=" in line) and \
+           (name in values_a):
+            lines.append("%s = %s\n" % (name, values_a[name]))
+            seen.add(name)
+        else:
+            lines.append(line)
+    for name in values_a:
+        if name not in seen:
+            lines.append("%s = %s\n" % (name, values_a[name]))
+    with open(fname_a, "w") as fp:
+        fp.writelines(lines)
+
+# function: run_once
+#
+# runs run_mplpc once and returns its resource usage. the child is
+# reaped with wait4 so its usage is measured on its own.
+#
+def run_once(args_a, pfile_a, edf_a, threads_a, prof_a, log_a):
+
+    cmd = [args_a.run_mplpc, "-parameters", pfile_a, "-threads",
+           str(threads_a), "-profile", prof_a, edf_a]
+    t0 = time.perf_counter()
+    proc = subprocess.Popen(cmd, stdout=log_a, stderr=subprocess.STDOUT)
+    _, status, ru = os.wait4(proc.pid, 0)
+    wall = time.perf_counter() - t0
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    if proc.returncode != 0:
+        sys.exit("**> scale_mplpc: run_mplpc failed (see %s)" % log_a.name)
+
+    # pick up the stage times from the profile
+    #
+    with open(prof_a) as fp:
+        prof = json.load(fp)["total"]
+    if prof["channels"] == 0:
+        sys.exit("**> scale_mplpc: run_mplpc processed no channels (see %s)"
+                 % log_a.name)
+    stages = prof["stages"]
+    analysis = sum(stages[s]["secs"] for s in
+                   ["preemphasis", "window", "autocor", "lpc", "impres",
+                    "search"])
+    return {"wall_secs": wall,
+            "cpu_secs": ru.ru_utime + ru.ru_stime,
+            "peak_rss_mb": ru.ru_maxrss / 1024.0,
+            "minor_faults": ru.ru_minflt,
+            "major_faults": ru.ru_majflt,
+            "vol_ctx_switches": ru.ru_nvcsw,
+            "invol_ctx_switches": ru.ru_nivcsw,
+            "samples": prof["samples"],
+            "read_secs": stages["read"]["secs"] + stages["select"]["secs"] +
+            stages["montage"]["secs"],
+            "write_secs": stages["write"]["secs"],
+            "analysis_secs": analysis}
+
+# function: measure
+#
+# measures one point of the sweep: the run with the median wall time is
+# kept, along with the range of wall times
+#
+def measure(args_a, base_a, point_a, log_a):
+
+    edf = get_edf(args_a, point_a["channels"], point_a["duration_secs"])
+    odir = os.path.join(args_a.workdir, "out")
+    os.makedirs(odir, exist_ok=True)
+    pfile = os.path.join(args_a.workdir, "params.txt")
+    prof = os.path.join(args_a.workdir, "profile.json")
+    write_params(pfile, base_a,
+                 {"num_threads": point_a["threads"],
+                  "num_pulses": point_a["num_pulses"],
+                  "lp_order": point_a["lp_order"],
+                  "stream_records": point_a["stream_records"],
+                  "simd_mode": point_a["simd_mode"],
+                  "pulse_search": point_a["pulse_search"],
+                  "output_directory": odir})
+
+    runs = []
+    for i in range(args_a.repeat):
+        runs.append(run_once(args_a, pfile, edf, point_a["threads"], prof,
+                             log_a))
+        shutil.rmtree(odir, ignore_errors=True)
+        os.makedirs(odir, exist_ok=True)
+    runs.sort(key=lambda r: r["wall_secs"])
+    result = dict(runs[len(runs) // 2])
+    result["wall_secs_min"] = runs[0]["wall_secs"]
+    result["wall_secs_max"] = runs[-1]["wall_secs"]
+    result["cpu_util"] = result["cpu_secs"] / result["wall_secs"]
+    result["samples_per_sec"] = result["samples"] / result["wall_secs"]
+    return result
+
+# function: make_points
+#
+# builds the list of points: each sweep varies one thing and holds the
+# rest at a fixed value. points shared by several sweeps are run once.
+#
+def make_points(args_a):
+
+    threads = parse_list(args_a.threads)
+    chans = parse_list(args_a.channels)
+    durs = parse_list(args_a.durations, parse_duration)
+    pulses = parse_list(args_a.pulses)
+    orders = parse_list(args_a.orders)
+    reads = parse_list(args_a.reads)
+    simds = parse_list(args_a.simd, str)
+    searches = parse_list(args_a.search, str)
+
+    # define the fixed values
+    #
+    t_fix = max(threads)
+    c_fix = max(chans)
+    d_fix = durs[0]
+    p_fix = pulses[0]
+    o_fix = orders[0]
+    e_fix = (reads[0], simds[0], searches[0])
+
+    sweeps = []
+    for t in threads:
+        sweeps.append(("strong", t, c_fix, d_fix, p_fix, o_fix, e_fix))
+        sweeps.append(("weak", t, min(chans) * t // min(threads), d_fix,
+                       p_fix, o_fix, e_fix))
+    for c in chans:
+        sweeps.append(("channels", t_fix, c, d_fix, p_fix, o_fix, e_fix))
+    for d in durs:
+        sweeps.append(("duration", t_fix, c_fix, d, p_fix, o_fix, e_fix))
+    for p in pulses:
+        for o in orders:
+            sweeps.append(("model", t_fix, c_fix, d_fix, p, o, e_fix))
+
+    # the engine settings are varied one at a time
+    #
+    for r in reads:
+        sweeps.append(("reads", t_fix, c_fix, d_fix, p_fix, o_fix,
+                       (r, e_fix[1], e_fix[2])))
+    for m in simds:
+        sweeps.append(("simd", t_fix, c_fix, d_fix, p_fix, o_fix,
+                       (e_fix[0], m, e_fix[2])))
+    for s in searches:
+        sweeps.append(("search", t_fix, c_fix, d_fix, p_fix, o_fix,
+                       (e_fix[0], e_fix[1], s)))
+
+    # merge the duplicates, keeping the order
+    #
+    points = {}
+    for (name, t, c, d, p, o, e) in sweeps:
+        key = (t, c, d, p, o, e)
+        if key not in points:
+            points[key] = {"sweeps": [], "threads": t, "channels": c,
+                           "duration_secs": d, "rate": args_a.rate,
+                           "num_pulses": p, "lp_order": o,
+                           "stream_records": e[0], "simd_mode": e[1],
+                           "pulse_search": e[2]}
+        if name not in points[key]["sweeps"]:
+            points[key]["sweeps"].append(name)
+    return list(points.values())
+
+# function: compute_scaling
+#
+# computes the scaling efficiency of the strong and weak sweeps:
+#  strong: the same work on more threads, eff = t1 * T1 / (tN * TN)
+#  weak: work proportional to the threads, eff = t1 / tN
+#
+def compute_scaling(points_a):
+
+    scaling = {}
+    for name in ["strong", "weak"]:
+        pts = sorted([p for p in points_a if name in p["sweeps"]],
+                     key=lambda p: p["threads"])
+        if not pts:
+            continue
+        ref = pts[0]
+        curve = []
+        for p in pts:
+            if name == "strong":
+                eff = (ref["wall_secs"] * ref["threads"]) / \
+                    (p["wall_secs"] * p["threads"])
+            else:
+                eff = ref["wall_secs"] / p["wall_secs"]
+            speedup = ref["wall_secs"] / p["wall_secs"]
+            if name == "weak":
+                speedup *= p["channels"] / float(ref["channels"])
+            curve.append({"threads": p["threads"],
+                          "channels": p["channels"],
+                          "speedup": speedup, "efficiency": eff})
+            p.setdefault("efficiency", {})[name] = eff
+        scaling[name] = curve
+    return scaling
+
+# function: diagnose
+#
+# returns hints at what limits the scaling, from how the point where the
+# efficiency drops differs from the single-thread point. these are only
+# heuristics: they tell you where to look, not what is wrong.
+#
+def diagnose(points_a, scaling_a):
+
+    hints = []
+    pts = sorted([p for p in points_a if "strong" in p["sweeps"]],
+                 key=lambda p: p["threads"])
+    curve = scaling_a.get("strong", [])
+    bad = [c for c in curve if c["efficiency"] < MIN_EFFICIENCY]
+    if not bad:
+        if curve:
+            hints.append("strong scaling stays above %.0f%% up to %d "
+                         "threads" % (100 * MIN_EFFICIENCY,
+                                      curve[-1]["threads"]))
+        return hints
+
+    ref = pts[0]
+    p = [x for x in pts if x["threads"] == bad[0]["threads"]][0]
+    hints.append("strong scaling drops below %.0f%% at %d threads "
+                 "(%.0f%%)" % (100 * MIN_EFFICIENCY, p["threads"],
+                               100 * bad[0]["efficiency"]))
+
+    # serial I/O: reading and writing don't shrink with more threads
+    #
+    io = (p["read_secs"] + p["write_secs"]) / p["wall_secs"]
+    if io > 0.3:
+        hints.append("  I/O: read+write take %.0f%% of the wall time - "
+                     "serial I/O limits the speedup" % (100 * io))
+
+    # idle threads: the cpus aren't kept busy
+    #
+    if p["cpu_util"] < 0.7 * p["threads"]:
+        hints.append("  idle: %.1f cpus busy out of %d threads - look for "
+                     "serial stages, locks or too few channels" %
+                     (p["cpu_util"], p["threads"]))
+
+    # memory bandwidth: the cpus are busy but each sample costs more
+    #
+    cpu_ref = ref["cpu_secs"] / ref["samples"]
+    cpu_p = p["cpu_secs"] / p["samples"]
+    if (p["cpu_util"] >= 0.7 * p["threads"]) and (cpu_p > 1.3 * cpu_ref):
+        hints.append("  memory: cpu time per sample grows %.1fx while the "
+                     "cpus stay busy - likely memory bandwidth or cache "
+                     "contention" % (cpu_p / cpu_ref))
+
+    # allocator: page faults and context switches grow with the threads
+    #
+    flt_ref = ref["minor_faults"] / float(ref["samples"])
+    flt_p = p["minor_faults"] / float(p["samples"])
+    if flt_p > 2.0 * flt_ref:
+        hints.append("  allocator: minor page faults per sample grow "
+                     "%.1fx - memory is being mapped and released" %
+                     (flt_p / flt_ref))
+    if p["vol_ctx_switches"] > 10 * max(ref["vol_ctx_switches"], 1):
+        hints.append("  contention: voluntary context switches grow from "
+                     "%d to %d - threads are blocking (locks, allocator, "
+                     "I/O)" % (ref["vol_ctx_switches"],
+                               p["vol_ctx_switches"]))
+    return hints
+
+# function: point_key
+#
+# returns the key used to match points between result files
+#
+def point_key(p_a):
+    return (p_a["threads"], p_a["channels"], p_a["duration_secs"],
+            p_a["rate"], p_a["num_pulses"], p_a["lp_order"],
+            p_a.get("stream_records"), p_a.get("simd_mode"),
+            p_a.get("pulse_search"))
+
+# function: compare
+#
+# prints the change in samples/sec and peak memory from an older result
+#
+def compare(fname_a, points_a):
+
+    with open(fname_a) as fp:
+        old = {point_key(p): p for p in json.load(fp)["points"]}
+    print("comparison with %s:" % fname_a)
+    print("  %7s %8s %8s %6s %5s %10s %10s %8s %8s" %
+          ("threads", "channels", "secs", "pulses", "order", "Msamp/s",
+           "old", "speedup", "rss"))
+    for p in points_a:
+        o = old.get(point_key(p))
+        if o is None:
+            continue
+        print("  %7d %8d %8d %6d %5d %10.3f %10.3f %7.2fx %7.2fx" %
+              (p["threads"], p["channels"], p["duration_secs"],
+               p["num_pulses"], p["lp_order"], p["samples_per_sec"] * 1e-6,
+               o["samples_per_sec"] * 1e-6,
+               p["samples_per_sec"] / o["samples_per_sec"],
+               p["peak_rss_mb"] / o["peak_rss_mb"]))
+
+# function: write_results
+#
+# writes the csv and json files
+#
+def write_results(args_a, points_a, scaling_a, hints_a):
+
+    with open(args_a.out + ".csv", "w", newline="") as fp:
+        writer = csv.DictWriter(fp, fieldnames=CSV_FIELDS,
+                                extrasaction="ignore")
+        writer.writeheader()
+        for p in points_a:
+            row = dict(p)
+            row["sweeps"] = "+".join(p["sweeps"])
+            row["efficiency"] = ";".join("%s=%.3f" % kv for kv in
+                                         sorted(p.get("efficiency",
+                                                      {}).items()))
+            writer.writerow(row)
+
+    # the json file also records where the results came from
+    #
+    rev = subprocess.run(["git", "-C", SCRIPT_DIR, "describe", "--always",
+                          "--dirty"], capture_output=True, text=True)
+    meta = {"date": datetime.datetime.now().isoformat(timespec="seconds"),
+            "host": platform.node(), "cpus": os.cpu_count(),
+            "platform": platform.platform(),
+            "revision": rev.stdout.strip(), "run_mplpc": args_a.run_mplpc,
+            "params": args_a.params, "repeat": args_a.repeat,
+            "seed": args_a.seed}
+    with open(args_a.out + ".json", "w") as fp:
+        json.dump({"meta": meta, "points": points_a, "scaling": scaling_a,
+                   "hints": hints_a}, fp, indent=1)
+        fp.write("\n")
+
+# function: main
+#
+# the main program
+#
+def main(argv):
+
+    # parse the command line
+    #
+    parser = argparse.ArgumentParser(
+        description="end-to-end scaling benchmark for run_mplpc")
+    parser.add_argument("-p", "--params", required=True,
+                        help="base parameter file: num_threads, "
+                        "num_pulses, lp_order, stream_records, simd_mode, "
+                        "pulse_search and output_directory are "
+                        "overridden")
+    parser.add_argument("--preset", choices=sorted(PRESETS),
+                        default="quick", help="default sweep (quick)")
+    parser.add_argument("--threads", help="thread counts, e.g. 1,2,4")
+    parser.add_argument("--channels", help="channel counts, e.g. 8,16")
+    parser.add_argument("--durations", help="durations, e.g. 1m,1h,24h")
+    parser.add_argument("--pulses", help="num_pulses values, e.g. 4,8")
+    parser.add_argument("--orders", help="lp_order values, e.g. 12,16")
+    parser.add_argument("--reads", help="stream_records values, e.g. "
+                        "0,60 (0 reads whole files)")
+    parser.add_argument("--simd", help="simd_mode values, e.g. none,auto")
+    parser.add_argument("--search", help="pulse_search values, e.g. "
+                        "full,incremental")
+    parser.add_argument("--rate", type=float, default=250.0,
+                        help="sample frequency (250)")
+    parser.add_argument("--seed", type=int, default=1,
+                        help="gen_edf seed (1)")
+    parser.add_argument("--repeat", type=int,
+                        help="runs per point; the median is kept")
+    parser.add_argument("--workdir", default="scale_work",
+                        help="generated recordings, output and logs "
+                        "(scale_work)")
+    parser.add_argument("--out", default="scale_results",
+                        help="results prefix: .csv and .json are added "
+                        "(scale_results)")
+    parser.add_argument("--compare", help="a json file from an earlier "
+                        "run to compare against")
+    parser.add_argument("--run-mplpc", dest="run_mplpc",
+                        default=os.path.join(SCRIPT_DIR, "..", "run_mplpc",
+                                             "run_mplpc"))
+    parser.add_argument("--gen-edf", dest="gen_edf",
+                        default=os.path.join(SCRIPT_DIR, "..", "gen_edf",
+                                             "gen_edf"))
+    args = parser.parse_args(argv)
+    args.workdir = os.path.abspath(args.workdir)
+    for name, val in PRESETS[args.preset].items():
+        if getattr(args, name) is None:
+            setattr(args, name, val)
+
+    with open(args.params) as fp:
+        base = fp.readlines()
+    os.makedirs(args.workdir, exist_ok=True)
+
+    # run the points
+    #
+    points = make_points(args)
+    print("%d points, %d runs each" % (len(points), args.repeat))
+    print("  %-30s %7s %8s %8s %6s %5s %-20s %9s %9s %8s %10s" %
+          ("sweeps", "threads", "channels", "secs", "pulses", "order",
+           "engine", "wall", "cpu", "rss(MB)", "Msamp/s"), flush=True)
+    with open(os.path.join(args.workdir, "run_mplpc.log"), "w") as log:
+        for p in points:
+            p.update(measure(args, base, p, log))
+            engine = "%d/%s/%s" % (p["stream_records"], p["simd_mode"],
+                                   p["pulse_search"])
+            print("  %-30s %7d %8d %8d %6d %5d %-20s %9.3f %9.3f %8.1f "
+                  "%10.3f" %
+                  ("+".join(p["sweeps"]), p["threads"], p["channels"],
+                   p["duration_secs"], p["num_pulses"], p["lp_order"],
+                   engine, p["wall_secs"], p["cpu_secs"], p["peak_rss_mb"],
+                   p["samples_per_sec"] * 1e-6), flush=True)
+
+    # report the scaling
+    #
+    scaling = compute_scaling(points)
+    for name, curve in sorted(scaling.items()):
+        print("%s scaling:" % name)
+        for c in curve:
+            print("  threads = %3d, channels = %4d, speedup = %6.2f, "
+                  "efficiency = %5.1f%%" % (c["threads"], c["channels"],
+                                            c["speedup"],
+                                            100 * c["efficiency"]))
+    hints = diagnose(points, scaling)
+    for h in hints:
+        print(h)
+
+    # write the results
+    #
+    write_results(args, points, scaling, hints)
+    print("wrote %s.csv and %s.json" % (args.out, args.out))
+    if args.compare:
+        compare(args.compare, points)
+
+# begin gracefully
+#
+if __name__ == "__main__":
+    main(sys.argv[1:])
+
+#
+# end of file